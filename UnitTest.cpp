@@ -1,6 +1,31 @@
 #include <UnitTest++/UnitTest++.h>
 #include "interface.h"
+#include "simd.h"
+#include "connection.h"
+#include "userbase.h"
+#include "crypto.h"
+#include "log.h"
+#include "metrics.h"
+#include "decoder.h"
+#include "reduce.h"
+#include "parallel.h"
+#include "timeout.h"
+#include "session.h"
+#include "frame.h"
+#include "ticket.h"
+#include "authbatch.h"
+#include "admission.h"
+#include "handoff.h"
+#include "uring.h"
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <climits>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
 #include <string>
+#include <thread>
 
 SUITE(HelpTest) {
     
@@ -158,12 +183,174 @@ SUITE(OptionalParametersTest) {
     }
 
     
+    TEST(DefaultMode) {
+        UserInterface iface;
+        const char* argv[] = {"test", "-b", "db", "-j", "log", "-p", "9090", nullptr};
+        int argc = sizeof(argv) / sizeof(argv[0]) - 1;
+        CHECK(iface.Parser(argc, argv));
+        CHECK_EQUAL("threads", iface.getParams().Mode);
+    }
+
+    
+    TEST(EpollMode) {
+        UserInterface iface;
+        const char* argv[] = {"test", "-b", "db", "-j", "log", "-p", "9090", "--mode", "epoll", nullptr};
+        int argc = sizeof(argv) / sizeof(argv[0]) - 1;
+        CHECK(iface.Parser(argc, argv));
+        CHECK_EQUAL("epoll", iface.getParams().Mode);
+    }
+
+    
+    TEST(UringMode) {
+        UserInterface iface;
+        const char* argv[] = {"test", "-b", "db", "-j", "log", "-p", "9090", "-m", "uring", nullptr};
+        int argc = sizeof(argv) / sizeof(argv[0]) - 1;
+        CHECK(iface.Parser(argc, argv));
+        CHECK_EQUAL("uring", iface.getParams().Mode);
+    }
+
+    
+    TEST(InvalidMode) {
+        UserInterface iface;
+        const char* argv[] = {"test", "-b", "db", "-j", "log", "-p", "9090", "-m", "select", nullptr};
+        int argc = sizeof(argv) / sizeof(argv[0]) - 1;
+        CHECK_THROW(iface.Parser(argc, argv), std::exception);
+    }
+
+    
+    TEST(BufferParameter) {
+        UserInterface iface;
+        const char* argv[] = {"test", "-b", "db", "-j", "log", "-p", "9090", "--buffer", "1048576", nullptr};
+        int argc = sizeof(argv) / sizeof(argv[0]) - 1;
+        CHECK(iface.Parser(argc, argv));
+        CHECK_EQUAL(1048576, iface.getParams().RecvBuffer);
+    }
+
+    
+    TEST(TooSmallBuffer) {
+        UserInterface iface;
+        const char* argv[] = {"test", "-b", "db", "-j", "log", "-p", "9090", "--buffer", "3", nullptr};
+        int argc = sizeof(argv) / sizeof(argv[0]) - 1;
+        CHECK_THROW(iface.Parser(argc, argv), std::exception);
+    }
+
+    
+    TEST(BatchParameter) {
+        UserInterface iface;
+        const char* argv[] = {"test", "-b", "db", "-j", "log", "-p", "9090", "--batch", "1", nullptr};
+        int argc = sizeof(argv) / sizeof(argv[0]) - 1;
+        CHECK(iface.Parser(argc, argv));
+        CHECK_EQUAL(1, iface.getParams().ResultBatch);
+    }
+
+    
+    TEST(LogOverflowParameter) {
+        UserInterface iface;
+        const char* argv[] = {"test", "-b", "db", "-j", "log", "-p", "9090", "--log-overflow", "block", nullptr};
+        int argc = sizeof(argv) / sizeof(argv[0]) - 1;
+        CHECK(iface.Parser(argc, argv));
+        CHECK_EQUAL("block", iface.getParams().LogOverflow);
+        CHECK_EQUAL(100, iface.getParams().LogFlushMs);
+    }
+
+    
+    TEST(InvalidLogOverflow) {
+        UserInterface iface;
+        const char* argv[] = {"test", "-b", "db", "-j", "log", "-p", "9090", "--log-overflow", "wait", nullptr};
+        int argc = sizeof(argv) / sizeof(argv[0]) - 1;
+        CHECK_THROW(iface.Parser(argc, argv), std::exception);
+    }
+
+    
+    TEST(InvalidStatsPort) {
+        UserInterface iface;
+        const char* argv[] = {"test", "-b", "db", "-j", "log", "-p", "9090", "--stats-port", "70000", nullptr};
+        int argc = sizeof(argv) / sizeof(argv[0]) - 1;
+        CHECK_THROW(iface.Parser(argc, argv), std::exception);
+    }
+
+    
+    TEST(ListenersParameters) {
+        UserInterface iface;
+        const char* argv[] = {"test", "-b", "db", "-j", "log", "-p", "9090", "--listeners", "4", "--pin", "--backlog", "1024", nullptr};
+        int argc = sizeof(argv) / sizeof(argv[0]) - 1;
+        CHECK(iface.Parser(argc, argv));
+        CHECK_EQUAL(4, iface.getParams().Listeners);
+        CHECK(iface.getParams().Pin);
+        CHECK_EQUAL(1024, iface.getParams().Backlog);
+    }
+
+    
+    TEST(InvalidListeners) {
+        UserInterface iface;
+        const char* argv[] = {"test", "-b", "db", "-j", "log", "-p", "9090", "--listeners", "0", nullptr};
+        int argc = sizeof(argv) / sizeof(argv[0]) - 1;
+        CHECK_THROW(iface.Parser(argc, argv), std::exception);
+    }
+
+    
     TEST(DefaultLogFile) {
         UserInterface iface;
         const char* argv[] = {"test", "-b", "db", "-j", "log", "-p", "9090", nullptr};
         int argc = sizeof(argv) / sizeof(argv[0]) - 1;
         CHECK(iface.Parser(argc, argv));
         CHECK_EQUAL("journal.txt", iface.getParams().logFile);
+        CHECK_EQUAL(1, iface.getParams().Listeners);
+        CHECK(!iface.getParams().Pin);
+        CHECK_EQUAL(128, iface.getParams().Backlog);
+        CHECK_EQUAL(0, iface.getParams().ReduceThreads);
+        CHECK_EQUAL(1048576, iface.getParams().ParallelThreshold);
+        CHECK_EQUAL(10000, iface.getParams().LoginTimeout);
+        CHECK_EQUAL(30000, iface.getParams().IdleTimeout);
+        CHECK_EQUAL(300, iface.getParams().TicketTtl);
+        CHECK_EQUAL(10000, iface.getParams().MaxSessions);
+        CHECK_EQUAL(0, iface.getParams().MaxVectors);
+    }
+
+    
+    TEST(InvalidFailBurst) {
+        UserInterface iface;
+        const char* argv[] = {"test", "-b", "db", "-j", "log", "-p", "9090", "--fail-burst", "0", nullptr};
+        int argc = sizeof(argv) / sizeof(argv[0]) - 1;
+        CHECK_THROW(iface.Parser(argc, argv), std::exception);
+    }
+
+    
+    TEST(InvalidHandoffPath) {
+        UserInterface iface;
+        std::string path(200, 'h');
+        const char* argv[] = {"test", "-b", "db", "-j", "log", "-p", "9090", "--handoff", path.c_str(), nullptr};
+        int argc = sizeof(argv) / sizeof(argv[0]) - 1;
+        CHECK_THROW(iface.Parser(argc, argv), std::exception);
+    }
+
+    TEST(InvalidParallelThreshold) {
+        UserInterface iface;
+        const char* argv[] = {"test", "-b", "db", "-j", "log", "-p", "9090", "--parallel-threshold", "-1", nullptr};
+        int argc = sizeof(argv) / sizeof(argv[0]) - 1;
+        CHECK_THROW(iface.Parser(argc, argv), std::exception);
+    }
+
+    
+    TEST(InvalidTimeout) {
+        UserInterface iface;
+        const char* argv[] = {"test", "-b", "db", "-j", "log", "-p", "9090", "--idle-timeout", "-5", nullptr};
+        int argc = sizeof(argv) / sizeof(argv[0]) - 1;
+        CHECK_THROW(iface.Parser(argc, argv), std::exception);
+    }
+
+    
+    TEST(SharedListeningSockets) {
+        Params p;
+        p.logFile = "test_journal.txt";
+        p.Address = "127.0.0.1";
+        p.Port = 39217;
+        p.Backlog = 16;
+        int first = Connection::listenSocket(&p, true);
+        int second = Connection::listenSocket(&p, true);
+        CHECK(first != second);
+        close(first);
+        close(second);
     }
 }
 
@@ -259,6 +446,1214 @@ SUITE(SpecialValuesTest) {
     }
 }
 
+SUITE(SumSquaresTest) {
+    
+    
+    TEST(EmptyArray) {
+        CHECK_EQUAL(0, sumSquares(nullptr, 0));
+        CHECK_EQUAL(0, sumSquaresScalar(nullptr, 0));
+    }
+
+    
+    TEST(SmallVector) {
+        const int32_t data[] = {1, 2, 3, -4};
+        CHECK_EQUAL(30, sumSquaresScalar(data, 4));
+        CHECK_EQUAL(30, sumSquares(data, 4));
+    }
+
+    
+    TEST(AllLevelsMatchScalar) {
+        std::vector<int32_t> data(1000);
+        uint32_t seed = 12345;
+        for (auto& x : data) {
+            seed = seed * 1103515245 + 12345;
+            x = static_cast<int32_t>(seed);
+        }
+        SimdLevel best = detectSimdLevel();
+        for (int level = SIMD_SCALAR; level <= best; level++) {
+            // Все длины от 0 до 100 проверяют обработку хвостов, смещение — невыровненные загрузки
+            for (size_t n = 0; n <= 100; n++) {
+                CHECK_EQUAL(sumSquaresScalar(data.data() + 1, n), sumSquaresAt(static_cast<SimdLevel>(level), data.data() + 1, n));
+            }
+            CHECK_EQUAL(sumSquaresScalar(data.data(), data.size()), sumSquaresAt(static_cast<SimdLevel>(level), data.data(), data.size()));
+        }
+    }
+
+    
+    TEST(WrapAround) {
+        // 46341^2 = 2147488281 > INT32_MAX: результат переполняется как int32_t
+        const int32_t data[] = {46341};
+        CHECK_EQUAL(static_cast<int32_t>(2147488281u), sumSquares(data, 1));
+        // (-2^31)^2 = 2^62 ≡ 0 (mod 2^32), (2^31 - 1)^2 ≡ 1 (mod 2^32)
+        std::vector<int32_t> extremes(37, INT_MIN);
+        extremes.push_back(INT_MAX);
+        SimdLevel best = detectSimdLevel();
+        for (int level = SIMD_SCALAR; level <= best; level++) {
+            CHECK_EQUAL(1, sumSquaresAt(static_cast<SimdLevel>(level), extremes.data(), extremes.size()));
+        }
+    }
+
+    
+    TEST(SumOverflowAcrossElements) {
+        // 65536 элементов по 65535: 65536 * 65535^2 = 2^48 - 2^33 + 2^16 ≡ 65536 (mod 2^32)
+        std::vector<int32_t> data(65536, 65535);
+        CHECK_EQUAL(65536, sumSquaresScalar(data.data(), data.size()));
+        CHECK_EQUAL(65536, sumSquares(data.data(), data.size()));
+    }
+
+    
+    TEST(WideLevelsMatchScalar) {
+        // Точная сумма: (2^31)^2 * 37 + (2^31 - 1)^2 не помещается в 64 бита
+        std::vector<int32_t> data(101, INT_MIN);
+        data.push_back(INT_MAX);
+        unsigned __int128 square = static_cast<unsigned __int128>(1) << 62;
+        unsigned __int128 last = static_cast<unsigned __int128>(INT_MAX) * INT_MAX;
+        CHECK(sumSquaresWideScalar(data.data(), data.size()) == square * 101 + last);
+        uint32_t seed = 777;
+        for (size_t i = 0; i < 50; i++) {
+            seed = seed * 1103515245 + 12345;
+            data[i] = static_cast<int32_t>(seed);
+        }
+        SimdLevel best = detectSimdLevel();
+        for (int level = SIMD_SCALAR; level <= best; level++) {
+            for (size_t n = 0; n <= data.size() - 1; n++) {
+                CHECK(sumSquaresWideScalar(data.data() + 1, n) == sumSquaresWideAt(static_cast<SimdLevel>(level), data.data() + 1, n));
+            }
+        }
+    }
+
+    
+    TEST(DecoderAccumulationModes) {
+        // Два вектора {INT32_MAX, INT32_MAX} в каждом режиме с насыщением
+        auto run = [](uint32_t mode, std::string& out) {
+            std::vector<uint32_t> words = {2 | BATCH_EXTENDED, mode};
+            for (int i = 0; i < 2; i++) {
+                words.insert(words.end(), {2, INT_MAX, INT_MAX});
+            }
+            VectorDecoder decoder;
+            const char* data = reinterpret_cast<const char*>(words.data());
+            size_t len = words.size() * sizeof(uint32_t);
+            size_t pos = 0;
+            while (!decoder.done() && !decoder.failed() && pos < len) {
+                pos += decoder.feed(data + pos, len - pos, out);
+            }
+            return decoder;
+        };
+        int64_t exact = 2 * static_cast<int64_t>(INT_MAX) * INT_MAX;
+        std::string out;
+        VectorDecoder d = run(ACC_INT64, out);
+        CHECK(d.done());
+        CHECK_EQUAL(8u, d.resultSize());
+        CHECK_EQUAL(16u, out.size());
+        CHECK_EQUAL(exact, *reinterpret_cast<const int64_t*>(out.data() + 8));
+        out.clear();
+        d = run(ACC_UINT64, out);
+        CHECK_EQUAL(16u, out.size());
+        CHECK_EQUAL(static_cast<uint64_t>(exact), *reinterpret_cast<const uint64_t*>(out.data()));
+        out.clear();
+        d = run(ACC_SAT32, out);
+        CHECK_EQUAL(4u, d.resultSize());
+        CHECK_EQUAL(8u, out.size());
+        CHECK_EQUAL(INT_MAX, *reinterpret_cast<const int32_t*>(out.data()));
+        out.clear();
+        d = run(7, out);
+        CHECK(d.failed());
+        CHECK_EQUAL(7u, d.mode());
+        CHECK(out.empty());
+    }
+}
+
+SUITE(ReduceTest) {
+    
+    
+    // Результат свёртки в формате ответа сервера
+    std::string reduce(SimdLevel level, Operation op, ElementType type, Accumulation acc, const char* data, size_t n) {
+        Reduction r = reduceInit(op, type);
+        reduceKernelAt(level, op, type)(data, n, r);
+        std::string out;
+        reduceFinish(op, type, acc, r, out);
+        return out;
+    }
+
+    
+    TEST(KnownValues) {
+        const int32_t ints[] = {1, 2, 3, -4};
+        const char* data = reinterpret_cast<const char*>(ints);
+        int32_t v;
+        memcpy(&v, reduce(SIMD_SCALAR, OP_SUM, ELEM_INT32, ACC_WRAP32, data, 4).data(), sizeof(v));
+        CHECK_EQUAL(2, v);
+        memcpy(&v, reduce(SIMD_SCALAR, OP_DOT, ELEM_INT32, ACC_WRAP32, data, 4).data(), sizeof(v));
+        CHECK_EQUAL(-10, v);
+        memcpy(&v, reduce(SIMD_SCALAR, OP_MIN, ELEM_INT32, ACC_WRAP32, data, 4).data(), sizeof(v));
+        CHECK_EQUAL(-4, v);
+        memcpy(&v, reduce(SIMD_SCALAR, OP_MAX, ELEM_INT32, ACC_WRAP32, data, 0).data(), sizeof(v));
+        CHECK_EQUAL(INT_MIN, v);
+        memcpy(&v, reduce(SIMD_SCALAR, OP_L1, ELEM_INT32, ACC_WRAP32, data, 4).data(), sizeof(v));
+        CHECK_EQUAL(10, v);
+        const double reals[] = {3.0, -4.0};
+        std::string l2 = reduce(SIMD_SCALAR, OP_L2, ELEM_DOUBLE, ACC_WRAP32, reinterpret_cast<const char*>(reals), 2);
+        double d;
+        CHECK_EQUAL(sizeof(d), l2.size());
+        memcpy(&d, l2.data(), sizeof(d));
+        CHECK_CLOSE(5.0, d, 1e-12);
+        // Отрицательная сумма в режиме uint64 насыщается до нуля
+        uint64_t u;
+        memcpy(&u, reduce(SIMD_SCALAR, OP_SUM, ELEM_INT32, ACC_UINT64, data + 8, 2).data(), sizeof(u));
+        CHECK_EQUAL(0u, u);
+    }
+
+    
+    TEST(AllLevelsMatchScalar) {
+        // Целые — во всём диапазоне, вещественные — целые числа, чьи суммы в double точны
+        std::vector<char> data(8 * 300);
+        uint32_t seed = 4242;
+        for (size_t i = 0; i < data.size(); i += 8) {
+            seed = seed * 1103515245 + 12345;
+            int64_t wide = static_cast<int64_t>(seed) << 32 | seed;
+            memcpy(&data[i], &wide, sizeof(wide));
+        }
+        std::vector<char> reals(data.size());
+        for (size_t i = 0; i < 300; i++) {
+            float f = static_cast<float>(static_cast<int>(i * 37 % 2001) - 1000);
+            memcpy(&reals[i * sizeof(float)], &f, sizeof(f));
+        }
+        std::vector<char> doubles(data.size());
+        for (size_t i = 0; i < 300; i++) {
+            double x = static_cast<double>(static_cast<int>(i * 53 % 2001) - 1000);
+            memcpy(&doubles[i * sizeof(double)], &x, sizeof(x));
+        }
+        SimdLevel best = detectSimdLevel();
+        for (int t = ELEM_INT32; t <= ELEM_DOUBLE; t++) {
+            ElementType type = static_cast<ElementType>(t);
+            const char* base = type == ELEM_FLOAT ? reals.data() : type == ELEM_DOUBLE ? doubles.data() : data.data();
+            for (int o = OP_SUM_SQUARES; o <= OP_L2; o++) {
+                Operation op = static_cast<Operation>(o);
+                Accumulation acc = type == ELEM_INT32 ? ACC_INT64 : ACC_WRAP32;
+                for (int level = SIMD_SSE2; level <= best; level++) {
+                    // Смещение на 4 байта проверяет невыровненные загрузки, длины — хвосты
+                    for (size_t n = 0; n <= 130; n += 2) {
+                        std::string expected = reduce(SIMD_SCALAR, op, type, acc, base + 4, n);
+                        std::string actual = reduce(static_cast<SimdLevel>(level), op, type, acc, base + 4, n);
+                        if (type == ELEM_INT64 && op == OP_L2) {
+                            // Квадраты int64_t в double округляются, сумма зависит от порядка
+                            double a, b;
+                            memcpy(&a, expected.data(), sizeof(a));
+                            memcpy(&b, actual.data(), sizeof(b));
+                            CHECK_CLOSE(a, b, a * 1e-12);
+                        } else {
+                            CHECK(expected == actual);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    
+    TEST(DecoderDotOverPartialElements) {
+        // Пакет из двух векторов double по 3 пары, подаваемый частями по 5 байт
+        std::string stream;
+        uint32_t header[2] = {2 | BATCH_EXTENDED, MODE_WORD(ACC_WRAP32, OP_DOT, ELEM_DOUBLE)};
+        stream.append(reinterpret_cast<const char*>(header), sizeof(header));
+        for (int v = 0; v < 2; v++) {
+            uint32_t pairs = 3;
+            stream.append(reinterpret_cast<const char*>(&pairs), sizeof(pairs));
+            for (int i = 0; i < 6; i++) {
+                double x = v + i;
+                stream.append(reinterpret_cast<const char*>(&x), sizeof(x));
+            }
+        }
+        VectorDecoder decoder;
+        std::string out, pending;
+        for (size_t pos = 0; pos < stream.size() && !decoder.done(); pos += 5) {
+            pending += stream.substr(pos, 5);
+            size_t used;
+            while ((used = decoder.feed(pending.data(), pending.size(), out)) > 0) {
+                pending.erase(0, used);
+            }
+        }
+        CHECK(decoder.done());
+        CHECK_EQUAL(8u, decoder.resultSize());
+        CHECK_EQUAL(16u, out.size());
+        double first, second;
+        memcpy(&first, out.data(), sizeof(first));
+        memcpy(&second, out.data() + 8, sizeof(second));
+        CHECK_EQUAL(0 * 1 + 2 * 3 + 4 * 5, first);
+        CHECK_EQUAL(1 * 2 + 3 * 4 + 5 * 6, second);
+    }
+
+    
+    TEST(DecoderRejectsInvalidModes) {
+        const uint32_t modes[] = {
+            MODE_WORD(ACC_INT64, OP_SUM, ELEM_FLOAT),   // Насыщение только для int32_t
+            MODE_WORD(ACC_WRAP32, OP_L2 + 1, ELEM_INT32),
+            MODE_WORD(ACC_WRAP32, OP_SUM, ELEM_DOUBLE + 1),
+            MODE_WORD(ACC_WRAP32, OP_SUM, ELEM_INT32) | 1u << 24
+        };
+        for (uint32_t mode : modes) {
+            uint32_t words[2] = {1 | BATCH_EXTENDED, mode};
+            VectorDecoder decoder;
+            std::string out;
+            decoder.feed(reinterpret_cast<const char*>(words), sizeof(words), out);
+            CHECK(decoder.failed());
+        }
+    }
+}
+
+SUITE(ParallelTest) {
+    
+    
+    // Свёртка пакета из одного вектора, подаваемого порциями по 7777 байт
+    std::string decode(const std::string& stream) {
+        VectorDecoder decoder;
+        std::string out, pending;
+        for (size_t pos = 0; pos < stream.size(); pos += 7777) {
+            pending += stream.substr(pos, 7777);
+            size_t used;
+            while ((used = decoder.feed(pending.data(), pending.size(), out)) > 0) {
+                pending.erase(0, used);
+            }
+        }
+        return decoder.done() ? out : std::string();
+    }
+
+    
+    TEST(MatchesSequential) {
+        // Вектор на несколько частей с неполной последней
+        uint32_t size = 3 * PARALLEL_CHUNK / sizeof(int32_t) + 123;
+        std::vector<int32_t> data(size);
+        for (uint32_t i = 0; i < size; i++) {
+            data[i] = static_cast<int32_t>(i * 2654435761u);
+        }
+        std::string legacy;
+        uint32_t count = 1;
+        legacy.append(reinterpret_cast<const char*>(&count), sizeof(count));
+        legacy.append(reinterpret_cast<const char*>(&size), sizeof(size));
+        legacy.append(reinterpret_cast<const char*>(data.data()), size * sizeof(int32_t));
+
+        // Скалярное произведение double: 2 * pairs элементов с целыми значениями
+        uint32_t pairs = PARALLEL_CHUNK / sizeof(double) + 5;
+        std::string dot;
+        uint32_t header[3] = {1 | BATCH_EXTENDED, MODE_WORD(ACC_WRAP32, OP_DOT, ELEM_DOUBLE), pairs};
+        dot.append(reinterpret_cast<const char*>(header), sizeof(header));
+        for (uint32_t i = 0; i < 2 * pairs; i++) {
+            double x = static_cast<int>(i % 101) - 50;
+            dot.append(reinterpret_cast<const char*>(&x), sizeof(x));
+        }
+
+        startParallelReduce(0, 0);
+        std::string sequentialLegacy = decode(legacy);
+        std::string sequentialDot = decode(dot);
+        CHECK_EQUAL(8u, sequentialDot.size());
+        startParallelReduce(3, 1000);
+        CHECK(parallelThreshold() == 1000);
+        CHECK(decode(legacy) == sequentialLegacy);
+        CHECK(decode(dot) == sequentialDot);
+        int32_t expected = sumSquaresScalar(data.data(), size);
+        CHECK_EQUAL(0, memcmp(&expected, sequentialLegacy.data(), sizeof(expected)));
+
+        // Разрыв соединения посреди вектора: незавершённые задачи дожидаются разрушения
+        {
+            VectorDecoder decoder;
+            std::string out;
+            decoder.feed(legacy.data(), legacy.size() / 2 / sizeof(int32_t) * sizeof(int32_t), out);
+            CHECK(out.empty());
+        }
+        startParallelReduce(0, 0);
+        CHECK(parallelThreshold() == 0);
+    }
+}
+
+SUITE(TimeoutTest) {
+    
+    
+    TEST(WheelFiresAfterDeadline) {
+        TimerWheel wheel(0);
+        TimerNode soon, cancelled, far;
+        std::vector<TimerNode*> due;
+        CHECK_EQUAL(-1, wheel.timeout(0));
+        wheel.schedule(&soon, 250);
+        wheel.schedule(&cancelled, 1000);
+        // Больше одного оборота колеса: узел переживает проходы по своему делению
+        wheel.schedule(&far, 100000);
+        CHECK_EQUAL(3u, wheel.size());
+        CHECK(wheel.timeout(0) > 0 && wheel.timeout(0) <= TIMER_TICK_MS);
+
+        wheel.expire(200, due);
+        CHECK(due.empty());
+        wheel.expire(250 + TIMER_TICK_MS, due);
+        CHECK(due.size() == 1 && due[0] == &soon);
+        CHECK(!soon.armed());
+
+        due.clear();
+        wheel.cancel(&cancelled);
+        wheel.cancel(&cancelled);
+        wheel.expire(60000, due);
+        CHECK(due.empty());
+        CHECK(far.armed());
+        wheel.expire(100000 + TIMER_TICK_MS, due);
+        CHECK(due.size() == 1 && due[0] == &far);
+        CHECK_EQUAL(0u, wheel.size());
+    }
+
+    
+    TEST(LimitKeepsEarlierTimer) {
+        TimerWheel wheel(0);
+        TimerNode node;
+        wheel.limit(&node, 5000);
+        wheel.limit(&node, 9000);
+        CHECK(node.when == 5000);
+        wheel.limit(&node, 3000);
+        CHECK(node.when == 3000);
+        wheel.limit(&node, 0);
+        CHECK(!node.armed());
+        CHECK_EQUAL(0u, wheel.size());
+    }
+
+    
+    TEST(DeadlineStages) {
+        Params p;
+        p.LoginTimeout = 1000;
+        p.HashTimeout = 2000;
+        p.HeaderTimeout = 3000;
+        p.VectorTimeout = 0;
+        p.IdleTimeout = 500;
+        CHECK(Deadline::period(&p) == 500);
+
+        Deadline d(&p, 0);
+        CHECK(d.at() == 500);
+        // Данные по байту продлевают простой, но не срок стадии
+        d.touch(400);
+        d.touch(800);
+        CHECK(d.at() == 1000);
+        CHECK(d.message(1000, "логин").find("Тайм-аут (логин)") == 0);
+        d.progress(STAGE_HASH, 0, 900);
+        CHECK(d.at() == 1300);
+        CHECK(d.message(1300, "хеш").find("Тайм-аут простоя (хеш)") == 0);
+        d.touch(1200);
+        d.progress(STAGE_ELEMENTS, 3, 1200);
+        CHECK(d.at() == 1700);
+        p.IdleTimeout = 0;
+        CHECK(d.at() == 0);
+        d.progress(STAGE_HEADER, 4, 1500);
+        CHECK(d.at() == 4500);
+    }
+
+    
+    TEST(SilentClientClosed) {
+        Params p;
+        p.logFile = "test_journal.txt";
+        p.LoginTimeout = 200;
+        p.HashTimeout = p.HeaderTimeout = p.VectorTimeout = p.IdleTimeout = 0;
+        UserRegistry users;
+        int sv[2];
+        CHECK_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+        uint64_t start = monotonicMs();
+        int error = 0;
+        try {
+            Connection::handleClient(sv[0], &p, &users);
+        } catch (const std::system_error& e) {
+            error = e.code().value();
+        }
+        CHECK_EQUAL(ETIMEDOUT, error);
+        CHECK(monotonicMs() - start >= 150);
+        close(sv[1]);
+    }
+
+    
+    TEST(StageDeadlineNotOverrun) {
+        // Период проверки 300 мс не кратен сроку логина 500 мс
+        Params p;
+        p.logFile = "test_journal.txt";
+        p.LoginTimeout = 500;
+        p.HashTimeout = 300;
+        p.HeaderTimeout = p.VectorTimeout = p.IdleTimeout = 0;
+        UserRegistry users;
+        int sv[2];
+        CHECK_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+        uint64_t start = monotonicMs();
+        int error = 0;
+        try {
+            Connection::handleClient(sv[0], &p, &users);
+        } catch (const std::system_error& e) {
+            error = e.code().value();
+        }
+        uint64_t elapsed = monotonicMs() - start;
+        CHECK_EQUAL(ETIMEDOUT, error);
+        CHECK(elapsed >= 450);
+        CHECK(elapsed < 590);
+        close(sv[1]);
+    }
+}
+
+SUITE(UringTest) {
+    
+    
+    TEST(ListenerFailureThrows) {
+        Params p{};
+        p.logFile = "test_journal.txt";
+        p.Address = "127.0.0.1";
+        p.Port = 0;
+        p.Backlog = 16;
+        p.RecvBuffer = 4096;
+        p.ResultBatch = 64;
+        // Слушающий сокет после shutdown отвечает на accept ошибкой EINVAL
+        int s = Connection::listenSocket(&p, false);
+        shutdown(s, SHUT_RDWR);
+        CHECK_THROW(Uring::run(s, &p, nullptr, 1), std::system_error);
+        close(s);
+    }
+}
+
+SUITE(BatchTest) {
+    
+    
+    TEST(FullBatchNotDelayed) {
+        Params p{};
+        p.logFile = "test_journal.txt";
+        p.RecvBuffer = 4096;
+        p.ResultBatch = 2;
+        int l = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        CHECK_EQUAL(0, bind(l, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)));
+        CHECK_EQUAL(0, listen(l, 1));
+        getsockname(l, reinterpret_cast<sockaddr*>(&addr), &len);
+        int c = socket(AF_INET, SOCK_STREAM, 0);
+        CHECK_EQUAL(0, connect(c, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)));
+        int s = accept(l, nullptr, nullptr);
+        std::thread server([&] { datawrite(s, &p); });
+
+        // Пакет заполнен двумя векторами, от третьего пришёл только размер
+        uint32_t words[] = {3, 1, 2, 1, 3, 1};
+        send(c, words, sizeof(words), 0);
+        int32_t results[3] = {};
+        uint64_t start = monotonicMs();
+        CHECK_EQUAL(ssize_t(8), recv(c, results, 8, MSG_WAITALL));
+        CHECK(monotonicMs() - start < 100);
+        uint32_t last = 4;
+        send(c, &last, sizeof(last), 0);
+        CHECK_EQUAL(ssize_t(4), recv(c, results + 2, 4, MSG_WAITALL));
+        server.join();
+        CHECK_EQUAL(4, results[0]);
+        CHECK_EQUAL(9, results[1]);
+        CHECK_EQUAL(16, results[2]);
+        close(s);
+        close(c);
+        close(l);
+    }
+}
+
+SUITE(FrameTest) {
+    
+    
+    // Подача потока сеансу порциями по step байт с переносом остатка, как в реакторе
+    std::string converse(Session& session, const std::string& stream, size_t step) {
+        std::string pending;
+        for (size_t pos = 0; pos < stream.size() && !session.finished(); pos += step) {
+            pending += stream.substr(pos, step);
+            size_t used;
+            while (!pending.empty() && (used = session.onData(pending.data(), pending.size())) > 0) {
+                pending.erase(0, used);
+            }
+        }
+        return session.out;
+    }
+
+    // Разбор ответа сервера: типы кадров и объединённые результаты
+    std::string frames(const std::string& out, std::vector<uint32_t>& types) {
+        std::string results;
+        for (size_t pos = 0; pos + sizeof(FrameHeader) <= out.size();) {
+            FrameHeader h = readFrameHeader(out.data() + pos);
+            types.push_back(h.type);
+            if (h.type == FRAME_RESULTS) {
+                results += out.substr(pos + sizeof(FrameHeader), h.length);
+            }
+            pos += sizeof(FrameHeader) + h.length;
+        }
+        return results;
+    }
+
+    
+    TEST(PipelinedSession) {
+        Params p;
+        p.logFile = "test_journal.txt";
+        UserRegistry users;
+        std::unique_ptr<UserBase> base(new UserBase);
+        base->insert("user", "P@ssW0rd");
+        users.publish(std::move(base));
+
+        // Два вектора пар double: 3 и 1 пара по 16 байт
+        std::string data;
+        uint32_t header[3] = {2 | BATCH_EXTENDED, MODE_WORD(ACC_WRAP32, OP_DOT, ELEM_DOUBLE), 3};
+        data.append(reinterpret_cast<const char*>(header), sizeof(header));
+        for (int i = 0; i < 6; i++) {
+            double x = i + 0.5;
+            data.append(reinterpret_cast<const char*>(&x), sizeof(x));
+        }
+        uint32_t size = 1;
+        data.append(reinterpret_cast<const char*>(&size), sizeof(size));
+        for (int i = 0; i < 2; i++) {
+            double x = -3;
+            data.append(reinterpret_cast<const char*>(&x), sizeof(x));
+        }
+        VectorDecoder decoder;
+        std::string expected;
+        for (size_t pos = 0, used; (used = decoder.feed(data.data() + pos, data.size() - pos, expected)) > 0;) {
+            pos += used;
+        }
+
+        // Логин, хеш и векторы одной передачей; кадры векторов делят элементы
+        std::string hash = auth(SALT, "P@ssW0rd");
+        std::string stream(FRAME_MAGIC, FRAME_MAGIC_SIZE);
+        appendFrame(stream, FRAME_LOGIN, "user", 4);
+        appendFrame(stream, FRAME_HASH, hash.data(), hash.size());
+        for (size_t pos = 0; pos < data.size(); pos += 5) {
+            appendFrame(stream, FRAME_VECTORS, data.data() + pos, std::min<size_t>(5, data.size() - pos));
+        }
+        for (size_t step : {size_t(1), size_t(3), stream.size()}) {
+            Session session(&p, &users);
+            std::vector<uint32_t> types;
+            std::string results = frames(converse(session, stream, step), types);
+            CHECK(session.finished());
+            CHECK(types.size() >= 3 && types[0] == FRAME_SALT && types[1] == FRAME_OK);
+            CHECK(results == expected);
+        }
+    }
+
+    
+    TEST(RejectsUnexpectedFrame) {
+        Params p;
+        p.logFile = "test_journal.txt";
+        UserRegistry users;
+        Session session(&p, &users);
+        std::string stream(FRAME_MAGIC, FRAME_MAGIC_SIZE);
+        appendFrame(stream, FRAME_VECTORS, "\0\0\0\0", 4);
+        std::vector<uint32_t> types;
+        frames(converse(session, stream, 2), types);
+        CHECK(session.finished());
+        CHECK(types.size() == 1 && types[0] == FRAME_ERR);
+
+        // Исходный протокол по-прежнему принимается
+        Session legacy(&p, &users);
+        CHECK(converse(legacy, "nobody", 64) == "ERR_USER_NOT_FOUND");
+    }
+}
+
+SUITE(TicketTest) {
+    
+    
+    TEST(SingleUseAndExpiry) {
+        TicketStore store(1000, 64);
+        std::string login;
+        std::string ticket = store.issue("user", 1, 5000);
+        CHECK_EQUAL(TICKET_SIZE, ticket.size());
+
+        // Изменённый, устаревший по базе и просроченный билеты отклоняются
+        std::string forged = ticket;
+        forged[TICKET_SIZE - 1] ^= 1;
+        CHECK(!store.redeem(forged, 1, 5001, login));
+        CHECK(!store.redeem(ticket, 1, 6000, login));
+        ticket = store.issue("user", 1, 5000);
+        CHECK(!store.redeem(ticket, 2, 5001, login));
+
+        ticket = store.issue("user", 1, 5000);
+        CHECK(store.redeem(ticket, 1, 5999, login));
+        CHECK_EQUAL("user", login);
+        CHECK(!store.redeem(ticket, 1, 5999, login));
+    }
+
+    
+    TEST(CapacityBounded) {
+        TicketStore store(60000, TICKET_SHARDS * 4);
+        std::vector<std::string> tickets;
+        for (int i = 0; i < TICKET_SHARDS * 16; i++) {
+            tickets.push_back(store.issue("user" + std::to_string(i), 0, 1000));
+        }
+        CHECK_EQUAL(size_t(TICKET_SHARDS * 4), store.size());
+        std::string login;
+        CHECK(!store.redeem(tickets.front(), 0, 1001, login));
+        CHECK(store.redeem(tickets.back(), 0, 1001, login));
+    }
+
+    
+    // Подача всего потока сеансу одной порцией
+    void feed(Session& session, const std::string& stream) {
+        for (size_t pos = 0, used; pos < stream.size() && (used = session.onData(stream.data() + pos, stream.size() - pos)) > 0;) {
+            pos += used;
+        }
+    }
+
+    // Данные первого кадра заданного типа в ответе сервера
+    bool payload(const std::string& out, FrameType type, std::string& data) {
+        for (size_t pos = 0; pos + sizeof(FrameHeader) <= out.size();) {
+            FrameHeader h = readFrameHeader(out.data() + pos);
+            if (h.type == type) {
+                data = out.substr(pos + sizeof(FrameHeader), h.length);
+                return true;
+            }
+            pos += sizeof(FrameHeader) + h.length;
+        }
+        return false;
+    }
+
+    
+    TEST(ResumedSession) {
+        Params p;
+        p.logFile = "test_journal.txt";
+        UserRegistry users;
+        std::unique_ptr<UserBase> base(new UserBase);
+        base->insert("user", "P@ssW0rd");
+        users.publish(std::move(base));
+        startTickets(60000, 1024);
+
+        // Полный вход выдаёт билет
+        std::string hash = auth(SALT, "P@ssW0rd");
+        std::string stream(FRAME_MAGIC, FRAME_MAGIC_SIZE);
+        appendFrame(stream, FRAME_LOGIN, "user", 4);
+        appendFrame(stream, FRAME_HASH, hash.data(), hash.size());
+        Session first(&p, &users);
+        feed(first, stream);
+        std::string ticket, text;
+        CHECK(payload(first.out, FRAME_TICKET, ticket));
+
+        // Билет заменяет логин и хеш, векторы идут той же передачей
+        uint32_t data[3] = {1, 1, 7};
+        std::string resume(FRAME_MAGIC, FRAME_MAGIC_SIZE);
+        appendFrame(resume, FRAME_RESUME, ticket.data(), ticket.size());
+        appendFrame(resume, FRAME_VECTORS, reinterpret_cast<const char*>(data), sizeof(data));
+        Session second(&p, &users);
+        feed(second, resume);
+        CHECK(second.finished());
+        CHECK(!payload(second.out, FRAME_SALT, text));
+        CHECK(payload(second.out, FRAME_OK, text));
+        CHECK(payload(second.out, FRAME_TICKET, text) && text != ticket);
+        CHECK(payload(second.out, FRAME_RESULTS, text) && text.size() == sizeof(int32_t));
+
+        // Повторное предъявление и билет до перезагрузки базы отклоняются
+        Session replay(&p, &users);
+        feed(replay, resume);
+        CHECK(replay.finished());
+        CHECK(payload(replay.out, FRAME_ERR, text) && text == "ERR_TICKET");
+        resume.resize(FRAME_MAGIC_SIZE);
+        std::string fresh;
+        payload(second.out, FRAME_TICKET, fresh);
+        appendFrame(resume, FRAME_RESUME, fresh.data(), fresh.size());
+        users.publish(std::unique_ptr<UserBase>(new UserBase));
+        Session reloaded(&p, &users);
+        feed(reloaded, resume);
+        CHECK(payload(reloaded.out, FRAME_ERR, text));
+        startTickets(0, 0);
+    }
+}
+
+SUITE(AdmissionTest) {
+    
+    
+    TEST(FailureBucket) {
+        // Один неудачный вход в секунду, три подряд
+        FailureLimiter limiter(60, 3, 1024);
+        CHECK(limiter.allowed(1, 1000));
+        CHECK_EQUAL(0u, limiter.size());
+        CHECK(!limiter.failed(1, 1000));
+        CHECK(!limiter.failed(1, 1000));
+        CHECK(limiter.failed(1, 1000));
+        CHECK(!limiter.failed(1, 1000));
+        CHECK(!limiter.allowed(1, 1999));
+        CHECK(limiter.allowed(2, 1000));
+        CHECK(limiter.allowed(1, 2000));
+        CHECK_EQUAL(1u, limiter.size());
+    }
+
+    
+    TEST(TableBounded) {
+        FailureLimiter limiter(60, 2, ADMISSION_STRIPES);
+        for (uint32_t addr = 0; addr < 4096; addr++) {
+            limiter.failed(addr, 1000);
+        }
+        CHECK(limiter.size() <= ADMISSION_STRIPES);
+        limiter.failed(5000, 1000);
+        limiter.failed(5000, 1000);
+        CHECK(!limiter.allowed(5000, 1000));
+    }
+
+    
+    TEST(SessionCap) {
+        startAdmission(0, 1, 2);
+        long base = activeSessions();
+        int fds[3];
+        for (int& fd : fds) {
+            fd = socket(AF_INET, SOCK_STREAM, 0);
+        }
+        CHECK(admitClient(fds[0], 1));
+        CHECK(admitClient(fds[1], 1));
+        CHECK(!admitClient(fds[2], 1));
+        CHECK_EQUAL(base + 2, activeSessions());
+        releaseClient();
+        releaseClient();
+        close(fds[0]);
+        close(fds[1]);
+        startAdmission(0, 1, 0);
+    }
+
+    
+    TEST(FailedLoginsThrottled) {
+        Params p;
+        p.logFile = "test_journal.txt";
+        UserRegistry users;
+        users.publish(std::unique_ptr<UserBase>(new UserBase));
+        startAdmission(60, 2, 0);
+        uint32_t peer = inet_addr("192.0.2.7");
+        for (int i = 0; i < 2; i++) {
+            Session session(&p, &users, false, peer);
+            session.onData("nobody", 6);
+            CHECK(session.finished());
+        }
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        CHECK(!admitClient(fd, peer));
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        CHECK(admitClient(fd, inet_addr("192.0.2.8")));
+        releaseClient();
+        close(fd);
+        startAdmission(0, 1, 0);
+    }
+
+    
+    TEST(BareConnectsNotCharged) {
+        Params p{};
+        p.logFile = "test_journal.txt";
+        UserRegistry users;
+        users.publish(std::unique_ptr<UserBase>(new UserBase));
+        startAdmission(60, 2, 0);
+        uint32_t peer = inet_addr("192.0.2.9");
+        for (int i = 0; i < 3; i++) {
+            int sv[2];
+            CHECK_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+            close(sv[1]);
+            CHECK_EQUAL(1, Connection::handleClient(sv[0], &p, &users, peer));
+        }
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        CHECK(admitClient(fd, peer));
+        releaseClient();
+        close(fd);
+        startAdmission(0, 1, 0);
+    }
+
+    
+    TEST(AcceptBackoffThrottled) {
+        Params p{};
+        p.logFile = "accept_backoff_test.txt";
+        std::remove(p.logFile.c_str());
+        CHECK(AcceptBackoff::exhausted(EMFILE));
+        CHECK(!AcceptBackoff::exhausted(ECONNABORTED));
+        AcceptBackoff backoff;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < 5; i++) {
+            backoff.pause(&p, "Ошибка accept", EMFILE);
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        CHECK(elapsed.count() >= 5 * ACCEPT_BACKOFF_MS);
+        std::ifstream log(p.logFile);
+        std::string line;
+        int lines = 0;
+        while (std::getline(log, line)) {
+            lines++;
+        }
+        CHECK_EQUAL(1, lines);
+        std::remove(p.logFile.c_str());
+    }
+
+    
+    TEST(DecoderLimits) {
+        setVectorLimits(2, 4);
+        auto run = [](std::vector<uint32_t> words) {
+            VectorDecoder decoder;
+            std::string out;
+            decoder.feed(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint32_t), out);
+            return decoder;
+        };
+        VectorDecoder d = run({3});
+        CHECK(d.failed());
+        CHECK(d.error().find("количество векторов 3") != std::string::npos);
+        d = run({1, 5, 1, 2, 3, 4, 5});
+        CHECK(d.failed());
+        CHECK(run({1, 4, 1, 2, 3, 4}).done());
+        CHECK(run({2 | BATCH_EXTENDED, 0}).state() == VectorDecoder::SIZE);
+        CHECK(run({3 | BATCH_EXTENDED, 0}).failed());
+        setVectorLimits(0, 0);
+    }
+}
+
+SUITE(HandoffTest) {
+    
+    
+    TEST(ListenersReceived) {
+        Params p{};
+        p.logFile = "test_journal.txt";
+        p.Address = "127.0.0.1";
+        p.Port = 0;
+        p.Backlog = 16;
+        p.Handoff = "handoff_test.sock";
+        std::vector<int> sockets = {Connection::listenSocket(&p, false)};
+        startHandoff(&p, sockets);
+        CHECK(!handoffDone());
+        struct stat st;
+        CHECK_EQUAL(0, stat(p.Handoff.c_str(), &st));
+        CHECK_EQUAL(0u, st.st_mode & (S_IRWXG | S_IRWXO));
+
+        // Второй сервер того же процесса получает сокет вместо привязки порта
+        std::vector<int> received;
+        CHECK(receiveListeners(&p, received));
+        CHECK_EQUAL(size_t(1), received.size());
+        for (int i = 0; i < 200 && !handoffDone(); i++) {
+            usleep(10000);
+        }
+        CHECK(handoffDone());
+
+        sockaddr_in addr{};
+        socklen_t len = sizeof(addr);
+        getsockname(received[0], reinterpret_cast<sockaddr*>(&addr), &len);
+        int c = socket(AF_INET, SOCK_STREAM, 0);
+        CHECK_EQUAL(0, connect(c, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)));
+        int a = accept(received[0], nullptr, nullptr);
+        CHECK(a != -1);
+        close(a);
+        close(c);
+        close(received[0]);
+        close(sockets[0]);
+        unlink(p.Handoff.c_str());
+    }
+}
+
+SUITE(UserBaseTest) {
+    
+    
+    TEST(SameRulesAsFileScan) {
+        const char* name = "userbase_test.txt";
+        {
+            std::ofstream f(name);
+            f << "# комментарий\n; ещё комментарий\n\n"
+              << "  alice : secret \n"
+              << "bob:\tpass word\t\n"
+              << "noseparator\n"
+              << "alice:second\n"
+              << " #carol:hidden\n"
+              << "dave:a:b\n"
+              << ":emptylogin\n";
+        }
+        UserBase users;
+        CHECK(users.load(name));
+        const char* logins[] = {"alice", "bob", "noseparator", "#carol", "dave", "", "carol", "eve"};
+        for (const char* login : logins) {
+            std::string expected, actual;
+            bool inFile = findUserInFile(name, login, expected);
+            CHECK_EQUAL(inFile, users.find(login, actual));
+            CHECK_EQUAL(expected, actual);
+        }
+        std::string password;
+        CHECK(users.find("alice", password));
+        CHECK_EQUAL("secret", password);
+        std::remove(name);
+    }
+
+    
+    TEST(ManyUsers) {
+        UserBase users;
+        for (int i = 0; i < 100000; i++) {
+            CHECK(users.insert("user" + std::to_string(i), "pass" + std::to_string(i)));
+        }
+        CHECK(!users.insert("user42", "other"));
+        CHECK_EQUAL(100000u, users.size());
+        std::string password;
+        CHECK(users.find("user99999", password));
+        CHECK_EQUAL("pass99999", password);
+        CHECK(users.find("user42", password));
+        CHECK_EQUAL("pass42", password);
+        CHECK(!users.find("user100000", password));
+    }
+
+    
+    TEST(BufferedMatchesStream) {
+        // Файл крупнее нескольких частей параллельного разбора
+        const char* name = "userbase_big.txt";
+        {
+            std::ofstream f(name);
+            for (int i = 0; i < 600000; i++) {
+                f << (i % 1000 == 0 ? "# " : "") << "user" << i << " : pass" << i << "\n";
+            }
+            f << "user1:duplicate\nlast:line";
+        }
+        UserBase mapped, stream;
+        CHECK(mapped.load(name, 4));
+        CHECK(stream.loadStream(name));
+        CHECK_EQUAL(stream.size(), mapped.size());
+        const char* logins[] = {"user1", "user1000", "user599999", "last", "user"};
+        for (const char* login : logins) {
+            std::string expected, actual;
+            CHECK_EQUAL(stream.find(login, expected), mapped.find(login, actual));
+            CHECK_EQUAL(expected, actual);
+        }
+        std::remove(name);
+    }
+
+    
+    TEST(RegistryReplacement) {
+        UserRegistry registry;
+        std::string password;
+        CHECK(!registry.find("user", password));
+        std::unique_ptr<UserBase> first(new UserBase);
+        first->insert("user", "old");
+        registry.publish(std::move(first));
+        CHECK(registry.find("user", password));
+        CHECK_EQUAL("old", password);
+        std::unique_ptr<UserBase> second(new UserBase);
+        second->insert("user", "new");
+        registry.publish(std::move(second));
+        CHECK(registry.find("user", password));
+        CHECK_EQUAL("new", password);
+        CHECK_EQUAL(1u, registry.size());
+    }
+
+    
+    TEST(MissingFile) {
+        UserBase users;
+        CHECK(!users.load("no_such_base.txt"));
+        std::string password;
+        CHECK(!users.find("user", password));
+    }
+}
+
+SUITE(AuthTest) {
+    
+    
+    TEST(KnownHash) {
+        // SHA224("HASHHASHHASHHASH" + "P@ssW0rd") в hex-формате CryptoPP
+        std::string expected = auth("HASHHASHHASHHASH", "P@ssW0rd");
+        CHECK_EQUAL(56u, expected.size());
+        char hash[AUTH_HASH_SIZE];
+        authInto("HASHHASHHASHHASH", "P@ssW0rd", hash);
+        CHECK_EQUAL(expected, std::string(hash, AUTH_HASH_SIZE));
+        CHECK_EQUAL("D14A028C2A3A2BC9476102BB288234C415A2B01F828EA62AC5B3E42F", auth("", ""));
+    }
+
+    
+    TEST(RepeatedCalls) {
+        // Объект SHA224 потока должен сбрасываться между вызовами
+        char first[AUTH_HASH_SIZE], second[AUTH_HASH_SIZE];
+        authInto("salt", "one", first);
+        authInto("salt", "two", second);
+        authInto("salt", "one", second);
+        CHECK(std::string(first, AUTH_HASH_SIZE) == std::string(second, AUTH_HASH_SIZE));
+        CHECK(auth("salt", "one") != auth("salt", "two"));
+    }
+
+    
+    TEST(ConstantTimeCompare) {
+        CHECK(hashEquals("ABCDEF", "ABCDEF"));
+        CHECK(!hashEquals("ABCDEF", "ABCDEE"));
+        CHECK(!hashEquals("ABCDEF", "BBCDEF"));
+        CHECK(!hashEquals("ABCDEF", "ABCDE"));
+        CHECK(hashEquals("", ""));
+    }
+
+    
+    TEST(BatchKernelsMatchAuth) {
+        // Пароли от пустого до трёх блоков SHA-256, пакеты с неполными проходами AVX2
+        std::vector<std::string> passwords;
+        for (size_t len = 0; len < 150; len += 7) {
+            passwords.push_back(std::string(len, static_cast<char>('a' + len % 26)));
+        }
+        std::vector<std::string_view> salts(passwords.size(), SALT), passes(passwords.begin(), passwords.end());
+        bool supported[] = {true, __builtin_cpu_supports("avx2") != 0, __builtin_cpu_supports("sha") != 0};
+        for (int k = AUTH_CRYPTOPP; k <= AUTH_SHANI; k++) {
+            if (!supported[k]) {
+                continue;
+            }
+            for (size_t n : {size_t(1), size_t(3), size_t(AUTH_LANES + 2), passwords.size()}) {
+                std::vector<char> out(n * AUTH_HASH_SIZE);
+                authBatchAt(static_cast<AuthKernel>(k), salts.data(), passes.data(), n, out.data());
+                for (size_t i = 0; i < n; i++) {
+                    CHECK_EQUAL(auth(SALT, passwords[i]), std::string(out.data() + i * AUTH_HASH_SIZE, AUTH_HASH_SIZE));
+                }
+            }
+        }
+    }
+
+    
+    TEST(BatchedSessions) {
+        Params p;
+        p.logFile = "test_journal.txt";
+        UserRegistry users;
+        std::unique_ptr<UserBase> base(new UserBase);
+        base->insert("user", "P@ssW0rd");
+        users.publish(std::move(base));
+
+        // Хеш ждёт проверки, данные за ним не принимаются
+        std::vector<std::unique_ptr<Session>> sessions;
+        std::vector<Session*> pending;
+        for (int i = 0; i < 5; i++) {
+            sessions.emplace_back(new Session(&p, &users, true));
+            Session& s = *sessions.back();
+            CHECK_EQUAL(size_t(4), s.onData("user", 4));
+            std::string hash = i == 2 ? std::string(AUTH_HASH_SIZE, '0') : auth(SALT, "P@ssW0rd");
+            s.out.clear();
+            s.onData(hash.data(), hash.size());
+            CHECK(s.state() == Session::VERIFY);
+            CHECK_EQUAL(size_t(0), s.onData("\1\0\0\0", 4));
+            pending.push_back(&s);
+        }
+        Session::verify(pending);
+        for (int i = 0; i < 5; i++) {
+            CHECK_EQUAL(i == 2 ? "ERR" : "OK", sessions[i]->out);
+            CHECK(sessions[i]->state() == (i == 2 ? Session::CLOSING : Session::DATA));
+        }
+    }
+}
+
+SUITE(TimeStampTest) {
+    
+    
+    TEST(Format) {
+        char stamp[TIME_STAMP_SIZE];
+        CHECK_EQUAL(23u, formatCurrentTime(stamp));
+        const std::string layout = "dddd-dd-dd dd:dd:dd.ddd";
+        for (size_t i = 0; i < layout.size(); i++) {
+            if (layout[i] == 'd') {
+                CHECK(isdigit(static_cast<unsigned char>(stamp[i])));
+            } else {
+                CHECK_EQUAL(layout[i], stamp[i]);
+            }
+        }
+        CHECK_EQUAL(23u, getCurrentTime().size());
+    }
+}
+
+SUITE(LoggerTest) {
+    
+    
+    // Запись count сообщений из каждого из threads потоков через фоновый журнал
+    void logFrom(const char* file, int threads, int count) {
+        std::vector<std::thread> writers;
+        for (int t = 0; t < threads; t++) {
+            writers.emplace_back([file, t, count] {
+                for (int i = 0; i < count; i++) {
+                    logError(file, "поток " + std::to_string(t) + " сообщение " + std::to_string(i));
+                }
+            });
+        }
+        for (auto& w : writers) {
+            w.join();
+        }
+    }
+
+    // Число записанных сообщений и потерь, отмеченных журналом
+    size_t countLines(const char* file, size_t& dropped) {
+        std::ifstream in(file);
+        std::string line;
+        size_t lines = 0;
+        dropped = 0;
+        const std::string mark = "пропущено сообщений: ";
+        while (std::getline(in, line)) {
+            size_t pos = line.find(mark);
+            if (pos != std::string::npos) {
+                dropped += std::stoul(line.substr(pos + mark.size()));
+            } else {
+                lines++;
+            }
+        }
+        return lines;
+    }
+
+    
+    TEST(DropCountedOnFullRing) {
+        const char* file = "logger_drop_test.txt";
+        remove(file);
+        startLogger(4, 1000, LOG_DROP);
+        logFrom(file, 4, 500);
+        stopLogger();
+        size_t dropped;
+        size_t lines = countLines(file, dropped);
+        CHECK_EQUAL(size_t(2000), lines + dropped);
+        CHECK(lines > 0);
+        remove(file);
+    }
+
+    
+    TEST(StartupErrorJournaled) {
+        // Порт занят другим слушающим сокетом
+        int taken = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        CHECK_EQUAL(0, bind(taken, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)));
+        CHECK_EQUAL(0, listen(taken, 1));
+        getsockname(taken, reinterpret_cast<sockaddr*>(&addr), &len);
+
+        const char* file = "logger_startup_test.txt";
+        remove(file);
+        std::string port = std::to_string(ntohs(addr.sin_port));
+        UserInterface iface;
+        const char* argv[] = {"test", "-b", "/dev/null", "-j", "log", "-p", port.c_str(), "-l", file, nullptr};
+        int argc = sizeof(argv) / sizeof(argv[0]) - 1;
+        CHECK(iface.Parser(argc, argv));
+        Params p = iface.getParams();
+        startLogger(p.LogQueue, 1000, LOG_DROP);
+        CHECK_THROW(Connection::connection(&p), std::system_error);
+        stopLogger();
+        std::ifstream in(file);
+        std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        CHECK(text.find("Ошибка bind") != std::string::npos);
+        close(taken);
+        remove(file);
+    }
+
+    
+    TEST(BlockKeepsEveryMessage) {
+        const char* file = "logger_block_test.txt";
+        remove(file);
+        startLogger(2, 1000, LOG_BLOCK);
+        logFrom(file, 4, 500);
+        stopLogger();
+        size_t dropped;
+        CHECK_EQUAL(size_t(2000), countLines(file, dropped));
+        CHECK_EQUAL(size_t(0), dropped);
+        remove(file);
+    }
+}
+
+SUITE(MetricsTest) {
+    
+    
+    TEST(BucketBounds) {
+        for (uint64_t ns : {0ull, 7ull, 8ull, 15ull, 16ull, 1000ull, 123456789ull, 1ull << 40}) {
+            size_t bucket = latencyBucket(ns);
+            CHECK(bucket < LATENCY_BUCKETS);
+            CHECK(latencyBucketLow(bucket) <= ns);
+            CHECK(ns < latencyBucketLow(bucket + 1));
+        }
+        CHECK_EQUAL(LATENCY_BUCKETS - 1, latencyBucket(~0ull));
+    }
+
+    
+    TEST(DecoderCounts) {
+        metricAdd(MET_ELEMENTS, 0);
+        uint64_t before = metricsShard->counters[MET_ELEMENTS].load();
+        uint32_t stream[] = {2, 3, 1, 2, 3, 0};
+        std::string out;
+        VectorDecoder decoder;
+        size_t pos = 0;
+        while (!decoder.done()) {
+            pos += decoder.feed(reinterpret_cast<const char*>(stream) + pos, sizeof(stream) - pos, out);
+        }
+        CHECK_EQUAL(3u, metricsShard->counters[MET_ELEMENTS].load() - before);
+        CHECK(metricsText().find("vecserver_vectors_total") != std::string::npos);
+        CHECK(metricsText().find("vecserver_vector_latency_seconds_bucket{le=\"+Inf\"}") != std::string::npos);
+    }
+}
+
 
 int main() {
     return UnitTest::RunAllTests();
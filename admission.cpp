@@ -0,0 +1,251 @@
+/**
+ * @file admission.cpp
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация допуска клиентов
+ */
+
+#include "admission.h"
+#include "log.h"
+#include "metrics.h"
+#include "timeout.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+/// Ограничение неудачных входов; заменяется только до начала обслуживания клиентов
+static std::unique_ptr<FailureLimiter> limiter;
+
+/// Допущенные и ещё не завершённые сеансы
+static std::atomic<long> sessions{0};
+
+/// Наибольшее число одновременных сеансов (0 — без предела)
+static long sessionLimit = 0;
+
+/**
+ * @brief Конструктор
+ * @param[in] perMinute Восполнение корзины, неудачных входов в минуту
+ * @param[in] burst Размер корзины: неудачные входы подряд до отказа
+ * @param[in] capacity Наибольшее число отслеживаемых адресов
+ */
+FailureLimiter::FailureLimiter(double perMinute, double burst, size_t capacity)
+    : rate(perMinute / 60000.0), burst(burst),
+      capacity(capacity / ADMISSION_STRIPES > 0 ? capacity / ADMISSION_STRIPES : 1)
+{
+}
+
+/**
+ * @brief Полоса таблицы адреса
+ * @param[in] addr Адрес IPv4
+ * @return Полоса
+ * @details Адреса одной подсети отличаются младшими битами номера узла,
+ *          поэтому полоса выбирается по перемешанному адресу
+ */
+FailureLimiter::Stripe& FailureLimiter::stripe(uint32_t addr)
+{
+    return stripes[((addr * 2654435761u) >> 16) & (ADMISSION_STRIPES - 1)];
+}
+
+/**
+ * @brief Восполнение корзины к текущему времени
+ * @param[in,out] b Корзина
+ * @param[in] now Текущее время, мс
+ */
+void FailureLimiter::refill(Bucket& b, uint64_t now) const
+{
+    if (now > b.at) {
+        b.tokens = std::min(burst, b.tokens + (now - b.at) * rate);
+        b.at = now;
+    }
+}
+
+/**
+ * @brief Проверка допуска соединения с адреса
+ * @param[in] addr Адрес IPv4
+ * @param[in] now Текущее время, мс
+ * @return false если неудачные входы с адреса исчерпали корзину
+ */
+bool FailureLimiter::allowed(uint32_t addr, uint64_t now)
+{
+    Stripe& s = stripe(addr);
+    std::lock_guard<std::mutex> lock(s.mtx);
+    auto it = s.buckets.find(addr);
+    if (it == s.buckets.end()) {
+        return true;
+    }
+    refill(it->second, now);
+    return it->second.tokens >= 1;
+}
+
+/**
+ * @brief Учёт неудачного входа
+ * @param[in] addr Адрес IPv4
+ * @param[in] now Текущее время, мс
+ * @return true если этот вход исчерпал корзину адреса
+ * @details При заполненной полосе сначала удаляются восполненные корзины;
+ *          если их нет, вытесняется произвольная запись, чтобы новый
+ *          адрес всё равно отслеживался
+ */
+bool FailureLimiter::failed(uint32_t addr, uint64_t now)
+{
+    Stripe& s = stripe(addr);
+    std::lock_guard<std::mutex> lock(s.mtx);
+    auto it = s.buckets.find(addr);
+    if (it == s.buckets.end()) {
+        if (s.buckets.size() >= capacity) {
+            for (auto j = s.buckets.begin(); j != s.buckets.end();) {
+                refill(j->second, now);
+                j = j->second.tokens >= burst ? s.buckets.erase(j) : std::next(j);
+            }
+            if (s.buckets.size() >= capacity) {
+                s.buckets.erase(s.buckets.begin());
+            }
+        }
+        it = s.buckets.emplace(addr, Bucket{burst, now}).first;
+    }
+    Bucket& b = it->second;
+    refill(b, now);
+    bool open = b.tokens >= 1;
+    b.tokens = std::max(0.0, b.tokens - 1);
+    return open && b.tokens < 1;
+}
+
+/**
+ * @brief Число отслеживаемых адресов
+ * @return Количество записей таблицы
+ */
+size_t FailureLimiter::size()
+{
+    size_t n = 0;
+    for (Stripe& s : stripes) {
+        std::lock_guard<std::mutex> lock(s.mtx);
+        n += s.buckets.size();
+    }
+    return n;
+}
+
+/**
+ * @brief Проверка ошибки accept на нехватку ресурсов
+ * @param[in] err Код ошибки (errno)
+ * @return true для EMFILE, ENFILE, ENOBUFS и ENOMEM
+ */
+bool AcceptBackoff::exhausted(int err)
+{
+    return err == EMFILE || err == ENFILE || err == ENOBUFS || err == ENOMEM;
+}
+
+/**
+ * @brief Запись ошибки в журнал с ограничением частоты и пауза
+ * @param[in] p Параметры сервера
+ * @param[in] what Начало сообщения, например "Ошибка accept"
+ * @param[in] err Код ошибки (errno)
+ * @details Строку пишет только поток, первым заметивший истечение
+ *          интервала; остальные ошибки учитываются в её тексте
+ */
+void AcceptBackoff::pause(const Params* p, const std::string& what, int err)
+{
+    uint64_t now = monotonicMs();
+    uint64_t last = logged.load();
+    if ((last == 0 || now - last >= ACCEPT_LOG_INTERVAL_MS) && logged.compare_exchange_strong(last, now)) {
+        std::string message = what + ": " + std::string(strerror(err));
+        uint64_t skipped = suppressed.exchange(0);
+        if (skipped > 0) {
+            message += " (ещё " + std::to_string(skipped) + " не записано)";
+        }
+        logError(p->logFile, message);
+    } else {
+        suppressed.fetch_add(1);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(ACCEPT_BACKOFF_MS));
+}
+
+/**
+ * @brief Запуск допуска клиентов
+ * @param[in] failRate Восполнение, неудачных входов в минуту с адреса
+ *                     (0 — частота не ограничивается)
+ * @param[in] failBurst Неудачные входы подряд до отказа
+ * @param[in] maxSessions Наибольшее число одновременных сеансов (0 — без предела)
+ */
+void startAdmission(int failRate, int failBurst, int maxSessions)
+{
+    limiter.reset(failRate > 0 && failBurst > 0 ? new FailureLimiter(failRate, failBurst, ADMISSION_CAPACITY) : nullptr);
+    sessionLimit = maxSessions;
+}
+
+/**
+ * @brief Сброс отклонённого соединения
+ * @param[in] fd Сокет клиента
+ */
+static void resetClient(int fd)
+{
+    linger lin = {1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_LINGER, &lin, sizeof(lin));
+    close(fd);
+}
+
+/**
+ * @brief Допуск принятого соединения
+ * @param[in] fd Сокет клиента
+ * @param[in] addr Адрес клиента IPv4
+ * @return true если соединение допущено, false если отклонено (сокет закрыт)
+ */
+bool admitClient(int fd, uint32_t addr)
+{
+    long active = sessions.fetch_add(1);
+    if (sessionLimit > 0 && active >= sessionLimit) {
+        sessions.fetch_sub(1);
+        metricAdd(MET_REJECTED_BUSY);
+        resetClient(fd);
+        return false;
+    }
+    if (limiter && !limiter->allowed(addr, monotonicMs())) {
+        sessions.fetch_sub(1);
+        metricAdd(MET_REJECTED_THROTTLED);
+        resetClient(fd);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Завершение допущенного сеанса
+ */
+void releaseClient()
+{
+    sessions.fetch_sub(1);
+}
+
+/**
+ * @brief Учёт неудачного входа клиента
+ * @param[in] p Параметры сервера
+ * @param[in] addr Адрес клиента IPv4
+ */
+void loginFailed(const Params* p, uint32_t addr)
+{
+    if (!limiter || !limiter->failed(addr, monotonicMs())) {
+        return;
+    }
+    in_addr a;
+    a.s_addr = addr;
+    char text[INET_ADDRSTRLEN] = "?";
+    inet_ntop(AF_INET, &a, text, sizeof(text));
+    logError(p->logFile, "Ошибка аутентификации: превышен предел неудачных входов с адреса " + std::string(text) + ", новые соединения отклоняются");
+}
+
+/**
+ * @brief Число одновременных сеансов
+ * @return Количество допущенных и ещё не завершённых сеансов
+ */
+long activeSessions()
+{
+    return sessions.load();
+}
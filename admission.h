@@ -0,0 +1,190 @@
+/**
+ * @file admission.h
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл допуска клиентов
+ * @details Содержит ограничение частоты неудачных входов с одного адреса
+ *          и общего числа одновременных сеансов. Соединения сверх пределов
+ *          закрываются сразу после accept, до поиска пользователя,
+ *          вычисления хеша и записи в журнал.
+ */
+
+#pragma once
+#include "interface.h"
+#include <cstddef>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/// Число полос таблицы адресов (степень двойки)
+#define ADMISSION_STRIPES 64
+/// Наибольшее число адресов, для которых хранится счёт неудачных входов
+#define ADMISSION_CAPACITY 65536
+/// Пауза перед повторным accept при нехватке дескрипторов или памяти, мс
+#define ACCEPT_BACKOFF_MS 100
+/// Наименьший промежуток между записями в журнал об этой нехватке, мс
+#define ACCEPT_LOG_INTERVAL_MS 1000
+
+/**
+ * @class FailureLimiter
+ * @brief Ограничение частоты неудачных входов по адресу клиента
+ * @details Каждому адресу соответствует корзина маркеров: неудачный вход
+ *          забирает маркер, маркеры восполняются с заданной скоростью до
+ *          размера корзины. С адреса, корзина которого пуста, соединения
+ *          не принимаются. Запись создаётся только при первой неудаче,
+ *          поэтому обычные клиенты не занимают таблицу; полная корзина
+ *          ничем не отличается от отсутствующей записи и удаляется при
+ *          нехватке места.
+ *
+ *          Таблица разделена на полосы со своими мьютексами по хешу
+ *          адреса, поэтому потоки приёма разных шардов почти не
+ *          конкурируют за блокировку.
+ */
+class FailureLimiter
+{
+private:
+    /// Корзина маркеров адреса
+    struct Bucket {
+        double tokens;      ///< Доступные неудачные входы
+        uint64_t at;        ///< Время последнего пересчёта, мс
+    };
+
+    /// Полоса таблицы на отдельной линии кеша
+    struct alignas(64) Stripe {
+        std::mutex mtx;                                 ///< Мьютекс полосы
+        std::unordered_map<uint32_t, Bucket> buckets;   ///< Корзины по адресу
+    };
+
+    Stripe stripes[ADMISSION_STRIPES];  ///< Полосы таблицы
+    double rate;                        ///< Восполнение, маркеров в мс
+    double burst;                       ///< Размер корзины
+    size_t capacity;                    ///< Наибольшее число адресов в полосе
+
+    /**
+     * @brief Полоса таблицы адреса
+     * @param[in] addr Адрес IPv4
+     * @return Полоса
+     */
+    Stripe& stripe(uint32_t addr);
+
+    /**
+     * @brief Восполнение корзины к текущему времени
+     * @param[in,out] b Корзина
+     * @param[in] now Текущее время, мс
+     */
+    void refill(Bucket& b, uint64_t now) const;
+
+public:
+    /**
+     * @brief Конструктор
+     * @param[in] perMinute Восполнение корзины, неудачных входов в минуту
+     * @param[in] burst Размер корзины: неудачные входы подряд до отказа
+     * @param[in] capacity Наибольшее число отслеживаемых адресов
+     */
+    FailureLimiter(double perMinute, double burst, size_t capacity);
+
+    FailureLimiter(const FailureLimiter&) = delete;
+    FailureLimiter& operator=(const FailureLimiter&) = delete;
+
+    /**
+     * @brief Проверка допуска соединения с адреса
+     * @param[in] addr Адрес IPv4
+     * @param[in] now Текущее время, мс
+     * @return false если неудачные входы с адреса исчерпали корзину
+     */
+    bool allowed(uint32_t addr, uint64_t now);
+
+    /**
+     * @brief Учёт неудачного входа
+     * @param[in] addr Адрес IPv4
+     * @param[in] now Текущее время, мс
+     * @return true если этот вход исчерпал корзину адреса
+     */
+    bool failed(uint32_t addr, uint64_t now);
+
+    /**
+     * @brief Число отслеживаемых адресов
+     * @return Количество записей таблицы
+     */
+    size_t size();
+};
+
+/**
+ * @class AcceptBackoff
+ * @brief Ожидание перед повторным accept при нехватке ресурсов
+ * @details Пока процесс упирается в предел дескрипторов или памяти, accept
+ *          сразу возвращает ту же ошибку, а ожидающее соединение остаётся в
+ *          очереди. Без паузы цикл приёма занимает ядро целиком и пишет в
+ *          журнал строку на каждой итерации, поэтому поток приёма
+ *          засыпает на ACCEPT_BACKOFF_MS, а в журнал попадает не больше
+ *          одной строки за ACCEPT_LOG_INTERVAL_MS с числом пропущенных.
+ *          Один объект может использоваться несколькими потоками приёма.
+ */
+class AcceptBackoff
+{
+private:
+    std::atomic<uint64_t> logged{0};        ///< Время последней записи в журнал, мс
+    std::atomic<uint64_t> suppressed{0};    ///< Ошибки, не записанные с тех пор
+
+public:
+    /**
+     * @brief Проверка ошибки accept на нехватку ресурсов
+     * @param[in] err Код ошибки (errno)
+     * @return true для EMFILE, ENFILE, ENOBUFS и ENOMEM
+     */
+    static bool exhausted(int err);
+
+    /**
+     * @brief Запись ошибки в журнал с ограничением частоты и пауза
+     * @param[in] p Параметры сервера
+     * @param[in] what Начало сообщения, например "Ошибка accept"
+     * @param[in] err Код ошибки (errno)
+     */
+    void pause(const Params* p, const std::string& what, int err);
+};
+
+/**
+ * @brief Запуск допуска клиентов
+ * @param[in] failRate Восполнение, неудачных входов в минуту с адреса
+ *                     (0 — частота не ограничивается)
+ * @param[in] failBurst Неудачные входы подряд до отказа
+ * @param[in] maxSessions Наибольшее число одновременных сеансов (0 — без предела)
+ * @details Вызывается до начала обслуживания клиентов
+ */
+void startAdmission(int failRate, int failBurst, int maxSessions);
+
+/**
+ * @brief Допуск принятого соединения
+ * @param[in] fd Сокет клиента
+ * @param[in] addr Адрес клиента IPv4
+ * @return true если соединение допущено; сеанс учитывается до releaseClient().
+ *         false если соединение отклонено и сокет закрыт
+ * @details Отклонённое соединение сбрасывается (RST), чтобы сокет не
+ *          оставался в состоянии TIME_WAIT, учитывается в статистике и не
+ *          записывается в журнал
+ */
+bool admitClient(int fd, uint32_t addr);
+
+/**
+ * @brief Завершение допущенного сеанса
+ */
+void releaseClient();
+
+/**
+ * @brief Учёт неудачного входа клиента
+ * @param[in] p Параметры сервера
+ * @param[in] addr Адрес клиента IPv4
+ * @details В журнал записывается только момент, когда адрес исчерпал
+ *          корзину и новые соединения с него начинают отклоняться
+ */
+void loginFailed(const Params* p, uint32_t addr);
+
+/**
+ * @brief Число одновременных сеансов
+ * @return Количество допущенных и ещё не завершённых сеансов
+ */
+long activeSessions();
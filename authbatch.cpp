@@ -0,0 +1,332 @@
+/**
+ * @file authbatch.cpp
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация пакетной проверки хешей паролей
+ */
+
+#include "authbatch.h"
+#include "crypto.h"
+#include <cstdint>
+#include <cstring>
+#include <immintrin.h>
+#include <vector>
+
+/// Размер блока SHA-256, байт
+#define SHA_BLOCK 64
+/// Наименьшее число сообщений, для которого проход AVX2 выгоднее CryptoPP
+#define AUTH_AVX2_MIN 3
+
+namespace {
+
+/// Начальное состояние SHA224
+const uint32_t sha224Init[8] = {
+    0xc1059ed8, 0x367cd507, 0x3070dd17, 0xf70e5939, 0xffc00b31, 0x68581511, 0x64f98fa7, 0xbefa4fa4
+};
+
+/// Константы раундов SHA-256
+alignas(16) const uint32_t roundK[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/**
+ * @struct Padded
+ * @brief Сообщения пакета, дополненные до целых блоков
+ * @details Память переиспользуется потоком от пакета к пакету
+ */
+struct Padded {
+    std::vector<unsigned char> data;    ///< Блоки всех сообщений подряд
+    std::vector<size_t> offset;         ///< Начало сообщения в data
+    std::vector<uint32_t> blocks;       ///< Число блоков сообщения
+};
+
+/**
+ * @brief Дополнение соли и пароля до целых блоков SHA-256
+ * @param[out] pad Сообщения пакета
+ * @param[in] salts Соли
+ * @param[in] passes Пароли
+ * @param[in] n Количество сообщений
+ */
+void pad(Padded& pad, const std::string_view* salts, const std::string_view* passes, size_t n)
+{
+    pad.data.clear();
+    pad.offset.resize(n);
+    pad.blocks.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        uint64_t len = salts[i].size() + passes[i].size();
+        size_t blocks = (len + 8) / SHA_BLOCK + 1;
+        size_t at = pad.data.size();
+        pad.offset[i] = at;
+        pad.blocks[i] = blocks;
+        pad.data.resize(at + blocks * SHA_BLOCK, 0);
+        unsigned char* p = pad.data.data() + at;
+        memcpy(p, salts[i].data(), salts[i].size());
+        memcpy(p + salts[i].size(), passes[i].data(), passes[i].size());
+        p[len] = 0x80;
+        uint64_t bits = len * 8;
+        for (int k = 0; k < 8; k++) {
+            p[blocks * SHA_BLOCK - 1 - k] = static_cast<unsigned char>(bits >> (8 * k));
+        }
+    }
+}
+
+/**
+ * @brief Запись первых 7 слов состояния в hex-формате auth()
+ * @param[in] state Состояние SHA-256 после последнего блока
+ * @param[out] out Буфер AUTH_HASH_SIZE символов
+ */
+void hexDigest(const uint32_t* state, char* out)
+{
+    static const char digits[] = "0123456789ABCDEF";
+    for (int w = 0; w < 7; w++) {
+        for (int k = 0; k < 8; k++) {
+            out[8 * w + k] = digits[(state[w] >> (28 - 4 * k)) & 0x0F];
+        }
+    }
+}
+
+/**
+ * @brief Сжатие блоков одного сообщения инструкциями SHA-NI
+ * @param[in,out] state Состояние SHA-256
+ * @param[in] data Блоки сообщения
+ * @param[in] blocks Число блоков
+ */
+__attribute__((target("sha,sse4.1")))
+void compressShaNi(uint32_t* state, const unsigned char* data, size_t blocks)
+{
+    const __m128i swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    // Инструкции работают с парами слов ABEF и CDGH
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0xB1);
+    __m128i cdgh = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)), 0x1B);
+    __m128i abef = _mm_alignr_epi8(tmp, cdgh, 8);
+    cdgh = _mm_blend_epi16(cdgh, tmp, 0xF0);
+
+    for (; blocks > 0; blocks--, data += SHA_BLOCK) {
+        __m128i abefSave = abef;
+        __m128i cdghSave = cdgh;
+        __m128i w[4];
+#pragma GCC unroll 16
+        for (int i = 0; i < 16; i++) {
+            if (i < 4) {
+                w[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * i)), swap);
+            } else {
+                __m128i x = _mm_sha256msg1_epu32(w[i & 3], w[(i + 1) & 3]);
+                x = _mm_add_epi32(x, _mm_alignr_epi8(w[(i + 3) & 3], w[(i + 2) & 3], 4));
+                w[i & 3] = _mm_sha256msg2_epu32(x, w[(i + 3) & 3]);
+            }
+            __m128i msg = _mm_add_epi32(w[i & 3], _mm_load_si128(reinterpret_cast<const __m128i*>(roundK + 4 * i)));
+            cdgh = _mm_sha256rnds2_epu32(cdgh, abef, msg);
+            abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(msg, 0x0E));
+        }
+        abef = _mm_add_epi32(abef, abefSave);
+        cdgh = _mm_add_epi32(cdgh, cdghSave);
+    }
+
+    tmp = _mm_shuffle_epi32(abef, 0x1B);
+    cdgh = _mm_shuffle_epi32(cdgh, 0xB1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_blend_epi16(tmp, cdgh, 0xF0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), _mm_alignr_epi8(cdgh, tmp, 8));
+}
+
+/// Циклический сдвиг вправо восьми слов
+__attribute__((target("avx2")))
+inline __m256i rotr(__m256i x, int n)
+{
+    return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+/**
+ * @brief Сжатие очередного блока восьми сообщений в регистрах AVX2
+ * @param[in,out] s Состояние: слово k всех сообщений в s[k]
+ * @param[in] block Блоки сообщений (для неактивных — любой доступный блок)
+ * @param[in] active Маска сообщений, у которых есть этот блок (-1 в элементе)
+ */
+__attribute__((target("avx2")))
+void compressAvx2(__m256i* s, const unsigned char* const* block, __m256i active)
+{
+    const __m256i swap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                          3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    __m256i w[16];
+    for (int t = 0; t < 16; t++) {
+        uint32_t lane[AUTH_LANES];
+        for (int l = 0; l < AUTH_LANES; l++) {
+            memcpy(&lane[l], block[l] + 4 * t, sizeof(uint32_t));
+        }
+        w[t] = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(lane)), swap);
+    }
+
+    __m256i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+#pragma GCC unroll 8
+    for (int t = 0; t < 64; t++) {
+        if (t >= 16) {
+            __m256i w15 = w[(t - 15) & 15];
+            __m256i w2 = w[(t - 2) & 15];
+            __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotr(w15, 7), rotr(w15, 18)), _mm256_srli_epi32(w15, 3));
+            __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotr(w2, 17), rotr(w2, 19)), _mm256_srli_epi32(w2, 10));
+            w[t & 15] = _mm256_add_epi32(_mm256_add_epi32(w[t & 15], s0), _mm256_add_epi32(w[(t - 7) & 15], s1));
+        }
+        __m256i sum1 = _mm256_xor_si256(_mm256_xor_si256(rotr(e, 6), rotr(e, 11)), rotr(e, 25));
+        __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+        __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, sum1),
+                                      _mm256_add_epi32(_mm256_add_epi32(ch, w[t & 15]), _mm256_set1_epi32(roundK[t])));
+        __m256i sum0 = _mm256_xor_si256(_mm256_xor_si256(rotr(a, 2), rotr(a, 13)), rotr(a, 22));
+        __m256i maj = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+        h = g;
+        g = f;
+        f = e;
+        e = _mm256_add_epi32(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = _mm256_add_epi32(t1, _mm256_add_epi32(sum0, maj));
+    }
+
+    // Состояние сообщений без этого блока не меняется
+    __m256i next[8] = {a, b, c, d, e, f, g, h};
+    for (int k = 0; k < 8; k++) {
+        s[k] = _mm256_blendv_epi8(s[k], _mm256_add_epi32(s[k], next[k]), active);
+    }
+}
+
+/**
+ * @brief Хеши до восьми дополненных сообщений одним проходом AVX2
+ * @param[in] pad Сообщения пакета
+ * @param[in] first Номер первого сообщения
+ * @param[in] lanes Число сообщений (не более AUTH_LANES)
+ * @param[out] out Хеши сообщений подряд
+ * @details Проход длится по самому длинному сообщению; более короткие
+ *          сообщения после своего последнего блока не изменяются
+ */
+__attribute__((target("avx2")))
+void hashLanesAvx2(const Padded& pad, size_t first, size_t lanes, char* out)
+{
+    __m256i s[8];
+    for (int k = 0; k < 8; k++) {
+        s[k] = _mm256_set1_epi32(sha224Init[k]);
+    }
+    uint32_t counts[AUTH_LANES] = {};
+    uint32_t longest = 0;
+    for (size_t l = 0; l < lanes; l++) {
+        counts[l] = pad.blocks[first + l];
+        longest = counts[l] > longest ? counts[l] : longest;
+    }
+    __m256i remaining = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(counts));
+    const unsigned char* block[AUTH_LANES];
+    for (uint32_t j = 0; j < longest; j++) {
+        for (size_t l = 0; l < AUTH_LANES; l++) {
+            size_t m = first + (l < lanes && j < counts[l] ? l : 0);
+            block[l] = pad.data.data() + pad.offset[m] + (l < lanes && j < counts[l] ? j : 0) * SHA_BLOCK;
+        }
+        compressAvx2(s, block, _mm256_cmpgt_epi32(remaining, _mm256_set1_epi32(j)));
+    }
+
+    alignas(32) uint32_t words[8][AUTH_LANES];
+    for (int k = 0; k < 8; k++) {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(words[k]), s[k]);
+    }
+    for (size_t l = 0; l < lanes; l++) {
+        uint32_t state[8];
+        for (int k = 0; k < 8; k++) {
+            state[k] = words[k][l];
+        }
+        hexDigest(state, out + l * AUTH_HASH_SIZE);
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Определение лучшего ядра, поддерживаемого процессором
+ * @return AUTH_SHANI, AUTH_AVX2 или AUTH_CRYPTOPP
+ * @details SHA-NI обрабатывает одно сообщение быстрее, чем проход AVX2 —
+ *          восемь, поэтому предпочитается при наличии
+ */
+AuthKernel detectAuthKernel()
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1")) {
+        return AUTH_SHANI;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return AUTH_AVX2;
+    }
+    return AUTH_CRYPTOPP;
+}
+
+/**
+ * @brief Хеши многих пар соли и пароля заданным ядром
+ * @param[in] kernel Ядро (должно поддерживаться процессором)
+ * @param[in] salts Соли
+ * @param[in] passes Пароли
+ * @param[in] n Количество пар
+ * @param[out] out Буфер n * AUTH_HASH_SIZE символов
+ * @details Остаток пакета AVX2 менее AUTH_AVX2_MIN сообщений хешируется
+ *          CryptoPP: почти пустой проход медленнее отдельных вызовов
+ */
+void authBatchAt(AuthKernel kernel, const std::string_view* salts, const std::string_view* passes, size_t n, char* out)
+{
+    thread_local Padded padded;
+    size_t done = 0;
+    if (kernel == AUTH_SHANI) {
+        pad(padded, salts, passes, n);
+        for (; done < n; done++) {
+            uint32_t state[8];
+            memcpy(state, sha224Init, sizeof(state));
+            compressShaNi(state, padded.data.data() + padded.offset[done], padded.blocks[done]);
+            hexDigest(state, out + done * AUTH_HASH_SIZE);
+        }
+    } else if (kernel == AUTH_AVX2 && n >= AUTH_AVX2_MIN) {
+        pad(padded, salts, passes, n);
+        while (n - done >= AUTH_AVX2_MIN) {
+            size_t lanes = n - done < AUTH_LANES ? n - done : AUTH_LANES;
+            hashLanesAvx2(padded, done, lanes, out + done * AUTH_HASH_SIZE);
+            done += lanes;
+        }
+    }
+    for (; done < n; done++) {
+        authInto(salts[done], passes[done], out + done * AUTH_HASH_SIZE);
+    }
+}
+
+/**
+ * @brief Проверка многих хешей заданным ядром
+ * @param[in] kernel Ядро (должно поддерживаться процессором)
+ * @param[in,out] checks Проверки; заполняется поле verified
+ * @param[in] n Количество проверок
+ */
+void verifyBatchAt(AuthKernel kernel, AuthCheck* checks, size_t n)
+{
+    thread_local std::vector<std::string_view> salts, passes;
+    thread_local std::vector<char> hashes;
+    salts.resize(n);
+    passes.resize(n);
+    hashes.resize(n * AUTH_HASH_SIZE);
+    for (size_t i = 0; i < n; i++) {
+        salts[i] = checks[i].salt;
+        passes[i] = checks[i].pass;
+    }
+    authBatchAt(kernel, salts.data(), passes.data(), n, hashes.data());
+    for (size_t i = 0; i < n; i++) {
+        checks[i].verified = hashEquals(checks[i].hash, std::string_view(hashes.data() + i * AUTH_HASH_SIZE, AUTH_HASH_SIZE));
+    }
+}
+
+/**
+ * @brief Проверка многих хешей лучшим доступным ядром
+ * @param[in,out] checks Проверки; заполняется поле verified
+ * @param[in] n Количество проверок
+ */
+void verifyBatch(AuthCheck* checks, size_t n)
+{
+    static const AuthKernel kernel = detectAuthKernel();
+    verifyBatchAt(kernel, checks, n);
+}
@@ -0,0 +1,74 @@
+/**
+ * @file authbatch.h
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл пакетной проверки хешей паролей
+ * @details Содержит вычисление SHA224 соли и пароля сразу для многих
+ *          клиентов: инструкциями SHA-NI, восемью независимыми потоками
+ *          данных в регистрах AVX2 или, если процессор не поддерживает ни
+ *          того, ни другого, по одному сообщению через CryptoPP. SHA224
+ *          отличается от SHA256 только начальным состоянием и длиной
+ *          результата, поэтому ядра сжатия общие.
+ */
+
+#pragma once
+#include <cstddef>
+#include <string_view>
+
+/// Число сообщений, хешируемых одним проходом ядра AVX2
+#define AUTH_LANES 8
+
+/**
+ * @brief Ядро вычисления SHA224
+ */
+enum AuthKernel {
+    AUTH_CRYPTOPP = 0,  ///< По одному сообщению через CryptoPP (authInto)
+    AUTH_AVX2 = 1,      ///< Восемь сообщений одновременно в регистрах AVX2
+    AUTH_SHANI = 2      ///< Инструкции SHA-NI, по одному сообщению
+};
+
+/**
+ * @struct AuthCheck
+ * @brief Проверка хеша, присланного клиентом
+ */
+struct AuthCheck {
+    std::string_view salt;      ///< Соль
+    std::string_view pass;      ///< Пароль пользователя из базы
+    std::string_view hash;      ///< Хеш клиента в hex-формате
+    bool verified = false;      ///< Результат: хеш совпал
+};
+
+/**
+ * @brief Определение лучшего ядра, поддерживаемого процессором
+ * @return AUTH_SHANI, AUTH_AVX2 или AUTH_CRYPTOPP
+ */
+AuthKernel detectAuthKernel();
+
+/**
+ * @brief Хеши многих пар соли и пароля заданным ядром
+ * @param[in] kernel Ядро (должно поддерживаться процессором)
+ * @param[in] salts Соли
+ * @param[in] passes Пароли
+ * @param[in] n Количество пар
+ * @param[out] out Буфер n * AUTH_HASH_SIZE символов: хеши в формате auth() подряд
+ */
+void authBatchAt(AuthKernel kernel, const std::string_view* salts, const std::string_view* passes, size_t n, char* out);
+
+/**
+ * @brief Проверка многих хешей заданным ядром
+ * @param[in] kernel Ядро (должно поддерживаться процессором)
+ * @param[in,out] checks Проверки; заполняется поле verified
+ * @param[in] n Количество проверок
+ */
+void verifyBatchAt(AuthKernel kernel, AuthCheck* checks, size_t n);
+
+/**
+ * @brief Проверка многих хешей лучшим доступным ядром
+ * @param[in,out] checks Проверки; заполняется поле verified
+ * @param[in] n Количество проверок
+ * @details Хеши сравниваются за время, не зависящее от содержимого
+ *          (hashEquals)
+ */
+void verifyBatch(AuthCheck* checks, size_t n);
@@ -0,0 +1,493 @@
+/**
+ * @file bench.cpp
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Тесты производительности компонентов сервера
+ * @details Измеряет загрузку базы пользователей, поиск пользователя,
+ *          вычисление хеша аутентификации, форматирование временных
+ *          меток, запись журнала, суммирование квадратов векторов из
+ *          памяти и через пару сокетов, а также ядра свёртки. Результаты
+ *          выводятся таблицей, в CSV или JSON для сравнения между сборками.
+ */
+
+#include "authbatch.h"
+#include "connection.h"
+#include "crypto.h"
+#include "decoder.h"
+#include "log.h"
+#include "reduce.h"
+#include "simd.h"
+#include "userbase.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * @struct BenchResult
+ * @brief Одно измерение
+ */
+struct BenchResult {
+    std::string name;   ///< Название измерения
+    std::string param;  ///< Параметр измерения (размер, число записей/потоков)
+    double value;       ///< Значение
+    std::string unit;   ///< Единица измерения
+};
+
+/// Накопленные результаты измерений
+static std::vector<BenchResult> results;
+
+/**
+ * @brief Сохранение результата измерения
+ */
+static void record(const std::string& name, const std::string& param, double value, const std::string& unit)
+{
+    results.push_back({name, param, value, unit});
+}
+
+/**
+ * @brief Создание файла базы пользователей заданного размера
+ * @param[in] name Имя файла
+ * @param[in] lines Количество записей
+ */
+static void makeBase(const std::string& name, size_t lines)
+{
+    std::ofstream f(name);
+    for (size_t i = 0; i < lines; i++) {
+        if (i % 100 == 0) {
+            f << "# группа " << i / 100 << "\n";
+        }
+        f << "user" << i << ":" << "P@ss" << i * 7919 << "\n";
+    }
+}
+
+/**
+ * @brief Измерение лучшего времени из нескольких запусков
+ * @param[in] runs Количество запусков
+ * @param[in] fn Измеряемая функция
+ * @return Лучшее время в миллисекундах
+ */
+template <class F>
+static double bestOf(int runs, F fn)
+{
+    double best = 1e300;
+    for (int i = 0; i < runs; i++) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed.count() < best) {
+            best = elapsed.count();
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Тест времени загрузки базы пользователей
+ * @param[in] lines Количество записей в файле
+ */
+static void benchLoad(size_t lines)
+{
+    const std::string name = "bench_base.txt";
+    makeBase(name, lines);
+    size_t cores = std::thread::hardware_concurrency();
+    std::string param = std::to_string(lines);
+
+    record("load_getline", param, bestOf(3, [&] { UserBase b; b.loadStream(name); }), "ms");
+    record("load_pread_1_thread", param, bestOf(3, [&] { UserBase b; b.load(name, 1); }), "ms");
+    record("load_pread_parallel", param + "/" + std::to_string(cores), bestOf(3, [&] { UserBase b; b.load(name, cores); }), "ms");
+    std::remove(name.c_str());
+}
+
+/**
+ * @brief Тест поиска пользователя построчным чтением файла и в таблице
+ * @details Ищется последний пользователь файла — худший случай для
+ *          построчного поиска
+ */
+static void benchLookup()
+{
+    const std::string name = "bench_base.txt";
+    for (size_t lines : {1000, 10000, 100000}) {
+        makeBase(name, lines);
+        std::string user = "user" + std::to_string(lines - 1);
+        std::string param = std::to_string(lines);
+        std::string password;
+        size_t iterations = 10000000 / lines;
+
+        double scan = bestOf(3, [&] {
+            for (size_t i = 0; i < iterations; i++) {
+                findUserInFile(name, user, password);
+            }
+        });
+        record("find_user_in_file", param, scan * 1e6 / iterations, "ns/op");
+
+        UserBase base;
+        base.load(name);
+        size_t lookups = 1000000;
+        double table = bestOf(3, [&] {
+            for (size_t i = 0; i < lookups; i++) {
+                base.find(user, password);
+            }
+        });
+        record("user_base_find", param, table * 1e6 / lookups, "ns/op");
+    }
+    std::remove(name.c_str());
+}
+
+/**
+ * @brief Тест вычисления и сравнения хеша аутентификации
+ * @param[in] iterations Количество вызовов каждой функции
+ */
+static void benchAuth(size_t iterations)
+{
+    size_t sink = 0;
+    std::string param = std::to_string(iterations);
+    double legacy = bestOf(3, [&] {
+        for (size_t i = 0; i < iterations; i++) {
+            sink += auth(SALT, "P@ssW0rd").size();
+        }
+    });
+    record("auth", param, legacy * 1e6 / iterations, "ns/op");
+
+    char hash[AUTH_HASH_SIZE];
+    double into = bestOf(3, [&] {
+        for (size_t i = 0; i < iterations; i++) {
+            authInto(SALT, "P@ssW0rd", hash);
+            sink += hash[0];
+        }
+    });
+    record("auth_into", param, into * 1e6 / iterations, "ns/op");
+
+    std::string expected(hash, AUTH_HASH_SIZE);
+    double compare = bestOf(3, [&] {
+        for (size_t i = 0; i < iterations; i++) {
+            sink += hashEquals(expected, std::string_view(hash, AUTH_HASH_SIZE));
+        }
+    });
+    record("hash_equals", param, compare * 1e6 / iterations, "ns/op");
+
+    // Пакетная проверка хешей: число проверок в секунду на одном ядре
+    const char* kernels[] = {"cryptopp", "avx2", "shani"};
+    bool supported[] = {true, __builtin_cpu_supports("avx2") != 0, __builtin_cpu_supports("sha") != 0};
+    std::string client_hash = auth(SALT, "P@ssW0rd");
+    for (int k = AUTH_CRYPTOPP; k <= AUTH_SHANI; k++) {
+        if (!supported[k]) {
+            continue;
+        }
+        for (size_t batch : {size_t(1), size_t(AUTH_LANES), size_t(64)}) {
+            std::vector<AuthCheck> checks(batch, AuthCheck{SALT, "P@ssW0rd", client_hash});
+            size_t rounds = iterations / batch;
+            double ms = bestOf(3, [&] {
+                for (size_t i = 0; i < rounds; i++) {
+                    verifyBatchAt(static_cast<AuthKernel>(k), checks.data(), batch);
+                    sink += checks[0].verified;
+                }
+            });
+            record(std::string("verify_batch_") + kernels[k], std::to_string(batch), rounds * batch * 1e3 / ms, "verifications/s");
+        }
+    }
+    if (sink == 0) {
+        std::cerr << "пустой результат хеширования\n";
+    }
+}
+
+/**
+ * @brief Прежняя реализация getCurrentTime для сравнения
+ * @return Строка с текущим временем в формате "ГГГГ-ММ-ДД ЧЧ:ММ:СС.ммм"
+ */
+static std::string legacyCurrentTime()
+{
+    auto now = std::chrono::system_clock::now();
+    auto time_t = std::chrono::system_clock::to_time_t(now);
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        now.time_since_epoch()) % 1000;
+
+    std::stringstream ss;
+    ss << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
+    ss << "." << std::setfill('0') << std::setw(3) << ms.count();
+    return ss.str();
+}
+
+/**
+ * @brief Тест скорости форматирования временных меток
+ * @param[in] iterations Количество вызовов каждой функции
+ */
+static void benchTime(size_t iterations)
+{
+    size_t sink = 0;
+    std::string param = std::to_string(iterations);
+    double legacy = bestOf(3, [&] {
+        for (size_t i = 0; i < iterations; i++) {
+            sink += legacyCurrentTime().size();
+        }
+    });
+    double cached = bestOf(3, [&] {
+        for (size_t i = 0; i < iterations; i++) {
+            sink += getCurrentTime().size();
+        }
+    });
+    double buffer = bestOf(3, [&] {
+        char stamp[TIME_STAMP_SIZE];
+        for (size_t i = 0; i < iterations; i++) {
+            sink += formatCurrentTime(stamp) + stamp[22];
+        }
+    });
+    if (legacyCurrentTime().size() != getCurrentTime().size()) {
+        std::cerr << "формат временной метки не совпадает\n";
+    }
+    record("time_stringstream", param, legacy * 1e6 / iterations, "ns/op");
+    record("get_current_time", param, cached * 1e6 / iterations, "ns/op");
+    record("format_current_time", param, buffer * 1e6 / iterations, "ns/op");
+}
+
+/**
+ * @brief Тест записи журнала напрямую и через фоновый поток
+ * @param[in] iterations Количество сообщений в очередь; напрямую пишется
+ *            в десять раз меньше, так как каждая запись открывает файл
+ */
+static void benchLog(size_t iterations)
+{
+    const std::string name = "bench_log.txt";
+    size_t direct = iterations / 10;
+    double written = bestOf(1, [&] {
+        for (size_t i = 0; i < direct; i++) {
+            logError(name, "Ошибка recv (элемент 1 вектора 1): Connection reset by peer");
+        }
+    });
+    record("log_error_direct", std::to_string(direct), written * 1e6 / direct, "ns/op");
+
+    startLogger(8192, 100, LOG_BLOCK);
+    double queued = bestOf(1, [&] {
+        for (size_t i = 0; i < iterations; i++) {
+            logError(name, "Ошибка recv (элемент 1 вектора 1): Connection reset by peer");
+        }
+    });
+    double drained = bestOf(1, [] { stopLogger(); });
+    record("log_error_queued", std::to_string(iterations), queued * 1e6 / iterations, "ns/op");
+    record("log_error_queued_drain", std::to_string(iterations), drained, "ms");
+    std::remove(name.c_str());
+}
+
+/**
+ * @brief Формирование потока векторов в формате протокола
+ * @param[in] size Размер одного вектора
+ * @param[in] count Количество векторов
+ * @return Количество векторов, затем для каждого размер и элементы
+ */
+static std::string makeStream(uint32_t size, uint32_t count)
+{
+    std::string stream(sizeof(uint32_t) + static_cast<size_t>(count) * (size + 1) * sizeof(int32_t), '\0');
+    char* p = &stream[0];
+    memcpy(p, &count, sizeof(count));
+    p += sizeof(count);
+    for (uint32_t v = 0; v < count; v++) {
+        memcpy(p, &size, sizeof(size));
+        p += sizeof(size);
+        for (uint32_t i = 0; i < size; i++) {
+            int32_t x = static_cast<int32_t>((v * 31 + i) % 2001) - 1000;
+            memcpy(p, &x, sizeof(x));
+            p += sizeof(x);
+        }
+    }
+    return stream;
+}
+
+/**
+ * @brief Тест суммирования квадратов векторов
+ * @details Для каждого размера вектора измеряются ядро sumSquares на
+ *          непрерывном массиве, декодер на буфере в памяти и полный цикл
+ *          datawrite, получающий поток через пару сокетов
+ * @param[in] bytes Приблизительный объём потока векторов, байт
+ */
+static void benchSumSquares(size_t bytes)
+{
+    for (uint32_t size : {16u, 4096u}) {
+        uint32_t count = static_cast<uint32_t>(bytes / ((size + 1) * sizeof(int32_t)));
+        std::string stream = makeStream(size, count);
+        std::string param = std::to_string(size);
+        double megabytes = stream.size() / 1e6;
+        int32_t sink = 0;
+
+        std::vector<int32_t> flat(static_cast<size_t>(size) * count);
+        for (size_t i = 0; i < flat.size(); i++) {
+            flat[i] = static_cast<int32_t>(i % 2001) - 1000;
+        }
+        double kernel = bestOf(3, [&] {
+            for (uint32_t v = 0; v < count; v++) {
+                sink += sumSquares(flat.data() + static_cast<size_t>(v) * size, size);
+            }
+        });
+        record("sum_squares_kernel", param, megabytes * 1e3 / kernel, "MB/s");
+
+        std::string out;
+        out.reserve(static_cast<size_t>(count) * sizeof(int32_t));
+        double memory = bestOf(3, [&] {
+            VectorDecoder decoder;
+            out.clear();
+            size_t offset = 0;
+            while (!decoder.done()) {
+                offset += decoder.feed(stream.data() + offset, stream.size() - offset, out);
+            }
+        });
+        record("decoder_memory", param, megabytes * 1e3 / memory, "MB/s");
+
+        Params p;
+        p.logFile = "bench_log.txt";
+        p.RecvBuffer = 262144;
+        p.ResultBatch = 64;
+        p.HeaderTimeout = p.VectorTimeout = p.IdleTimeout = 0;
+        double socket = bestOf(3, [&] {
+            int sv[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1) {
+                throw std::system_error(errno, std::generic_category());
+            }
+            std::thread writer([&] {
+                size_t sent = 0;
+                while (sent < stream.size()) {
+                    ssize_t n = send(sv[1], stream.data() + sent, stream.size() - sent, MSG_NOSIGNAL);
+                    if (n <= 0) {
+                        break;
+                    }
+                    sent += n;
+                }
+            });
+            std::thread reader([&] {
+                std::vector<char> buffer(static_cast<size_t>(count) * sizeof(int32_t));
+                size_t got = 0;
+                while (got < buffer.size()) {
+                    ssize_t n = recv(sv[1], buffer.data() + got, buffer.size() - got, 0);
+                    if (n <= 0) {
+                        break;
+                    }
+                    got += n;
+                }
+            });
+            datawrite(sv[0], &p);
+            writer.join();
+            reader.join();
+            close(sv[0]);
+            close(sv[1]);
+        });
+        record("datawrite_socketpair", param, megabytes * 1e3 / socket, "MB/s");
+        if (sink == 1) {
+            std::cerr << "\n";
+        }
+    }
+}
+
+/**
+ * @brief Тест ядер свёртки
+ * @details Для каждой пары операция/тип измеряется ядро, выбранное по
+ *          набору инструкций процессора, и скалярный эталон на массиве
+ *          заданного объёма
+ * @param[in] bytes Объём массива элементов, байт
+ */
+static void benchReduce(size_t bytes)
+{
+    const char* ops[] = {"sumsq", "sum", "min", "max", "dot", "l1", "l2"};
+    const char* types[] = {"int32", "int64", "float", "double"};
+    std::vector<char> data(bytes);
+    for (size_t i = 0; i + sizeof(int32_t) <= data.size(); i += sizeof(int32_t)) {
+        int32_t x = static_cast<int32_t>(i % 2001) - 1000;
+        memcpy(&data[i], &x, sizeof(x));
+    }
+    double megabytes = bytes / 1e6;
+    double sink = 0;
+    for (int t = ELEM_INT32; t <= ELEM_DOUBLE; t++) {
+        ElementType type = static_cast<ElementType>(t);
+        size_t n = bytes / elementSize(type) / 2 * 2;
+        for (int o = OP_SUM_SQUARES; o <= OP_L2; o++) {
+            Operation op = static_cast<Operation>(o);
+            std::string param = std::string(ops[o]) + "/" + types[t];
+            for (SimdLevel level : {SIMD_SCALAR, detectSimdLevel()}) {
+                ReduceKernel kernel = reduceKernelAt(level, op, type);
+                double elapsed = bestOf(3, [&] {
+                    Reduction r = reduceInit(op, type);
+                    kernel(data.data(), n, r);
+                    sink += r.real + static_cast<double>(r.exact);
+                });
+                record(level == SIMD_SCALAR ? "reduce_scalar" : "reduce_dispatch", param, megabytes * 1e3 / elapsed, "MB/s");
+            }
+        }
+    }
+    if (sink == 1) {
+        std::cerr << "\n";
+    }
+}
+
+/**
+ * @brief Вывод результатов в выбранном формате
+ * @param[in] format text, csv или json
+ */
+static void printResults(const std::string& format)
+{
+    if (format == "csv") {
+        std::cout << "name,param,value,unit\n";
+        for (const auto& r : results) {
+            std::cout << r.name << "," << r.param << "," << r.value << "," << r.unit << "\n";
+        }
+    } else if (format == "json") {
+        std::cout << "[\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            const auto& r = results[i];
+            std::cout << "  {\"name\": \"" << r.name << "\", \"param\": \"" << r.param
+                      << "\", \"value\": " << r.value << ", \"unit\": \"" << r.unit << "\"}"
+                      << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        std::cout << "]\n";
+    } else {
+        for (const auto& r : results) {
+            std::cout << std::left << std::setw(28) << r.name << std::setw(10) << r.param
+                      << std::right << std::setw(14) << r.value << " " << r.unit << "\n";
+        }
+    }
+}
+
+/**
+ * @brief Точка входа тестов производительности
+ * @param[in] argc Количество аргументов
+ * @param[in] argv Аргументы: [--format text|csv|json] [число записей в базе,
+ *            по умолчанию 1000000]
+ * @return 0 при успехе, 1 при неверных аргументах
+ */
+int main(int argc, char** argv)
+{
+    std::string format = "text";
+    size_t lines = 1000000;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--format" && i + 1 < argc) {
+            format = argv[++i];
+        } else if (!arg.empty() && isdigit(static_cast<unsigned char>(arg[0]))) {
+            lines = std::stoul(arg);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--format text|csv|json] [lines]\n";
+            return 1;
+        }
+    }
+    if (format != "text" && format != "csv" && format != "json") {
+        std::cerr << "Unknown format: " << format << "\n";
+        return 1;
+    }
+
+    benchLoad(lines);
+    benchLookup();
+    benchAuth(1000000);
+    benchTime(1000000);
+    benchLog(200000);
+    benchSumSquares(64 << 20);
+    benchReduce(16 << 20);
+    std::remove("bench_log.txt");
+    printResults(format);
+    return 0;
+}
@@ -0,0 +1,650 @@
+/**
+ * @file client.cpp
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Клиент нагрузочного тестирования сервера
+ * @details Открывает заданное число параллельных соединений, в каждом
+ *          повторяет полный сеанс протокола (логин, соль, SHA224 хеш,
+ *          векторы, результаты) в течение заданного времени и выводит
+ *          пропускную способность и задержки. В протоколе версии 2 клиент
+ *          запоминает соль первого сеанса и в следующих отправляет логин,
+ *          хеш и первые векторы одной передачей, а если сервер выдал билет
+ *          возобновления — билет вместо логина и хеша.
+ */
+
+#include "crypto.h"
+#include "decoder.h"
+#include "frame.h"
+#include "simd.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <random>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace po = boost::program_options;
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @struct Distribution
+ * @brief Распределение количества или размера векторов
+ * @details Задаётся строкой: "N" — постоянное значение, "A:B" — равномерное
+ *          на отрезке, "exp:M" — экспоненциальное со средним M
+ */
+struct Distribution {
+    enum Kind { FIXED, UNIFORM, EXPONENTIAL } kind = FIXED;
+    uint32_t a = 0;     ///< Значение, нижняя граница или среднее
+    uint32_t b = 0;     ///< Верхняя граница равномерного распределения
+
+    /**
+     * @brief Разбор описания распределения
+     * @param[in] spec Строка описания
+     * @return Распределение
+     * @throw std::invalid_argument при неверном описании
+     */
+    static Distribution parse(const std::string& spec) {
+        Distribution d;
+        size_t colon = spec.find(':');
+        if (spec.compare(0, 4, "exp:") == 0) {
+            d.kind = EXPONENTIAL;
+            d.a = std::stoul(spec.substr(4));
+        } else if (colon != std::string::npos) {
+            d.kind = UNIFORM;
+            d.a = std::stoul(spec.substr(0, colon));
+            d.b = std::stoul(spec.substr(colon + 1));
+            if (d.b < d.a) {
+                throw std::invalid_argument("empty range: " + spec);
+            }
+        } else {
+            d.a = std::stoul(spec);
+        }
+        return d;
+    }
+
+    /**
+     * @brief Очередное значение
+     * @param[in,out] rng Генератор случайных чисел потока
+     * @return Значение
+     */
+    uint32_t next(std::mt19937& rng) const {
+        switch (kind) {
+        case UNIFORM:
+            return std::uniform_int_distribution<uint32_t>(a, b)(rng);
+        case EXPONENTIAL:
+            return static_cast<uint32_t>(std::exponential_distribution<double>(1.0 / std::max<uint32_t>(a, 1))(rng));
+        default:
+            return a;
+        }
+    }
+};
+
+/**
+ * @struct Options
+ * @brief Параметры нагрузки
+ */
+struct Options {
+    std::string address;        ///< Адрес сервера
+    int port;                   ///< Порт сервера
+    std::string login;          ///< Логин
+    std::string password;       ///< Пароль
+    int connections;            ///< Число параллельных соединений
+    double duration;            ///< Длительность теста, с
+    Distribution count;         ///< Количество векторов в сеансе
+    Distribution size;          ///< Размер вектора
+    bool pipeline;              ///< Отправлять все векторы не дожидаясь результатов
+    Accumulation acc;           ///< Режим накопления результата
+    Operation op;               ///< Операция свёртки
+    ElementType type;           ///< Тип элементов
+    int32_t range;              ///< Максимальный модуль элемента
+    int proto;                  ///< Версия протокола: 1 или 2
+};
+
+/**
+ * @struct Stats
+ * @brief Результаты одного потока нагрузки
+ */
+struct Stats {
+    uint64_t sessions = 0;              ///< Завершённые сеансы
+    uint64_t vectors = 0;               ///< Обработанные векторы
+    uint64_t bytes = 0;                 ///< Байт данных векторов и результатов
+    uint64_t errors = 0;                ///< Ошибки соединения и протокола
+    uint64_t mismatches = 0;            ///< Неверные результаты
+    std::vector<uint32_t> loginLatency;     ///< Задержки входа, мкс
+    std::vector<uint32_t> vectorLatency;    ///< Задержки векторов, мкс
+    std::vector<uint32_t> sessionLatency;   ///< Длительность сеансов, мкс
+};
+
+/**
+ * @brief Отправка всех данных
+ * @return false при ошибке
+ */
+static bool sendAll(int fd, const void* data, size_t len)
+{
+    const char* p = static_cast<const char*>(data);
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+/**
+ * @brief Приём ровно len байт
+ * @return false при ошибке или закрытии соединения
+ */
+static bool recvAll(int fd, void* data, size_t len)
+{
+    char* p = static_cast<char*>(data);
+    while (len > 0) {
+        ssize_t n = recv(fd, p, len, 0);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+/**
+ * @brief Приём одного кадра протокола версии 2
+ * @param[out] h Заголовок кадра
+ * @param[out] payload Данные кадра
+ * @return false при ошибке или закрытии соединения
+ */
+static bool recvFrame(int fd, FrameHeader& h, std::string& payload)
+{
+    char header[sizeof(FrameHeader)];
+    if (!recvAll(fd, header, sizeof(header))) {
+        return false;
+    }
+    h = readFrameHeader(header);
+    payload.resize(h.length);
+    return recvAll(fd, &payload[0], h.length);
+}
+
+/**
+ * @class Channel
+ * @brief Обмен векторами и результатами в выбранной версии протокола
+ * @details В версии 2 данные передаются кадрами FRAME_VECTORS, а при приёме
+ *          результатов попутно разбираются кадры соли, билета и результата
+ *          аутентификации, если клиент отправил хеш не дожидаясь их
+ */
+class Channel
+{
+    int fd;                         ///< Сокет
+    bool framed;                    ///< Протокол версии 2
+    std::string queued;             ///< Данные, ожидающие отправки одной передачей
+    std::string received;           ///< Принятые, но не выданные результаты
+    Clock::time_point authorized;   ///< Момент получения FRAME_OK
+    bool ok = false;                ///< Аутентификация подтверждена
+    std::string issued;             ///< Билет возобновления из FRAME_TICKET
+
+public:
+    Channel(int fd, bool framed) : fd(fd), framed(framed) {}
+
+    /**
+     * @brief Данные для отправки вместе со следующей порцией векторов
+     * @param[in] data Уже оформленные данные (признак протокола и кадры)
+     */
+    void hold(const std::string& data) {
+        queued += data;
+    }
+
+    /**
+     * @brief Отправка части потока векторов
+     * @param[in] more true если следующая часть будет отправлена той же передачей
+     * @return false при ошибке
+     */
+    bool send(const void* data, size_t len, bool more) {
+        if (framed) {
+            appendFrame(queued, FRAME_VECTORS, static_cast<const char*>(data), len);
+        } else {
+            queued.append(static_cast<const char*>(data), len);
+        }
+        if (more) {
+            return true;
+        }
+        bool sent = sendAll(fd, queued.data(), queued.size());
+        queued.clear();
+        return sent;
+    }
+
+    /**
+     * @brief Приём кадра с подтверждением аутентификации
+     * @return false при ошибке или отказе сервера
+     */
+    bool waitAuthorized() {
+        FrameHeader h;
+        std::string payload;
+        while (!ok) {
+            if (!recvFrame(fd, h, payload) || h.type == FRAME_ERR || h.type == FRAME_RESULTS) {
+                return false;
+            }
+            if (h.type == FRAME_OK) {
+                ok = true;
+                authorized = Clock::now();
+            } else if (h.type == FRAME_TICKET) {
+                issued = payload;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Приём len байт результатов
+     * @return false при ошибке или закрытии соединения
+     */
+    bool recv(void* data, size_t len) {
+        if (!framed) {
+            return recvAll(fd, data, len);
+        }
+        if (!waitAuthorized()) {
+            return false;
+        }
+        FrameHeader h;
+        std::string payload;
+        while (received.size() < len) {
+            if (!recvFrame(fd, h, payload) || h.type != FRAME_RESULTS) {
+                return false;
+            }
+            received += payload;
+        }
+        memcpy(data, received.data(), len);
+        received.erase(0, len);
+        return true;
+    }
+
+    /**
+     * @brief Билет для следующего сеанса
+     * @return Билет, выданный сервером, или пустая строка
+     */
+    const std::string& ticket() const {
+        return issued;
+    }
+
+    /**
+     * @brief Момент подтверждения аутентификации
+     * @return Время получения FRAME_OK
+     */
+    Clock::time_point authorizedAt() const {
+        return authorized;
+    }
+};
+
+/**
+ * @brief Микросекунды между двумя моментами
+ */
+static uint32_t micros(Clock::time_point from, Clock::time_point to)
+{
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(to - from).count());
+}
+
+/**
+ * @brief Ожидаемый ответ сервера на вектор
+ * @param[in] o Параметры нагрузки
+ * @param[in] elements Элементы вектора в формате протокола
+ * @return Результат, вычисленный скалярным ядром
+ */
+static std::string expectedResult(const Options& o, const std::string& elements)
+{
+    Reduction r = reduceInit(o.op, o.type);
+    reduceKernelAt(SIMD_SCALAR, o.op, o.type)(elements.data(), elements.size() / elementSize(o.type), r);
+    std::string out;
+    reduceFinish(o.op, o.type, o.acc, r, out);
+    return out;
+}
+
+/**
+ * @brief Сравнение ответа сервера с ожидаемым
+ * @param[in] o Параметры нагрузки
+ * @param[in] got Ответ сервера
+ * @param[in] expected Ожидаемый результат
+ * @return true если результаты совпадают
+ * @details Вещественные результаты сравниваются с относительной
+ *          погрешностью: порядок сложения на сервере зависит от ширины
+ *          векторных регистров
+ */
+static bool sameResult(const Options& o, const char* got, const std::string& expected)
+{
+    if (memcmp(got, expected.data(), expected.size()) == 0) {
+        return true;
+    }
+    if (o.type == ELEM_FLOAT) {
+        float a, b;
+        memcpy(&a, got, sizeof(a));
+        memcpy(&b, expected.data(), sizeof(b));
+        return std::fabs(a - b) <= 1e-6f * std::max(1.0f, std::fabs(b));
+    }
+    if (o.type == ELEM_DOUBLE || o.op == OP_L2) {
+        double a, b;
+        memcpy(&a, got, sizeof(a));
+        memcpy(&b, expected.data(), sizeof(b));
+        return std::fabs(a - b) <= 1e-12 * std::max(1.0, std::fabs(b));
+    }
+    return false;
+}
+
+/**
+ * @brief Запись элемента заданного типа
+ * @param[out] out Элементы вектора
+ * @param[in] type Тип элементов
+ * @param[in] value Значение
+ */
+static void appendElement(std::string& out, ElementType type, int32_t value)
+{
+    switch (type) {
+    case ELEM_INT64: {
+        int64_t v = value;
+        out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+        break;
+    }
+    case ELEM_FLOAT: {
+        float v = static_cast<float>(value);
+        out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+        break;
+    }
+    case ELEM_DOUBLE: {
+        double v = value;
+        out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+        break;
+    }
+    default:
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        break;
+    }
+}
+
+/**
+ * @brief Вход по протоколу версии 2
+ * @param[in] fd Сокет
+ * @param[in] o Параметры нагрузки
+ * @param[in,out] salt Соль прошлого сеанса или пустая строка
+ * @param[in] ticket Билет прошлого сеанса или пустая строка
+ * @param[out] ch Канал, в котором оставляются кадры для конвейерной отправки
+ * @return false при ошибке
+ * @details Билет или, если соль известна, логин и хеш не отправляются
+ *          сразу, а уходят одной передачей с первыми векторами; иначе клиент
+ *          ждёт FRAME_SALT, как в исходном протоколе
+ */
+static bool framedLogin(int fd, const Options& o, std::string& salt, const std::string& ticket, Channel& ch)
+{
+    std::string hello(FRAME_MAGIC, FRAME_MAGIC_SIZE);
+    if (!ticket.empty()) {
+        appendFrame(hello, FRAME_RESUME, ticket.data(), ticket.size());
+        ch.hold(hello);
+        return true;
+    }
+    appendFrame(hello, FRAME_LOGIN, o.login.data(), o.login.size());
+    if (salt.empty()) {
+        FrameHeader h;
+        if (!sendAll(fd, hello.data(), hello.size()) || !recvFrame(fd, h, salt) || h.type != FRAME_SALT) {
+            salt.clear();
+            return false;
+        }
+        hello.clear();
+    }
+    std::string hash = auth(salt, o.password);
+    appendFrame(hello, FRAME_HASH, hash.data(), hash.size());
+    ch.hold(hello);
+    return true;
+}
+
+/**
+ * @brief Один сеанс протокола
+ * @param[in] o Параметры нагрузки
+ * @param[in,out] rng Генератор случайных чисел
+ * @param[in,out] st Статистика потока
+ * @param[in,out] salt Соль сервера, запомненная потоком для протокола версии 2
+ * @param[in,out] ticket Билет возобновления для следующего сеанса
+ * @return false при ошибке
+ */
+static bool runSession(const Options& o, std::mt19937& rng, Stats& st, std::string& salt, std::string& ticket)
+{
+    auto start = Clock::now();
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == -1) {
+        return false;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(o.port);
+    addr.sin_addr.s_addr = inet_addr(o.address.c_str());
+
+    Channel ch(fd, o.proto == 2);
+    bool ok = connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    if (ok && o.proto == 2) {
+        ok = framedLogin(fd, o, salt, ticket, ch);
+        ticket.clear(); // Билет одноразовый
+    } else if (ok) {
+        char buffer[1024];
+        ssize_t n = sendAll(fd, o.login.data(), o.login.size()) ? recv(fd, buffer, sizeof(buffer), 0) : -1;
+        ok = n > 0 && std::string(buffer, n) != "ERR_USER_NOT_FOUND";
+        if (ok) {
+            std::string hash = auth(std::string(buffer, n), o.password);
+            n = sendAll(fd, hash.data(), hash.size()) ? recv(fd, buffer, sizeof(buffer), 0) : -1;
+            ok = n == 2 && memcmp(buffer, "OK", 2) == 0;
+        }
+        if (ok) {
+            st.loginLatency.push_back(micros(start, Clock::now()));
+        }
+    }
+    if (!ok) {
+        close(fd);
+        return false;
+    }
+
+    uint32_t count = o.count.next(rng);
+    std::vector<uint32_t> sizes(count);
+    std::vector<std::string> vectors(count);
+    std::uniform_int_distribution<int32_t> value(-o.range, o.range);
+    size_t per_unit = o.op == OP_DOT ? 2 : 1;
+    for (uint32_t i = 0; i < count; i++) {
+        sizes[i] = o.size.next(rng);
+        for (size_t k = 0; k < sizes[i] * per_unit; k++) {
+            appendElement(vectors[i], o.type, value(rng));
+        }
+    }
+
+    // Режим, отличный от исходного, передаётся расширенным заголовком
+    size_t result_size = reduceResultSize(o.op, o.type, o.acc);
+    uint32_t mode = MODE_WORD(o.acc, o.op, o.type);
+    uint32_t header[2] = {count, mode};
+    // Заголовок уходит вместе с первым вектором
+    if (mode != 0) {
+        header[0] |= BATCH_EXTENDED;
+        ok = ch.send(header, sizeof(header), count > 0);
+    } else {
+        ok = ch.send(header, sizeof(header[0]), count > 0);
+    }
+    std::vector<char> results(count * result_size);
+    std::vector<char> packet;
+    for (uint32_t i = 0; ok && i < count; i++) {
+        packet.resize(sizeof(sizes[i]) + vectors[i].size());
+        memcpy(packet.data(), &sizes[i], sizeof(sizes[i]));
+        memcpy(packet.data() + sizeof(sizes[i]), vectors[i].data(), vectors[i].size());
+        auto sent = Clock::now();
+        ok = ch.send(packet.data(), packet.size(), o.pipeline && i + 1 < count);
+        if (ok && !o.pipeline) {
+            ok = ch.recv(results.data() + i * result_size, result_size);
+            st.vectorLatency.push_back(micros(sent, Clock::now()));
+        }
+        st.bytes += packet.size() + result_size;
+    }
+    if (ok && o.pipeline && count > 0) {
+        ok = ch.recv(results.data(), results.size());
+    }
+    if (ok && o.proto == 2) {
+        ok = ch.waitAuthorized();
+        if (ok) {
+            st.loginLatency.push_back(micros(start, ch.authorizedAt()));
+        }
+    }
+    if (!ok && o.proto == 2) {
+        salt.clear(); // Соль могла смениться: следующий сеанс запросит её заново
+    } else if (o.proto == 2) {
+        ticket = ch.ticket();
+    }
+    close(fd);
+    if (!ok) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (!sameResult(o, results.data() + i * result_size, expectedResult(o, vectors[i]))) {
+            st.mismatches++;
+        }
+    }
+    st.vectors += count;
+    st.sessions++;
+    st.sessionLatency.push_back(micros(start, Clock::now()));
+    return true;
+}
+
+/**
+ * @brief Вывод процентилей задержки
+ * @param[in] name Название измерения
+ * @param[in,out] v Задержки, мкс (сортируются)
+ */
+static void printLatency(const char* name, std::vector<uint32_t>& v)
+{
+    if (v.empty()) {
+        return;
+    }
+    std::sort(v.begin(), v.end());
+    auto at = [&](double q) { return v[std::min(v.size() - 1, static_cast<size_t>(q * v.size()))]; };
+    std::cout << name << " latency, us: p50 " << at(0.5) << ", p99 " << at(0.99)
+              << ", p999 " << at(0.999) << ", max " << v.back() << "\n";
+}
+
+/**
+ * @brief Точка входа клиента нагрузочного тестирования
+ * @param[in] argc Количество аргументов
+ * @param[in] argv Аргументы командной строки
+ * @return 0 при успехе, 1 при ошибке параметров или отсутствии успешных сеансов
+ */
+int main(int argc, const char** argv)
+{
+    Options o;
+    std::string count, size, accumulate, op, type;
+    po::options_description desc("Allowed options");
+    desc.add_options()
+    ("help,h", "Show help")
+    ("address,a", po::value<std::string>(&o.address)->default_value("127.0.0.1"), "Set server address")
+    ("port,p", po::value<int>(&o.port)->required(), "Set server port")
+    ("user,u", po::value<std::string>(&o.login)->default_value("user"), "Set login")
+    ("password,w", po::value<std::string>(&o.password)->default_value("P@ssW0rd"), "Set password")
+    ("connections,c", po::value<int>(&o.connections)->default_value(1), "Set number of concurrent connections")
+    ("duration,d", po::value<double>(&o.duration)->default_value(10), "Set test duration in seconds")
+    ("vectors,n", po::value<std::string>(&count)->default_value("10"), "Set vectors per session: N, A:B (uniform) or exp:MEAN")
+    ("size,s", po::value<std::string>(&size)->default_value("100"), "Set vector size: N, A:B (uniform) or exp:MEAN")
+    ("pipeline", po::bool_switch(&o.pipeline), "Send all vectors before reading results")
+    ("accumulate", po::value<std::string>(&accumulate)->default_value("wrap32"), "Set accumulation mode: wrap32, int64, uint64 or sat32")
+    ("op", po::value<std::string>(&op)->default_value("sumsq"), "Set operation: sumsq, sum, min, max, dot, l1 or l2")
+    ("type", po::value<std::string>(&type)->default_value("int32"), "Set element type: int32, int64, float or double")
+    ("range", po::value<int32_t>(&o.range)->default_value(1000), "Set maximum element magnitude")
+    ("proto", po::value<int>(&o.proto)->default_value(1), "Set protocol version: 1 (message per round trip) or 2 (framed, pipelined login)");
+
+    try {
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        if (argc == 1 || vm.count("help")) {
+            std::cout << desc << std::endl;
+            return 1;
+        }
+        po::notify(vm);
+        o.count = Distribution::parse(count);
+        o.size = Distribution::parse(size);
+        const char* modes[] = {"wrap32", "int64", "uint64", "sat32"};
+        auto mode = std::find(std::begin(modes), std::end(modes), accumulate);
+        if (mode == std::end(modes)) {
+            throw po::validation_error(po::validation_error::invalid_option_value, "accumulate", accumulate);
+        }
+        o.acc = static_cast<Accumulation>(mode - std::begin(modes));
+        const char* ops[] = {"sumsq", "sum", "min", "max", "dot", "l1", "l2"};
+        auto operation = std::find(std::begin(ops), std::end(ops), op);
+        if (operation == std::end(ops)) {
+            throw po::validation_error(po::validation_error::invalid_option_value, "op", op);
+        }
+        o.op = static_cast<Operation>(operation - std::begin(ops));
+        const char* types[] = {"int32", "int64", "float", "double"};
+        auto element = std::find(std::begin(types), std::end(types), type);
+        if (element == std::end(types)) {
+            throw po::validation_error(po::validation_error::invalid_option_value, "type", type);
+        }
+        o.type = static_cast<ElementType>(element - std::begin(types));
+        if (o.type != ELEM_INT32 && o.acc != ACC_WRAP32) {
+            throw po::validation_error(po::validation_error::invalid_option_value, "accumulate", accumulate);
+        }
+        if (o.range < 0) {
+            throw po::validation_error(po::validation_error::invalid_option_value, "range", std::to_string(o.range));
+        }
+        if (o.proto != 1 && o.proto != 2) {
+            throw po::validation_error(po::validation_error::invalid_option_value, "proto", std::to_string(o.proto));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n" << desc << std::endl;
+        return 1;
+    }
+
+    std::vector<Stats> stats(std::max(o.connections, 1));
+    std::vector<std::thread> workers;
+    auto start = Clock::now();
+    auto deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(o.duration));
+    for (size_t i = 0; i < stats.size(); i++) {
+        workers.emplace_back([&, i]() {
+            std::mt19937 rng(static_cast<uint32_t>(i) * 7919 + 1);
+            std::string salt, ticket;
+            while (Clock::now() < deadline) {
+                bool resumed = !ticket.empty();
+                // Билет, отклонённый после перезапуска сервера, заменяется полным входом
+                if (!runSession(o, rng, stats[i], salt, ticket) && (!resumed || !runSession(o, rng, stats[i], salt, ticket))) {
+                    stats[i].errors++;
+                }
+            }
+        });
+    }
+    for (auto& t : workers) {
+        t.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    Stats total;
+    for (auto& s : stats) {
+        total.sessions += s.sessions;
+        total.vectors += s.vectors;
+        total.bytes += s.bytes;
+        total.errors += s.errors;
+        total.mismatches += s.mismatches;
+        total.loginLatency.insert(total.loginLatency.end(), s.loginLatency.begin(), s.loginLatency.end());
+        total.vectorLatency.insert(total.vectorLatency.end(), s.vectorLatency.begin(), s.vectorLatency.end());
+        total.sessionLatency.insert(total.sessionLatency.end(), s.sessionLatency.begin(), s.sessionLatency.end());
+    }
+    std::cout << "connections: " << stats.size() << ", duration: " << seconds << " s\n"
+              << "sessions: " << total.sessions << ", errors: " << total.errors
+              << ", wrong results: " << total.mismatches << "\n"
+              << "logins/sec: " << total.loginLatency.size() / seconds << "\n"
+              << "vectors/sec: " << total.vectors / seconds << "\n"
+              << "MB/s: " << total.bytes / seconds / 1e6 << "\n";
+    printLatency("login", total.loginLatency);
+    printLatency("vector", total.vectorLatency);
+    printLatency("session", total.sessionLatency);
+    return total.sessions > 0 ? 0 : 1;
+}
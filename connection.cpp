@@ -24,6 +24,25 @@
 #include <arpa/inet.h>
 #include <memory>
 #include <system_error>
+#include <csignal>
+#include "threadpool.h"
+#include "reactor.h"
+#include "uring.h"
+#include "decoder.h"
+#include "metrics.h"
+#include "reload.h"
+#include "parallel.h"
+#include "timeout.h"
+#include "session.h"
+#include "ticket.h"
+#include "authbatch.h"
+#include "admission.h"
+#include "handoff.h"
+#include <exception>
+#include <thread>
+#include <pthread.h>
+#include <sched.h>
+#include <vector>
 
 using namespace std;
 
@@ -33,6 +52,8 @@ using namespace std;
  * @param username Логин пользователя для поиска
  * @param[out] password Найденный пароль пользователя
  * @return true если пользователь найден, иначе false
+ * @details Последовательный просмотр файла. Сервер ищет пользователей
+ *          в индексе UserBase, построенном по тем же правилам разбора.
  */
 bool findUserInFile(const std::string& filename, const std::string& username, std::string& password) {
     std::ifstream file(filename);
@@ -74,201 +95,391 @@ bool findUserInFile(const std::string& filename, const std::string& username, st
     return false;
 }
 
+/**
+ * @brief Отправка накопленных результатов векторов
+ * @param client_socket Дескриптор сокета клиента
+ * @param p Указатель на структуру параметров соединения
+ * @param[in,out] results Результаты, ожидающие отправки (очищаются)
+ * @param[in,out] sent_vectors Количество уже отправленных результатов
+ * @param result_size Размер результата одного вектора в байтах
+ * @throw std::system_error при ошибке отправки
+ */
+static void sendResults(int client_socket, const Params* p, std::string& results, uint32_t& sent_vectors, size_t result_size) {
+    size_t sent = 0;
+    while (sent < results.size()) {
+        ssize_t send_result = send(client_socket, results.data() + sent, results.size() - sent, 0);
+        if (send_result == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::string errorMsg = "Ошибка send (результат вектора " + std::to_string(sent_vectors) + "): " + std::string(strerror(errno));
+            logError(p->logFile, errorMsg);
+            close(client_socket);
+            throw std::system_error(errno, std::generic_category());
+        }
+        sent += send_result;
+    }
+    metricAdd(MET_BYTES_OUT, results.size());
+    sent_vectors += results.size() / result_size;
+    results.clear();
+}
+
+/**
+ * @brief Ограничение ожидания в блокирующих recv и send
+ * @param client_socket Дескриптор сокета клиента
+ * @param p Указатель на структуру параметров соединения
+ * @details recv прерывается с EAGAIN не позже наименьшего из тайм-аутов;
+ *          recvBefore сокращает это ожидание до ближайшего срока. send без
+ *          продвижения дольше тайм-аута простоя завершается ошибкой.
+ *          Ошибка настройки не останавливает обслуживание клиента.
+ */
+static void setSocketTimeouts(int client_socket, const Params* p) {
+    uint64_t period = Deadline::period(p);
+    if (period > 0) {
+        timeval tv = {static_cast<time_t>(period / 1000), static_cast<suseconds_t>(period % 1000 * 1000)};
+        if (setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) == -1) {
+            logError(p->logFile, "Ошибка setsockopt (SO_RCVTIMEO): " + std::string(strerror(errno)));
+        }
+    }
+    if (p->IdleTimeout > 0) {
+        timeval tv = {p->IdleTimeout / 1000, p->IdleTimeout % 1000 * 1000};
+        if (setsockopt(client_socket, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) == -1) {
+            logError(p->logFile, "Ошибка setsockopt (SO_SNDTIMEO): " + std::string(strerror(errno)));
+        }
+    }
+}
+
+/**
+ * @brief Приём данных клиента с проверкой срока стадии
+ * @param client_socket Дескриптор сокета клиента
+ * @param buffer Буфер приёма
+ * @param len Размер буфера
+ * @param[in,out] deadline Сроки соединения; отмечается обмен данными
+ * @return Результат recv; -1 с errno ETIMEDOUT по истечении срока
+ * @details Перед каждым recv тайм-аут SO_RCVTIMEO сокращается до времени,
+ *          оставшегося до срока, поэтому соединение закрывается вовремя, а
+ *          не после очередного периода проверки. Пока срок не истёк,
+ *          прерванный приём повторяется. Срок стадии проверяется и после
+ *          получения данных, поэтому клиент, присылающий данные по байту,
+ *          не продлевает её.
+ */
+static ssize_t recvBefore(int client_socket, char* buffer, size_t len, Deadline& deadline) {
+    while (true) {
+        uint64_t at = deadline.at();
+        if (at != 0) {
+            uint64_t now = monotonicMs();
+            if (now >= at) {
+                errno = ETIMEDOUT;
+                return -1;
+            }
+            // Ошибка не страшна: остаётся период из setSocketTimeouts
+            uint64_t left = at - now;
+            timeval tv = {static_cast<time_t>(left / 1000), static_cast<suseconds_t>(left % 1000 * 1000)};
+            setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        }
+        ssize_t received = recv(client_socket, buffer, len, 0);
+        bool waiting = received == -1 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        if (received == 0 || (received == -1 && !waiting)) {
+            return received;
+        }
+        uint64_t now = monotonicMs();
+        if (received > 0) {
+            deadline.touch(now);
+        }
+        at = deadline.at();
+        if (at != 0 && now >= at) {
+            errno = ETIMEDOUT;
+            return -1;
+        }
+        if (received > 0) {
+            return received;
+        }
+    }
+}
+
+/**
+ * @brief Сообщение журнала о неудачном приёме
+ * @param deadline Сроки соединения
+ * @param where Описание ожидаемых данных
+ * @return Описание ошибки recv или истёкшего срока
+ */
+static std::string recvError(const Deadline& deadline, const std::string& where) {
+    if (errno == ETIMEDOUT) {
+        metricAdd(MET_TIMEOUTS);
+        return deadline.message(monotonicMs(), where);
+    }
+    return "Ошибка recv (" + where + "): " + std::string(strerror(errno));
+}
+
 /**
  * @brief Обработка передачи данных после успешной аутентификации
- * @param s Дескриптор основного сокета сервера
  * @param client_socket Дескриптор сокета клиента
  * @param p Указатель на структуру параметров соединения
  * @return 0 при успешном выполнении
  * @throw std::system_error при ошибках сетевого взаимодействия
+ * @details Данные принимаются крупными порциями в буфер размером
+ *          p->RecvBuffer и разбираются декодером векторов. Вектор может
+ *          быть разделён между несколькими вызовами recv: неполное
+ *          слово в конце буфера переносится в его начало перед
+ *          следующим приёмом.
+ *
+ *          Результаты векторов накапливаются и отправляются одним пакетом,
+ *          когда их набирается p->ResultBatch либо когда в сокете не
+ *          осталось принятых данных. Перед блокирующим ожиданием новых
+ *          данных накопленные результаты всегда отправляются, поэтому
+ *          клиент, ждущий ответа на каждый вектор, не блокируется, а
+ *          порядок результатов не меняется.
+ *
+ *          Перед блокирующим приёмом отмечается стадия обмена (заголовок
+ *          или элементы текущего вектора), срок которой проверяет recvBefore.
  */
-int datawrite(int s, int client_socket, const Params* p){
-    uint32_t vectors_count;
-    ssize_t total_received = 0;
-    char* buff = reinterpret_cast<char*>(&vectors_count);
-
-    // Получаем количество векторов
-    while (total_received < sizeof(vectors_count)) {
-        ssize_t received = recv(client_socket, buff + total_received, sizeof(vectors_count) - total_received, 0);
+int datawrite(int client_socket, const Params* p){
+    std::vector<char> buffer(p->RecvBuffer);
+    size_t start = 0;            // Начало непотреблённых данных
+    size_t end = 0;              // Конец принятых данных
+    VectorDecoder decoder;
+    std::string results;         // Результаты, ожидающие отправки
+    uint32_t sent_vectors = 0;
+    Deadline deadline(p, monotonicMs());
+
+    while (!decoder.done()) {
+        size_t used = decoder.feed(buffer.data() + start, end - start, results);
+        start += used;
+        if (decoder.failed()) {
+            std::string errorMsg = "Ошибка протокола: " + decoder.error();
+            logError(p->logFile, errorMsg);
+            close(client_socket);
+            throw std::system_error(EPROTO, std::generic_category());
+        }
+
+        // Размер результата известен только после заголовка пакета
+        size_t batch_bytes = static_cast<size_t>(p->ResultBatch) * decoder.resultSize();
+
+        // Пакет заполнен: отправляем сразу
+        if (results.size() >= batch_bytes) {
+            sendResults(client_socket, p, results, sent_vectors, decoder.resultSize());
+        }
+        if (used > 0) {
+            continue;
+        }
+
+        // Переносим неполное слово в начало буфера и дочитываем данные
+        memmove(buffer.data(), buffer.data() + start, end - start);
+        end -= start;
+        start = 0;
+        ssize_t received = -1;
+        if (!results.empty()) {
+            // Пока клиент продолжает передачу, результаты копятся дальше
+            received = recv(client_socket, buffer.data() + end, buffer.size() - end, MSG_DONTWAIT);
+            if (received == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                sendResults(client_socket, p, results, sent_vectors, decoder.resultSize());
+            } else if (received > 0) {
+                deadline.touch(monotonicMs());
+            }
+        }
+        if (received == -1) {
+            Stage stage = decoder.state() == VectorDecoder::ELEMENTS ? STAGE_ELEMENTS : STAGE_HEADER;
+            deadline.progress(stage, decoder.current(), monotonicMs());
+            received = recvBefore(client_socket, buffer.data() + end, buffer.size() - end, deadline);
+        }
         if (received <= 0) {
-            std::string errorMsg = "Ошибка recv (количество векторов): " + std::string(strerror(errno));
+            std::string errorMsg = recvError(deadline, decoder.where());
             logError(p->logFile, errorMsg);
             close(client_socket);
-            close(s);
             throw std::system_error(errno, std::generic_category());
         }
-        total_received += received;
+        metricAdd(MET_BYTES_IN, received);
+        end += received;
     }
 
-    // Обрабатываем каждый вектор
-    for (uint32_t vector_idx = 0; vector_idx < vectors_count; vector_idx++) {
-        uint32_t vector_size;
-        total_received = 0;
-        buff = reinterpret_cast<char*>(&vector_size);
-        
-        // Получаем размер вектора
-        while (total_received < sizeof(vector_size)) {
-            ssize_t received = recv(client_socket, buff + total_received, sizeof(vector_size) - total_received, 0);
-            if (received <= 0) {
-                std::string errorMsg = "Ошибка recv (размер вектора " + std::to_string(vector_idx) + "): " + std::string(strerror(errno));
+    // Отправляем остаток результатов после последнего вектора
+    if (!results.empty()) {
+        sendResults(client_socket, p, results, sent_vectors, decoder.resultSize());
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief Обслуживание клиента протокола версии 2
+ * @param client_socket Дескриптор сокета клиента (закрывается функцией)
+ * @param p Указатель на параметры соединения
+ * @param users Реестр базы пользователей
+ * @param peer Адрес клиента IPv4
+ * @param[in,out] deadline Сроки соединения
+ * @param first Данные первого приёма, начинающиеся с признака протокола
+ * @param len Длина данных первого приёма
+ * @return 0 при успехе
+ * @throw std::system_error при сетевых ошибках клиента
+ * @details Кадры разбираются тем же автоматом Session, что и в событийных
+ *          режимах. Ответ, накопленный за приём, отправляется одним send,
+ *          поэтому соль, результат аутентификации и первые результаты
+ *          конвейерного клиента уходят одним пакетом.
+ */
+static int framedClient(int client_socket, const Params* p, const UserRegistry* users, uint32_t peer, Deadline& deadline, const char* first, size_t len) {
+    Session session(p, users, false, peer);
+    std::vector<char> buffer(p->RecvBuffer + FRAME_PENDING_MAX);
+    memcpy(buffer.data(), first, len);
+    size_t end = len;
+    while (true) {
+        size_t pos = 0;
+        while (pos < end && !session.finished()) {
+            size_t used = session.onData(buffer.data() + pos, end - pos);
+            if (used == 0) {
+                break;
+            }
+            pos += used;
+        }
+        size_t sent = 0;
+        while (sent < session.out.size()) {
+            ssize_t n = send(client_socket, session.out.data() + sent, session.out.size() - sent, MSG_NOSIGNAL);
+            if (n == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                std::string errorMsg = "Ошибка send (" + session.where() + "): " + std::string(strerror(errno));
                 logError(p->logFile, errorMsg);
                 close(client_socket);
-                close(s);
                 throw std::system_error(errno, std::generic_category());
             }
-            total_received += received;
+            sent += n;
+        }
+        metricAdd(MET_BYTES_OUT, sent);
+        session.out.clear();
+        if (session.finished()) {
+            close(client_socket);
+            return 0;
         }
 
-        int32_t result = 0;
-        // Получаем и обрабатываем элементы вектора
-        for (uint32_t elem_idx = 0; elem_idx < vector_size; elem_idx++) {
-            int32_t element;
-            total_received = 0;
-            buff = reinterpret_cast<char*>(&element);
-            
-            while (total_received < sizeof(element)) {
-                ssize_t received = recv(client_socket, buff + total_received, sizeof(element) - total_received, 0);
-                if (received <= 0) {
-                    std::string errorMsg = "Ошибка recv (элемент " + std::to_string(elem_idx) + " вектора " + std::to_string(vector_idx) + "): " + std::string(strerror(errno));
-                    logError(p->logFile, errorMsg);
-                    close(client_socket);
-                    close(s);
-                    throw std::system_error(errno, std::generic_category());
-                }
-                total_received += received;
-            }
-            
-            result = result + element * element; // Сумма квадратов
+        // Неполный кадр переносится в начало буфера и дочитывается
+        memmove(buffer.data(), buffer.data() + pos, end - pos);
+        end -= pos;
+        deadline.progress(session.stage(), session.vector(), monotonicMs());
+        ssize_t received = recvBefore(client_socket, buffer.data() + end, buffer.size() - end, deadline);
+        if (received == 0) {
+            session.onClose();
+            close(client_socket);
+            return 0;
         }
-        
-        // Отправляем результат обратно клиенту
-        ssize_t send_result = send(client_socket, &result, sizeof(result), 0);
-        if (send_result == -1) {
-            std::string errorMsg = "Ошибка send (результат вектора " + std::to_string(vector_idx) + "): " + std::string(strerror(errno));
+        if (received == -1) {
+            std::string errorMsg = recvError(deadline, session.where());
             logError(p->logFile, errorMsg);
             close(client_socket);
-            close(s);
             throw std::system_error(errno, std::generic_category());
         }
+        metricAdd(MET_BYTES_IN, received);
+        end += received;
     }
-    
-    return 0;
 }
 
 /**
- * @brief Основная функция установки соединения и обработки клиентов
+ * @brief Обслуживание одного клиента: аутентификация и вычисления
+ * @param client_socket Дескриптор сокета клиента
  * @param p Указатель на параметры соединения
- * @return 0 при успехе, 1 при ошибке аутентификации
- * @throw std::system_error при сетевых ошибках
+ * @param users Реестр базы пользователей
+ * @param peer Адрес клиента IPv4 для учёта неудачных входов
+ * @return 0 при успехе, 1 при ошибке аутентификации или закрытии до входа
+ * @throw std::system_error при сетевых ошибках клиента
+ * @details При любом исходе закрывает только сокет клиента,
+ *          слушающий сокет сервера не затрагивается. Соединение, закрытое
+ *          клиентом до передачи логина или хеша, завершается без записи
+ *          в журнал и не считается неудачным входом, как в событийных
+ *          режимах. Клиент, начавший поток с признака протокола версии 2,
+ *          обслуживается framedClient.
  */
-int Connection::connection(const Params* p) {
-    ifstream errFile(p->logFile);
-    
-    // Создание сокета TCP/IP
-    int s = socket(AF_INET, SOCK_STREAM, 0);
-    if (s == -1) {
-        std::string errorMsg = "Ошибка создания сокета: " + std::string(strerror(errno));
-        logError(p->logFile, errorMsg);
-        throw std::system_error(errno, std::generic_category());
-    }
-
-    // Настройка адреса сервера
-    std::unique_ptr<sockaddr_in> self_addr(new sockaddr_in);
-    self_addr->sin_family = AF_INET;
-    self_addr->sin_port = htons(p->Port);
-    self_addr->sin_addr.s_addr = inet_addr(p->Address.c_str());
-
-    // Привязка сокета к адресу
-    int rc = bind(s, reinterpret_cast<const sockaddr*>(self_addr.get()), sizeof(sockaddr_in));
-    if (rc == -1) {
-        std::string errorMsg = "Ошибка bind: " + std::string(strerror(errno));
-        logError(p->logFile, errorMsg);
-        close(s);
-        throw std::system_error(errno, std::generic_category());
-    }
-
-    // Прослушивание входящих соединений
-    rc = listen(s, 5);
-    if (rc == -1) {
-        std::string errorMsg = "Ошибка listen: " + std::string(strerror(errno));
-        logError(p->logFile, errorMsg);
-        close(s);
-        throw std::system_error(errno, std::generic_category());
-    }
-
-    // Принятие входящего соединения
-    sockaddr_in client_addr;
-    socklen_t client_len = sizeof(client_addr);
-    int client_socket = accept(s, reinterpret_cast<sockaddr*>(&client_addr), &client_len);
-    if (client_socket == -1) {
-        std::string errorMsg = "Ошибка accept: " + std::string(strerror(errno));
-        logError(p->logFile, errorMsg);
-        close(s);
-        throw std::system_error(errno, std::generic_category());
-    }
+int Connection::handleClient(int client_socket, const Params* p, const UserRegistry* users, uint32_t peer) {
+    // Зависший клиент не должен занимать рабочий поток дольше тайм-аутов
+    Deadline deadline(p, monotonicMs());
+    setSocketTimeouts(client_socket, p);
 
     // Получение логина от клиента
     char buffer[BUFFER_SIZE];
-    ssize_t received_bytes = recv(client_socket, buffer, BUFFER_SIZE - 1, 0);
+    ssize_t received_bytes = recvBefore(client_socket, buffer, BUFFER_SIZE - 1, deadline);
     if (received_bytes == -1) {
-        std::string errorMsg = "Ошибка recv (логин): " + std::string(strerror(errno));
+        std::string errorMsg = recvError(deadline, "логин");
         logError(p->logFile, errorMsg);
         close(client_socket);
-        close(s);
         throw std::system_error(errno, std::generic_category());
     }
 
+    // Соединение закрыто без логина (проверка доступности порта): это не вход
+    if (received_bytes == 0) {
+        close(client_socket);
+        return 1;
+    }
+
+    metricAdd(MET_BYTES_IN, received_bytes);
+    if (buffer[0] == '\0') {
+        return framedClient(client_socket, p, users, peer, deadline, buffer, received_bytes);
+    }
     buffer[received_bytes] = '\0';
     string client_login(buffer);
     
-    // Поиск пользователя в файле
+    // Поиск пользователя в базе
     string user_password;
-    if (!findUserInFile(p->inFileName, client_login, user_password)) {
+    uint64_t auth_ticks = metricsClock();
+    bool found = users->find(client_login, user_password);
+    auth_ticks = metricsClock() - auth_ticks;
+    if (!found) {
+        metricAdd(MET_USER_NOT_FOUND);
+        metricLatency(HIST_AUTH, auth_ticks);
         std::string errorMsg = "Пользователь не найден: " + client_login;
         logError(p->logFile, errorMsg);
+        loginFailed(p, peer);
         
         string message = "ERR_USER_NOT_FOUND";
         send(client_socket, message.c_str(), message.length(), 0);
         
         close(client_socket);
-        close(s);
         return 1;
     }
 
     // Отправка соли для хеширования
-    string salt = "HASHHASHHASHHASH";
+    string salt = SALT;
     string message = salt;
     ssize_t sent_bytes = send(client_socket, message.c_str(), message.length(), 0);
     if (sent_bytes == -1) {
         std::string errorMsg = "Ошибка send (соль): " + std::string(strerror(errno));
         logError(p->logFile, errorMsg);
         close(client_socket);
-        close(s);
         throw std::system_error(errno, std::generic_category());
     }
+    metricAdd(MET_BYTES_OUT, sent_bytes);
 
     // Получение хеша от клиента
-    received_bytes = recv(client_socket, buffer, BUFFER_SIZE - 1, 0);
+    deadline.progress(STAGE_HASH, 0, monotonicMs());
+    received_bytes = recvBefore(client_socket, buffer, BUFFER_SIZE - 1, deadline);
     if (received_bytes == -1) {
-        std::string errorMsg = "Ошибка recv (хеш): " + std::string(strerror(errno));
+        std::string errorMsg = recvError(deadline, "хеш");
         logError(p->logFile, errorMsg);
         close(client_socket);
-        close(s);
         throw std::system_error(errno, std::generic_category());
     }
+    if (received_bytes == 0) {
+        close(client_socket);
+        return 1;
+    }
 
     buffer[received_bytes] = '\0';
-    string client_hash(buffer);
+    string_view client_hash(buffer);
+    metricAdd(MET_BYTES_IN, received_bytes);
     
     // Вычисление хеша на сервере и сравнение
-    string server_hash = auth(salt, user_password);
+    uint64_t verify_ticks = metricsClock();
+    AuthCheck check{salt, user_password, client_hash};
+    verifyBatch(&check, 1);
+    bool verified = check.verified;
+    metricLatency(HIST_AUTH, auth_ticks + metricsClock() - verify_ticks);
 
-    if (client_hash == server_hash) {
+    if (verified) {
+        metricAdd(MET_AUTH_OK);
         message = "OK";
     } else {
+        metricAdd(MET_AUTH_FAIL);
         message = "ERR";
         std::string errorMsg = "Ошибка аутентификации: неверный хеш для пользователя " + client_login;
         logError(p->logFile, errorMsg);
+        loginFailed(p, peer);
     }
 
     // Отправка результата аутентификации
@@ -277,22 +488,306 @@ int Connection::connection(const Params* p) {
         std::string errorMsg = "Ошибка send (результат аутентификации): " + std::string(strerror(errno));
         logError(p->logFile, errorMsg);
         close(client_socket);
-        close(s);
         throw std::system_error(errno, std::generic_category());
     }
+    metricAdd(MET_BYTES_OUT, sent_bytes);
 
     // Завершение при неудачной аутентификации
     if (message != "OK") {
         close(client_socket);
-        close(s);
         return 1;
     }
 
     // Обработка данных после успешной аутентификации
-    datawrite(s, client_socket, p);
+    datawrite(client_socket, p);
     
-    // Корректное закрытие соединений
+    // Корректное закрытие соединения с клиентом
     close(client_socket);
+    return 0;
+}
+
+/**
+ * @brief Принятие очередного соединения на слушающем сокете
+ * @param s Дескриптор слушающего сокета
+ * @param p Указатель на параметры соединения
+ * @param[out] peer Адрес клиента IPv4
+ * @return Дескриптор сокета клиента или -1 при ошибке отдельного соединения
+ *         или отказе в допуске
+ * @throw std::system_error при неустранимой ошибке слушающего сокета
+ * @details Ошибки отдельного соединения и нехватка ресурсов записываются
+ *          в журнал и не останавливают сервер; при нехватке ресурсов
+ *          поток приёма ждёт AcceptBackoff. -1 возвращается и по
+ *          тайм-ауту приёма, заданному startHandoff. Соединение сверх
+ *          предела сеансов или с адреса, исчерпавшего неудачные входы,
+ *          закрывается сразу; допущенный сеанс завершается вызовом
+ *          releaseClient().
+ */
+int Connection::acceptClient(int s, const Params* p, uint32_t& peer) {
+    sockaddr_in client_addr;
+    socklen_t client_len = sizeof(client_addr);
+    int client_socket = accept(s, reinterpret_cast<sockaddr*>(&client_addr), &client_len);
+    if (client_socket == -1) {
+        int err = errno;
+        // Тайм-аут приёма задаётся только для проверки прекращения приёма (startHandoff)
+        if (err == EAGAIN || err == EWOULDBLOCK) {
+            return -1;
+        }
+        if (AcceptBackoff::exhausted(err)) {
+            static AcceptBackoff backoff;
+            backoff.pause(p, "Ошибка accept", err);
+            return -1;
+        }
+        std::string errorMsg = "Ошибка accept: " + std::string(strerror(err));
+        logError(p->logFile, errorMsg);
+        if (err == EINTR || err == ECONNABORTED || err == EPROTO || err == EPERM) {
+            return -1;
+        }
+        close(s);
+        throw std::system_error(err, std::generic_category());
+    }
+    metricAdd(MET_ACCEPTED);
+    peer = client_addr.sin_addr.s_addr;
+    if (!admitClient(client_socket, peer)) {
+        return -1;
+    }
+    return client_socket;
+}
+
+/**
+ * @brief Создание слушающего сокета на адресе и порту сервера
+ * @param p Указатель на параметры соединения
+ * @param shared true если тот же порт слушают другие сокеты (SO_REUSEPORT)
+ * @return Дескриптор слушающего сокета
+ * @throw std::system_error при ошибках создания, привязки или прослушивания
+ */
+int Connection::listenSocket(const Params* p, bool shared) {
+    // Создание сокета TCP/IP
+    int s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s == -1) {
+        std::string errorMsg = "Ошибка создания сокета: " + std::string(strerror(errno));
+        logError(p->logFile, errorMsg);
+        throw std::system_error(errno, std::generic_category());
+    }
+
+    // Порт прежнего процесса в TIME_WAIT не мешает перезапуску
+    int on = 1;
+    if (setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) == -1) {
+        std::string errorMsg = "Ошибка setsockopt (SO_REUSEADDR): " + std::string(strerror(errno));
+        logError(p->logFile, errorMsg);
+        close(s);
+        throw std::system_error(errno, std::generic_category());
+    }
+
+    // Несколько сокетов на одном порту: ядро распределяет соединения между ними
+    if (shared && setsockopt(s, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) == -1) {
+        std::string errorMsg = "Ошибка setsockopt (SO_REUSEPORT): " + std::string(strerror(errno));
+        logError(p->logFile, errorMsg);
+        close(s);
+        throw std::system_error(errno, std::generic_category());
+    }
+
+    // Настройка адреса сервера
+    std::unique_ptr<sockaddr_in> self_addr(new sockaddr_in);
+    self_addr->sin_family = AF_INET;
+    self_addr->sin_port = htons(p->Port);
+    self_addr->sin_addr.s_addr = inet_addr(p->Address.c_str());
+
+    // Привязка сокета к адресу
+    int rc = bind(s, reinterpret_cast<const sockaddr*>(self_addr.get()), sizeof(sockaddr_in));
+    if (rc == -1) {
+        std::string errorMsg = "Ошибка bind: " + std::string(strerror(errno));
+        logError(p->logFile, errorMsg);
+        close(s);
+        throw std::system_error(errno, std::generic_category());
+    }
+
+    // Прослушивание входящих соединений
+    rc = listen(s, p->Backlog);
+    if (rc == -1) {
+        std::string errorMsg = "Ошибка listen: " + std::string(strerror(errno));
+        logError(p->logFile, errorMsg);
+        close(s);
+        throw std::system_error(errno, std::generic_category());
+    }
+    return s;
+}
+
+/**
+ * @brief Обслуживание клиентов одного слушающего сокета
+ * @param s Дескриптор слушающего сокета (закрывается функцией)
+ * @param p Указатель на параметры соединения
+ * @param users Реестр базы пользователей
+ * @param threads Число рабочих потоков или потоков реактора
+ * @return 0 после прекращения приёма и завершения начатых сеансов
+ * @throw std::system_error при ошибках слушающего сокета
+ */
+int Connection::serve(int s, const Params* p, const UserRegistry* users, size_t threads) {
+    // Событийный режим: клиенты обслуживаются потоками реактора
+    if (p->Mode == "epoll") {
+        int result = Reactor::run(s, p, users, threads);
+        close(s);
+        return result;
+    }
+
+    // Режим io_uring: приём и отправка без системного вызова на каждую операцию
+    if (p->Mode == "uring") {
+        int result = Uring::run(s, p, users, threads);
+        close(s);
+        return result;
+    }
+
+    // Пул рабочих потоков для обслуживания клиентов
+    ThreadPool pool(threads);
+
+    // После передачи сокета новому серверу или сигнала остановки приём
+    // прекращается, а деструктор пула дожидается завершения начатых сеансов
+    while (!handoffDone()) {
+        // Принятие входящего соединения
+        uint32_t peer;
+        int client_socket = acceptClient(s, p, peer);
+        if (client_socket == -1) {
+            continue;
+        }
+
+        pool.submit([client_socket, p, users, peer]() {
+            try {
+                handleClient(client_socket, p, users, peer);
+            } catch (const std::exception&) {
+                // Ошибка уже записана в журнал, сокет клиента закрыт
+            }
+            releaseClient();
+        });
+    }
+
     close(s);
     return 0;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Привязка текущего потока к процессору
+ * @param p Указатель на параметры соединения
+ * @param shard Номер шарда; процессор выбирается по кругу
+ * @details Потоки, созданные после привязки, наследуют её, поэтому
+ *          рабочие потоки шарда выполняются на том же процессоре.
+ *          Ошибка привязки не останавливает сервер.
+ */
+static void pinShard(const Params* p, size_t shard) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(shard % (cpus > 0 ? cpus : 1), &set);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0) {
+        logError(p->logFile, "Ошибка привязки к процессору: " + std::string(strerror(rc)));
+    }
+}
+
+/**
+ * @brief Основная функция установки соединения и обработки клиентов
+ * @param p Указатель на параметры соединения
+ * @return 0 при успехе, 1 при ошибке аутентификации
+ * @throw std::system_error при ошибках слушающего сокета
+ * @details Принимает клиентов в бесконечном цикле; каждый клиент
+ *          обслуживается в пуле рабочих потоков функцией handleClient
+ *          либо, в режиме epoll, потоками реактора.
+ *          Ошибки отдельного клиента закрывают только его сокет.
+ *
+ *          При p->Listeners > 1 каждый шард открывает собственный сокет
+ *          с SO_REUSEPORT на том же порту и обслуживает принятых им
+ *          клиентов своими потоками: общей очереди accept нет, рабочие
+ *          потоки делятся между шардами поровну. Неустранимая ошибка
+ *          одного шарда прекращает приём во всех, и после завершения
+ *          сеансов она передаётся вызывающей стороне.
+ *
+ *          При заданном p->Handoff сервер сначала пытается получить
+ *          слушающие сокеты работающего сервера, а затем сам ожидает
+ *          следующего. Передав сокеты или получив сигнал остановки
+ *          (stopAccepting), сервер прекращает приём, дожидается завершения
+ *          начатых сеансов и возвращает 0.
+ */
+int Connection::connection(const Params* p) {
+    ifstream errFile(p->logFile);
+
+    // SIGHUP принимает только поток перезагрузки базы, маска наследуется потоками
+    UserReloader::blockSignals();
+
+    // База пользователей загружается при запуске и заменяется при изменении файла.
+    // Поток перезагрузки не останавливается и после возврата из функции,
+    // поэтому реестр не разрушается
+    UserRegistry* users = new UserRegistry;
+    if (!UserReloader::reload(users, p)) {
+        std::cerr << "Ошибка: не могу открыть файл " << p->inFileName << std::endl;
+    }
+    UserReloader::start(users, p);
+
+    // Статистика сервера на локальном порту
+    startMetricsServer(p);
+
+    // Запись в сокет закрытого клиентом соединения не должна завершать сервер
+    signal(SIGPIPE, SIG_IGN);
+
+    size_t threads = p->Threads > 0 ? p->Threads : std::thread::hardware_concurrency();
+    if (threads == 0) {
+        threads = 1;
+    }
+    // Большие векторы сворачиваются частями в отдельном пуле вычислительных потоков
+    startParallelReduce(p->ReduceThreads, p->ParallelThreshold);
+    // Клиенты протокола версии 2 возобновляют сеансы по билетам без повторной аутентификации
+    startTickets(static_cast<uint64_t>(p->TicketTtl) * 1000, p->TicketCache);
+    // Лишние соединения и пакеты отклоняются до поиска пользователя и приёма элементов
+    startAdmission(p->FailRate, p->FailBurst, p->MaxSessions);
+    setVectorLimits(p->MaxVectors, p->MaxVectorSize);
+
+    // При перезапуске сокеты работающего сервера принимаются без привязки порта,
+    // и их число определяет число шардов
+    std::vector<int> sockets;
+    if (!receiveListeners(p, sockets)) {
+        size_t listeners = p->Listeners > 1 ? p->Listeners : 1;
+        // Все сокеты привязываются до запуска шардов, чтобы занятый порт обнаружился сразу
+        try {
+            for (size_t i = 0; i < listeners; i++) {
+                sockets.push_back(listenSocket(p, listeners > 1));
+            }
+        } catch (const std::exception&) {
+            for (int s : sockets) {
+                close(s);
+            }
+            throw;
+        }
+    }
+    // Следующий запущенный сервер получит эти сокеты; приём можно прекратить по сигналу
+    startHandoff(p, sockets);
+
+    size_t listeners = sockets.size();
+    if (listeners == 1) {
+        return serve(sockets[0], p, users, threads);
+    }
+
+    size_t shard_threads = threads / listeners > 0 ? threads / listeners : 1;
+    std::vector<std::thread> shards;
+    std::vector<std::exception_ptr> failures(listeners);
+    for (size_t i = 0; i < listeners; i++) {
+        shards.emplace_back([p, users, &sockets, &failures, i, shard_threads]() {
+            if (p->Pin) {
+                pinShard(p, i);
+            }
+            try {
+                serve(sockets[i], p, users, shard_threads);
+            } catch (const std::exception&) {
+                // Сервер не работает с частью шардов: остальные завершают
+                // начатые сеансы, а ошибка передаётся вызывающей стороне
+                failures[i] = std::current_exception();
+                stopAccepting();
+            }
+        });
+    }
+    for (auto& t : shards) {
+        t.join();
+    }
+    for (const auto& failure : failures) {
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+    }
+    return 0;
+}
@@ -8,6 +8,7 @@
 #include "errno.h"
 #include "crypto.h"
 #include "interface.h"
+#include "userbase.h"
 #include <system_error>
 #include <netinet/in.h>
 #include <memory>
@@ -19,8 +20,29 @@
 /// Размер буфера для сетевого обмена
 #define BUFFER_SIZE 1024
 
+/// Соль, отправляемая клиенту для хеширования пароля
+#define SALT "HASHHASHHASHHASH"
+
 using namespace std;
 
+/**
+ * @brief Поиск пользователя в файле по логину
+ * @param[in] filename Путь к файлу с данными пользователей
+ * @param[in] username Логин пользователя для поиска
+ * @param[out] password Найденный пароль пользователя
+ * @return true если пользователь найден, иначе false
+ */
+bool findUserInFile(const std::string& filename, const std::string& username, std::string& password);
+
+/**
+ * @brief Приём векторов и отправка результатов после аутентификации
+ * @param[in] client_socket Дескриптор сокета клиента
+ * @param[in] p Параметры соединения
+ * @return 0 при успехе
+ * @throw system_error при сетевых ошибках клиента
+ */
+int datawrite(int client_socket, const Params* p);
+
 /**
  * @class Connection
  * @brief Класс для управления сетевыми соединениями
@@ -30,9 +52,55 @@ class Connection
 public:
     /**
      * @brief Устанавливает соединение и обрабатывает клиентов
+     * @details Принимает клиентов в бесконечном цикле и передаёт их
+     *          обработку в пул рабочих потоков
      * @param[in] p Параметры соединения
      * @return 0 при успехе, 1 при ошибке
-     * @throw system_error при сетевых ошибках
+     * @throw system_error при ошибках слушающего сокета
      */
     static int connection(const Params* p);
+
+    /**
+     * @brief Обслуживает одного клиента: аутентификация и вычисления
+     * @param[in] client_socket Дескриптор сокета клиента (закрывается функцией)
+     * @param[in] p Параметры соединения
+     * @param[in] users Реестр базы пользователей
+     * @param[in] peer Адрес клиента IPv4 для учёта неудачных входов
+     * @return 0 при успехе, 1 при ошибке аутентификации или закрытии до входа
+     * @throw system_error при сетевых ошибках клиента
+     */
+    static int handleClient(int client_socket, const Params* p, const UserRegistry* users, uint32_t peer = 0);
+
+    /**
+     * @brief Принимает очередное соединение на слушающем сокете
+     * @param[in] s Дескриптор слушающего сокета
+     * @param[in] p Параметры соединения
+     * @param[out] peer Адрес клиента IPv4
+     * @return Дескриптор сокета клиента или -1 при ошибке отдельного
+     *         соединения (ошибка записывается в журнал) и при отказе
+     *         в допуске (admitClient)
+     * @throw system_error при неустранимой ошибке слушающего сокета
+     */
+    static int acceptClient(int s, const Params* p, uint32_t& peer);
+
+    /**
+     * @brief Создаёт слушающий сокет на адресе и порту сервера
+     * @param[in] p Параметры соединения (адрес, порт, длина очереди)
+     * @param[in] shared true если порт разделяется с другими сокетами
+     *            процесса через SO_REUSEPORT
+     * @return Дескриптор слушающего сокета
+     * @throw system_error при ошибках создания, привязки или прослушивания
+     */
+    static int listenSocket(const Params* p, bool shared);
+
+    /**
+     * @brief Обслуживает клиентов одного слушающего сокета
+     * @param[in] s Дескриптор слушающего сокета
+     * @param[in] p Параметры соединения
+     * @param[in] users Реестр базы пользователей
+     * @param[in] threads Число рабочих потоков или потоков реактора
+     * @return 0 после прекращения приёма и завершения сеансов
+     * @throw system_error при ошибках слушающего сокета
+     */
+    static int serve(int s, const Params* p, const UserRegistry* users, size_t threads);
 };
\ No newline at end of file
@@ -18,17 +18,47 @@
  * @details Вычисляет SHA224 хеш от конкатенации соли и пароля, результат возвращает в hex-формате
  */
 string auth(string salt, string pass){
-    CPP::SHA224 sha224; ///< Объект для вычисления SHA224 хеша
-    string hash; ///< Результирующий хеш
-    
-    CPP::StringSource(
-        string(salt).append(pass), ///< Конкатенация соли и пароля
-        true,
-        new CPP::HashFilter(
-            sha224, ///< Использование SHA224 для хеширования
-            new CPP::HexEncoder( ///< Кодирование результата в hex
-                new CPP::StringSink(hash)))
-    );
+    char hash[AUTH_HASH_SIZE]; ///< Результирующий хеш
+    authInto(salt, pass, hash);
+    return string(hash, AUTH_HASH_SIZE); ///< Возврат хеша в hex-формате
+}
 
-    return hash; ///< Возврат хеша в hex-формате
+/**
+ * @brief Вычисление SHA224 хеша соли и пароля в буфер вызывающей стороны
+ * @param[in] salt Соль для хеширования
+ * @param[in] pass Пароль пользователя
+ * @param[out] out Буфер не менее AUTH_HASH_SIZE символов
+ * @details Соль и пароль подаются в хеш по очереди без конкатенации;
+ *          Final() сбрасывает состояние объекта для следующего вызова
+ */
+void authInto(string_view salt, string_view pass, char* out){
+    static const char digits[] = "0123456789ABCDEF"; ///< Алфавит HexEncoder CryptoPP
+    thread_local CPP::SHA224 sha224; ///< Объект SHA224 текущего потока
+    CPP::byte digest[CPP::SHA224::DIGESTSIZE];
+
+    sha224.Update(reinterpret_cast<const CPP::byte*>(salt.data()), salt.size());
+    sha224.Update(reinterpret_cast<const CPP::byte*>(pass.data()), pass.size());
+    sha224.Final(digest);
+
+    for (size_t i = 0; i < sizeof(digest); i++) {
+        out[2 * i] = digits[digest[i] >> 4];
+        out[2 * i + 1] = digits[digest[i] & 0x0F];
+    }
+}
+
+/**
+ * @brief Сравнение хешей за время, не зависящее от содержимого
+ * @param[in] a Первый хеш
+ * @param[in] b Второй хеш
+ * @return true если хеши совпадают
+ */
+bool hashEquals(string_view a, string_view b){
+    if (a.size() != b.size()) {
+        return false;
+    }
+    volatile unsigned char diff = 0; ///< Накопленные различия всех байт
+    for (size_t i = 0; i < a.size(); i++) {
+        diff = diff | (a[i] ^ b[i]);
+    }
+    return diff == 0;
 }
\ No newline at end of file
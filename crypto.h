@@ -11,12 +11,16 @@
 #pragma once
 #include <string>
 #include <string>
+#include <string_view>
 #include <cryptopp/hex.h>
 #include <cryptopp/osrng.h>
 #include <cryptopp/sha.h>
 using namespace std;
 namespace CPP = CryptoPP;
 
+/// Длина хеша SHA224 в hex-формате
+#define AUTH_HASH_SIZE 56
+
 /**
  * @brief Функция аутентификации с использованием SHA224 хеширования
  * @param[in] salt Соль для хеширования
@@ -24,4 +28,25 @@ namespace CPP = CryptoPP;
  * @return Хеш-строка в hex-формате
  * @details Использует алгоритм SHA224 для создания хеша от конкатенации соли и пароля
  */
-string auth(string salt, string pass);
\ No newline at end of file
+string auth(string salt, string pass);
+
+/**
+ * @brief Вычисление SHA224 хеша соли и пароля в буфер вызывающей стороны
+ * @param[in] salt Соль для хеширования
+ * @param[in] pass Пароль пользователя
+ * @param[out] out Буфер не менее AUTH_HASH_SIZE символов (без завершающего нуля)
+ * @details Результат совпадает с auth(), но не создаёт строк и фильтров
+ *          CryptoPP: используется объект SHA224, свой для каждого потока,
+ *          и собственное hex-кодирование в верхнем регистре
+ */
+void authInto(string_view salt, string_view pass, char* out);
+
+/**
+ * @brief Сравнение хешей за время, не зависящее от содержимого
+ * @param[in] a Первый хеш
+ * @param[in] b Второй хеш
+ * @return true если хеши совпадают
+ * @details Время сравнения зависит только от длины, которая не является
+ *          секретом, поэтому по нему нельзя подобрать совпадающий префикс
+ */
+bool hashEquals(string_view a, string_view b);
@@ -0,0 +1,230 @@
+/**
+ * @file decoder.cpp
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация потокового декодера векторов
+ */
+
+#include "decoder.h"
+#include "metrics.h"
+#include "simd.h"
+#include <atomic>
+#include <cstring>
+
+/// Наибольшее количество векторов в пакете (0 — без предела)
+static std::atomic<uint32_t> maxVectors{0};
+
+/// Наибольший размер вектора (0 — без предела)
+static std::atomic<uint32_t> maxVectorSize{0};
+
+/**
+ * @brief Установка пределов пакета векторов
+ * @param[in] vectors Наибольшее количество векторов в пакете (0 — без предела)
+ * @param[in] size Наибольший размер вектора в элементах, для OP_DOT — в парах
+ *                 (0 — без предела)
+ */
+void setVectorLimits(uint32_t vectors, uint32_t size)
+{
+    maxVectors.store(vectors);
+    maxVectorSize.store(size);
+}
+
+/**
+ * @brief Чтение 4-байтового слова из потока
+ * @param[in] p Указатель на данные (выравнивание не требуется)
+ * @return Прочитанное значение
+ */
+static inline uint32_t readWord(const char* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/**
+ * @brief Разбор слова режима
+ * @param[in] word Слово режима
+ * @return false если режим недопустим
+ * @details Режимы накопления, кроме ACC_WRAP32, определены только для
+ *          int32_t; старший байт зарезервирован и должен быть нулевым
+ */
+bool VectorDecoder::setMode(uint32_t word)
+{
+    uint32_t accByte = word & 0xFF;
+    uint32_t opByte = (word >> 8) & 0xFF;
+    uint32_t typeByte = (word >> 16) & 0xFF;
+    if ((word >> 24) != 0 || accByte > ACC_SAT32 || opByte > OP_L2 || typeByte > ELEM_DOUBLE ||
+        (typeByte != ELEM_INT32 && accByte != ACC_WRAP32)) {
+        return false;
+    }
+    acc = static_cast<Accumulation>(accByte);
+    op = static_cast<Operation>(opByte);
+    type = static_cast<ElementType>(typeByte);
+    // Исходная сумма квадратов по модулю 2^32 считается без ядра свёртки
+    if (word != MODE_WORD(ACC_WRAP32, OP_SUM_SQUARES, ELEM_INT32)) {
+        kernel = reduceKernel(op, type);
+    }
+    return true;
+}
+
+/**
+ * @brief Прекращение обработки из-за ошибки протокола
+ * @param[in] message Описание ошибки
+ */
+void VectorDecoder::fail(const std::string& message)
+{
+    failure = message;
+    st = FAILED;
+}
+
+/**
+ * @brief Завершение текущего вектора и запись результата
+ * @param[out] out Буфер ответа клиенту
+ */
+void VectorDecoder::finishVector(std::string& out)
+{
+    if (parallel) {
+        // Исходная сумма по модулю 2^32 — младшие биты точной суммы
+        reduction = parallel->finish();
+        parallel.reset();
+        reduceFinish(op, type, acc, reduction, out);
+    } else if (kernel == nullptr) {
+        out.append(reinterpret_cast<const char*>(&result), sizeof(result));
+    } else {
+        reduceFinish(op, type, acc, reduction, out);
+    }
+    metricAdd(MET_VECTORS);
+    metricAdd(MET_ELEMENTS, op == OP_DOT ? 2 * static_cast<uint64_t>(vectorSize) : vectorSize);
+    metricLatency(HIST_VECTOR, metricsClock() - started);
+    vectorIdx++;
+    st = vectorIdx < vectorsCount ? SIZE : DONE;
+}
+
+/**
+ * @brief Обработка очередной порции данных
+ * @param[in] data Указатель на принятые данные
+ * @param[in] len Длина данных в байтах
+ * @param[out] out Буфер ответа, в конец которого дописывается результат
+ * @return Количество потреблённых байт (кратно 4)
+ */
+size_t VectorDecoder::feed(const char* data, size_t len, std::string& out)
+{
+    size_t pos = 0;
+    while (st != DONE && st != FAILED && len - pos >= sizeof(uint32_t)) {
+        switch (st) {
+        case COUNT:
+            vectorsCount = readWord(data + pos);
+            pos += sizeof(uint32_t);
+            if (vectorsCount & BATCH_EXTENDED) {
+                vectorsCount &= ~BATCH_EXTENDED;
+                st = MODE;
+            }
+            // Пакет сверх предела отклоняется до приёма каких-либо векторов
+            if (maxVectors.load() != 0 && vectorsCount > maxVectors.load()) {
+                metricAdd(MET_REJECTED_LIMITS);
+                fail("количество векторов " + std::to_string(vectorsCount) + " больше предела " + std::to_string(maxVectors.load()));
+                return pos;
+            }
+            if (st == MODE) {
+                break;
+            }
+            st = vectorsCount > 0 ? SIZE : DONE;
+            break;
+        case MODE:
+            modeWord = readWord(data + pos);
+            pos += sizeof(uint32_t);
+            if (!setMode(modeWord)) {
+                fail("неизвестный режим вычислений " + std::to_string(modeWord));
+                return pos;
+            }
+            st = vectorsCount > 0 ? SIZE : DONE;
+            break;
+        case SIZE:
+            vectorSize = readWord(data + pos);
+            pos += sizeof(uint32_t);
+            if (maxVectorSize.load() != 0 && vectorSize > maxVectorSize.load()) {
+                metricAdd(MET_REJECTED_LIMITS);
+                fail("размер вектора " + std::to_string(vectorIdx) + " (" + std::to_string(vectorSize) + ") больше предела " + std::to_string(maxVectorSize.load()));
+                return pos;
+            }
+            started = metricsClock();
+            elemIdx = 0;
+            result = 0;
+            reduction = reduceInit(op, type);
+            if (vectorSize == 0) {
+                finishVector(out);
+                return pos;
+            }
+            if (parallelThreshold() != 0 && vectorSize >= parallelThreshold()) {
+                uint64_t units = static_cast<uint64_t>(vectorSize) * (op == OP_DOT ? 2 : 1);
+                parallel.reset(new ParallelReduction(op, type, units * elementSize(type)));
+            }
+            st = ELEMENTS;
+            break;
+        case ELEMENTS: {
+            // Все целые элементы (пары) вектора из порции обрабатываются одним вызовом ядра
+            size_t unit = elementSize(type) * (op == OP_DOT ? 2 : 1);
+            size_t count = (len - pos) / unit;
+            if (count > vectorSize - elemIdx) {
+                count = vectorSize - elemIdx;
+            }
+            if (count == 0) {
+                return pos;
+            }
+            if (parallel) {
+                parallel->add(data + pos, count * unit);
+            } else if (kernel != nullptr) {
+                kernel(data + pos, count * unit / elementSize(type), reduction);
+            } else {
+                int32_t chunk;
+                if (reinterpret_cast<uintptr_t>(data + pos) % alignof(int32_t) == 0) {
+                    chunk = sumSquares(reinterpret_cast<const int32_t*>(data + pos), count);
+                } else {
+                    uint32_t sum = 0;
+                    for (size_t i = 0; i < count; i++) {
+                        uint32_t element = readWord(data + pos + i * sizeof(int32_t));
+                        sum += element * element;
+                    }
+                    chunk = static_cast<int32_t>(sum);
+                }
+                // Переполнение вычисляется по модулю 2^32, как в int32_t клиента
+                result = static_cast<int32_t>(static_cast<uint32_t>(result) + static_cast<uint32_t>(chunk));
+            }
+            pos += count * unit;
+            elemIdx += count;
+            if (elemIdx == vectorSize) {
+                finishVector(out);
+                return pos;
+            }
+            break;
+        }
+        case DONE:
+        case FAILED:
+            break;
+        }
+    }
+    return pos;
+}
+
+/**
+ * @brief Описание ожидаемого поля для сообщений об ошибках
+ * @return Строка вида "размер вектора 3" или "элемент 5 вектора 3"
+ */
+std::string VectorDecoder::where() const
+{
+    switch (st) {
+    case COUNT:
+        return "количество векторов";
+    case MODE:
+    case FAILED:
+        return "режим вычислений";
+    case SIZE:
+        return "размер вектора " + std::to_string(vectorIdx);
+    case ELEMENTS:
+        return "элемент " + std::to_string(elemIdx) + " вектора " + std::to_string(vectorIdx);
+    default:
+        return "данные после завершения";
+    }
+}
@@ -0,0 +1,176 @@
+/**
+ * @file decoder.h
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл потокового декодера векторов
+ * @details Содержит декодер двоичного потока векторов (количество векторов,
+ *          слово режима, размер вектора, элементы), не зависящий от способа
+ *          ввода-вывода
+ */
+
+#pragma once
+#include "parallel.h"
+#include "reduce.h"
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+/// Флаг расширенного заголовка: за количеством векторов следует слово режима
+#define BATCH_EXTENDED 0x80000000u
+
+/// Слово режима: накопление, операция и тип элементов по байтам от младшего
+#define MODE_WORD(acc, op, type) ((acc) | (op) << 8 | (type) << 16)
+
+/**
+ * @brief Установка пределов пакета векторов
+ * @param[in] vectors Наибольшее количество векторов в пакете (0 — без предела)
+ * @param[in] size Наибольший размер вектора в элементах, для OP_DOT — в парах
+ *                 (0 — без предела)
+ * @details Действует для всех декодеров, включая уже созданные
+ */
+void setVectorLimits(uint32_t vectors, uint32_t size);
+
+/**
+ * @class VectorDecoder
+ * @brief Потоковый декодер векторов с вычислением свёртки
+ * @details Принимает произвольные фрагменты потока данных клиента и
+ *          продвигает автомат состояний: количество векторов → [режим] →
+ *          размер вектора → элементы. Операция и тип элементов задаются
+ *          словом режима один раз на пакет, по умолчанию — сумма квадратов
+ *          int32_t. Декодер потребляет только целые слова заголовка и целые
+ *          элементы (для OP_DOT — пары), неполный остаток (не более 15 байт)
+ *          остаётся у вызывающей стороны и передаётся повторно вместе со
+ *          следующей порцией данных.
+ *
+ *          Векторы не короче parallelThreshold() элементов сворачиваются
+ *          частями в пуле вычислительных потоков по мере приёма данных.
+ *          Количество или размер векторов сверх пределов setVectorLimits()
+ *          отклоняются по заголовку, до приёма элементов.
+ */
+class VectorDecoder
+{
+public:
+    /// Состояние декодера
+    enum State {
+        COUNT,      ///< Ожидается количество векторов
+        MODE,       ///< Ожидается слово режима расширенного заголовка
+        SIZE,       ///< Ожидается размер очередного вектора
+        ELEMENTS,   ///< Ожидаются элементы вектора
+        DONE,       ///< Все векторы обработаны
+        FAILED      ///< Недопустимый режим или превышен предел, обработка прекращена
+    };
+
+private:
+    State st = COUNT;            ///< Текущее состояние
+    uint32_t vectorsCount = 0;   ///< Количество векторов
+    uint32_t vectorIdx = 0;      ///< Номер текущего вектора
+    uint32_t vectorSize = 0;     ///< Размер текущего вектора (для OP_DOT — число пар)
+    uint32_t elemIdx = 0;        ///< Номер очередного элемента (пары) вектора
+    int32_t result = 0;          ///< Сумма квадратов по модулю 2^32 исходного протокола
+    Reduction reduction;         ///< Свёртка текущего вектора в остальных режимах
+    Accumulation acc = ACC_WRAP32; ///< Режим накопления
+    Operation op = OP_SUM_SQUARES; ///< Операция
+    ElementType type = ELEM_INT32; ///< Тип элементов
+    ReduceKernel kernel = nullptr; ///< Ядро свёртки; nullptr для исходного протокола
+    uint32_t modeWord = 0;       ///< Принятое слово режима
+    std::unique_ptr<ParallelReduction> parallel; ///< Параллельная свёртка большого вектора
+    uint64_t started = 0;        ///< Отметка metricsClock получения размера вектора
+    std::string failure;         ///< Описание ошибки протокола
+
+    /**
+     * @brief Прекращение обработки из-за ошибки протокола
+     * @param[in] message Описание ошибки
+     */
+    void fail(const std::string& message);
+
+    /**
+     * @brief Разбор слова режима
+     * @param[in] word Слово режима
+     * @return false если режим недопустим
+     */
+    bool setMode(uint32_t word);
+
+    /**
+     * @brief Завершение текущего вектора и запись результата
+     * @param[out] out Буфер ответа клиенту
+     */
+    void finishVector(std::string& out);
+
+public:
+    /**
+     * @brief Обработка очередной порции данных
+     * @param[in] data Указатель на принятые данные
+     * @param[in] len Длина данных в байтах
+     * @param[out] out Буфер ответа, в конец которого дописывается результат
+     * @return Количество потреблённых байт (кратно 4)
+     * @details Обработка останавливается после завершения очередного вектора,
+     *          чтобы вызывающая сторона могла отправить результат
+     */
+    size_t feed(const char* data, size_t len, std::string& out);
+
+    /**
+     * @brief Текущее состояние декодера
+     * @return Состояние автомата
+     */
+    State state() const {
+        return st;
+    }
+
+    /**
+     * @brief Признак обработки всех векторов
+     * @return true если все векторы получены и результаты сформированы
+     */
+    bool done() const {
+        return st == DONE;
+    }
+
+    /**
+     * @brief Признак ошибки протокола
+     * @return true если получено недопустимое слово режима или заголовок
+     *         сверх пределов setVectorLimits()
+     */
+    bool failed() const {
+        return st == FAILED;
+    }
+
+    /**
+     * @brief Описание ошибки протокола
+     * @return Строка вида "неизвестный режим вычислений 7" или пустая строка
+     */
+    const std::string& error() const {
+        return failure;
+    }
+
+    /**
+     * @brief Принятое слово режима
+     * @return Слово режима расширенного заголовка или 0
+     */
+    uint32_t mode() const {
+        return modeWord;
+    }
+
+    /**
+     * @brief Номер текущего вектора
+     * @return Номер вектора, размер или элементы которого ожидаются
+     */
+    uint32_t current() const {
+        return vectorIdx;
+    }
+
+    /**
+     * @brief Размер результата одного вектора
+     * @return 4 или 8 байт в зависимости от режима
+     */
+    size_t resultSize() const {
+        return reduceResultSize(op, type, acc);
+    }
+
+    /**
+     * @brief Описание ожидаемого поля для сообщений об ошибках
+     * @return Строка вида "размер вектора 3" или "элемент 5 вектора 3"
+     */
+    std::string where() const;
+};
@@ -0,0 +1,37 @@
+/**
+ * @file frame.cpp
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация кадров протокола версии 2
+ */
+
+#include "frame.h"
+#include <cstring>
+
+/**
+ * @brief Запись кадра
+ * @param[out] out Буфер, в конец которого дописывается кадр
+ * @param[in] type Тип кадра
+ * @param[in] data Данные кадра
+ * @param[in] len Длина данных, байт
+ */
+void appendFrame(std::string& out, FrameType type, const char* data, size_t len)
+{
+    FrameHeader h = {static_cast<uint32_t>(len), type};
+    out.append(reinterpret_cast<const char*>(&h), sizeof(h));
+    out.append(data, len);
+}
+
+/**
+ * @brief Чтение заголовка кадра
+ * @param[in] data Не менее sizeof(FrameHeader) байт (выравнивание не требуется)
+ * @return Заголовок
+ */
+FrameHeader readFrameHeader(const char* data)
+{
+    FrameHeader h;
+    memcpy(&h, data, sizeof(h));
+    return h;
+}
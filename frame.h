@@ -0,0 +1,79 @@
+/**
+ * @file frame.h
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл кадров протокола версии 2
+ * @details Содержит формат кадров с длиной: клиент открывает поток
+ *          признаком FRAME_MAGIC, после чего каждое сообщение передаётся
+ *          кадром из заголовка (длина и тип) и данных. Границы сообщений не
+ *          зависят от того, как TCP объединил или разделил сегменты, поэтому
+ *          клиент может отправить логин, хеш и первые векторы одной передачей.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// Признак протокола версии 2 в начале потока клиента
+#define FRAME_MAGIC "\0VX2"
+/// Длина признака протокола версии 2, байт
+#define FRAME_MAGIC_SIZE 4
+/// Наибольшая длина кадра логина или хеша, байт (как сообщение исходного протокола)
+#define FRAME_CONTROL_MAX 1023
+/// Наибольший неполный кадр, переносимый между приёмами, байт
+#define FRAME_PENDING_MAX (8 + FRAME_CONTROL_MAX)
+
+/**
+ * @brief Тип кадра
+ * @details Клиент передаёт FRAME_LOGIN, FRAME_HASH и любое число кадров
+ *          FRAME_VECTORS, данные которых образуют поток векторов исходного
+ *          протокола и могут делиться между кадрами произвольно. Сервер
+ *          отвечает FRAME_SALT, затем FRAME_OK или FRAME_ERR и кадрами
+ *          FRAME_RESULTS с результатами векторов по порядку. Клиент, знающий
+ *          соль по прошлому сеансу, может не ждать FRAME_SALT.
+ *
+ *          Если выдача билетов включена, перед FRAME_OK сервер отправляет
+ *          FRAME_TICKET. При следующем подключении клиент вместо логина
+ *          передаёт билет кадром FRAME_RESUME и сразу за ним векторы; сервер
+ *          отвечает новым FRAME_TICKET и FRAME_OK без соли либо FRAME_ERR
+ *          с кодом ERR_TICKET.
+ */
+enum FrameType : uint32_t {
+    FRAME_LOGIN = 1,    ///< Логин (клиент)
+    FRAME_SALT = 2,     ///< Соль для хеширования пароля (сервер)
+    FRAME_HASH = 3,     ///< Хеш пароля (клиент)
+    FRAME_OK = 4,       ///< Успешная аутентификация (сервер)
+    FRAME_ERR = 5,      ///< Ошибка с кодом исходного протокола, после неё соединение закрывается (сервер)
+    FRAME_VECTORS = 6,  ///< Часть потока векторов (клиент)
+    FRAME_RESULTS = 7,  ///< Результаты векторов (сервер)
+    FRAME_TICKET = 8,   ///< Билет возобновления сеанса (сервер)
+    FRAME_RESUME = 9    ///< Билет прошлого сеанса вместо логина и хеша (клиент)
+};
+
+/**
+ * @struct FrameHeader
+ * @brief Заголовок кадра
+ */
+struct FrameHeader {
+    uint32_t length;    ///< Длина данных кадра, байт
+    uint32_t type;      ///< Тип кадра FrameType
+};
+
+/**
+ * @brief Запись кадра
+ * @param[out] out Буфер, в конец которого дописывается кадр
+ * @param[in] type Тип кадра
+ * @param[in] data Данные кадра
+ * @param[in] len Длина данных, байт
+ */
+void appendFrame(std::string& out, FrameType type, const char* data, size_t len);
+
+/**
+ * @brief Чтение заголовка кадра
+ * @param[in] data Не менее sizeof(FrameHeader) байт (выравнивание не требуется)
+ * @return Заголовок
+ */
+FrameHeader readFrameHeader(const char* data);
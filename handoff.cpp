@@ -0,0 +1,306 @@
+/**
+ * @file handoff.cpp
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация передачи слушающих сокетов новому серверу
+ * @details Обмен по Unix-сокету: новый сервер подключается к пути
+ *          p->Handoff, получает число сокетов и сами сокеты в одном
+ *          сообщении SCM_RIGHTS и отвечает одним байтом подтверждения.
+ *          Прежний сервер прекращает приём только после подтверждения,
+ *          поэтому при сбое нового процесса он продолжает работу.
+ */
+
+#include "handoff.h"
+#include "log.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+
+/// Приём соединений прекращён: сокеты переданы следующему серверу или получен сигнал
+static std::atomic<bool> done{false};
+
+/// Событие прекращения приёма (-1 — ещё не создано)
+static std::atomic<int> event{-1};
+
+/**
+ * @brief Адрес Unix-сокета передачи
+ * @param[in] p Параметры сервера
+ * @return Адрес с путём p->Handoff (длина проверена при разборе параметров)
+ */
+static sockaddr_un handoffAddress(const Params* p)
+{
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, p->Handoff.c_str(), sizeof(addr.sun_path) - 1);
+    return addr;
+}
+
+/**
+ * @brief Установка тайм-аута приёма
+ * @param[in] s Сокет
+ * @param[in] ms Тайм-аут, мс
+ */
+static void setTimeout(int s, int ms)
+{
+    timeval tv;
+    tv.tv_sec = ms / 1000;
+    tv.tv_usec = (ms % 1000) * 1000;
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+}
+
+/**
+ * @brief Закрытие полученных сокетов
+ * @param[in,out] sockets Сокеты; вектор очищается
+ */
+static void closeAll(std::vector<int>& sockets)
+{
+    for (int s : sockets) {
+        close(s);
+    }
+    sockets.clear();
+}
+
+/**
+ * @brief Получение слушающих сокетов работающего сервера
+ * @param[in] p Параметры сервера (путь p->Handoff)
+ * @param[out] sockets Полученные сокеты
+ * @return false если передача не настроена, работающего сервера нет
+ *         или сокеты получить не удалось
+ */
+bool receiveListeners(const Params* p, std::vector<int>& sockets)
+{
+    if (p->Handoff.empty()) {
+        return false;
+    }
+    int u = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (u == -1) {
+        logError(p->logFile, "Ошибка создания сокета передачи: " + std::string(strerror(errno)));
+        return false;
+    }
+    // Нет файла или никто не слушает — работающего сервера нет, порт привязывается заново
+    sockaddr_un addr = handoffAddress(p);
+    if (connect(u, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == -1) {
+        close(u);
+        return false;
+    }
+    setTimeout(u, HANDOFF_TIMEOUT_MS);
+
+    uint32_t count = 0;
+    iovec iov = {&count, sizeof(count)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * HANDOFF_MAX_SOCKETS)];
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t n = recvmsg(u, &msg, MSG_CMSG_CLOEXEC);
+    std::vector<int> received;
+    for (cmsghdr* c = CMSG_FIRSTHDR(&msg); n > 0 && c != nullptr; c = CMSG_NXTHDR(&msg, c)) {
+        if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS) {
+            size_t fds = (c->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            for (size_t i = 0; i < fds; i++) {
+                int fd;
+                memcpy(&fd, CMSG_DATA(c) + i * sizeof(int), sizeof(fd));
+                received.push_back(fd);
+            }
+        }
+    }
+    if (n != sizeof(count) || count == 0 || received.size() != count || (msg.msg_flags & MSG_CTRUNC)) {
+        std::string reason = n == -1 ? std::string(strerror(errno)) : "неполное сообщение";
+        logError(p->logFile, "Ошибка получения слушающих сокетов: " + reason);
+        closeAll(received);
+        close(u);
+        return false;
+    }
+
+    // Прежний сервер прекращает приём только после подтверждения
+    char ack = 1;
+    if (send(u, &ack, sizeof(ack), MSG_NOSIGNAL) != sizeof(ack)) {
+        logError(p->logFile, "Ошибка send (подтверждение передачи сокетов): " + std::string(strerror(errno)));
+        closeAll(received);
+        close(u);
+        return false;
+    }
+    close(u);
+    sockets = received;
+    return true;
+}
+
+/**
+ * @brief Передача сокетов подключившемуся серверу
+ * @param[in] c Соединение с новым сервером
+ * @param[in] sockets Слушающие сокеты
+ * @return true если новый сервер подтвердил получение
+ */
+static bool sendListeners(int c, const std::vector<int>& sockets)
+{
+    uint32_t count = sockets.size();
+    if (count == 0 || count > HANDOFF_MAX_SOCKETS) {
+        errno = EINVAL;
+        return false;
+    }
+    setTimeout(c, HANDOFF_TIMEOUT_MS);
+    iovec iov = {&count, sizeof(count)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * HANDOFF_MAX_SOCKETS)] = {};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * count);
+    memcpy(CMSG_DATA(cmsg), sockets.data(), sizeof(int) * count);
+    if (sendmsg(c, &msg, MSG_NOSIGNAL) != sizeof(count)) {
+        return false;
+    }
+    char ack = 0;
+    return recv(c, &ack, sizeof(ack), 0) == sizeof(ack) && ack == 1;
+}
+
+/**
+ * @brief Поток ожидания следующего сервера
+ * @param[in] u Слушающий Unix-сокет передачи
+ * @param[in] sockets Слушающие сокеты сервера
+ * @param[in] p Параметры сервера
+ * @details Подключение, не подтвердившее получение, не прерывает работу:
+ *          поток ждёт следующего
+ */
+static void serveHandoff(int u, std::vector<int> sockets, const Params* p)
+{
+    while (true) {
+        int c = accept4(u, nullptr, nullptr, SOCK_CLOEXEC);
+        if (c == -1) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            logError(p->logFile, "Ошибка accept (передача сокетов): " + std::string(strerror(errno)));
+            close(u);
+            return;
+        }
+        if (!sendListeners(c, sockets)) {
+            logError(p->logFile, "Ошибка передачи слушающих сокетов: " + std::string(strerror(errno)));
+            close(c);
+            continue;
+        }
+        close(c);
+        close(u);
+        stopAccepting();
+        logError(p->logFile, "Слушающие сокеты переданы новому серверу, приём соединений прекращён");
+        return;
+    }
+}
+
+/**
+ * @brief Пробуждение циклов приёма
+ * @param[in] ev Дескриптор eventfd
+ */
+static void wake(int ev)
+{
+    uint64_t one = 1;
+    if (ev != -1 && write(ev, &one, sizeof(one)) != sizeof(one)) {
+        std::cerr << "Ошибка write (событие остановки приёма): " << strerror(errno) << std::endl;
+    }
+}
+
+/**
+ * @brief Подготовка остановки приёма и ожидание следующего сервера
+ * @param[in] p Параметры сервера (путь p->Handoff; пустой — передача отключена)
+ * @param[in] sockets Слушающие сокеты, передаваемые следующему серверу
+ * @throw std::system_error при ошибке создания eventfd или Unix-сокета
+ */
+void startHandoff(const Params* p, const std::vector<int>& sockets)
+{
+    int ev = eventfd(0, EFD_CLOEXEC);
+    if (ev == -1) {
+        int err = errno;
+        std::string errorMsg = "Ошибка eventfd (остановка приёма): " + std::string(strerror(err));
+        logError(p->logFile, errorMsg);
+        throw std::system_error(err, std::generic_category());
+    }
+    event.store(ev);
+    // Сигнал мог прийти до создания события
+    if (done.load()) {
+        wake(ev);
+    }
+    for (int s : sockets) {
+        setTimeout(s, HANDOFF_POLL_MS);
+    }
+    if (p->Handoff.empty()) {
+        return;
+    }
+
+    int u = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (u == -1) {
+        std::string errorMsg = "Ошибка создания сокета передачи: " + std::string(strerror(errno));
+        logError(p->logFile, errorMsg);
+        throw std::system_error(errno, std::generic_category());
+    }
+
+    // Путь мог остаться от прежнего сервера, который уже передал сокеты
+    sockaddr_un addr = handoffAddress(p);
+    unlink(addr.sun_path);
+    // Получивший сокеты процесс может принимать клиентов от имени сервера,
+    // поэтому сокет создаётся сразу недоступным для других пользователей
+    mode_t mask = umask(S_IRWXG | S_IRWXO);
+    int rc = bind(u, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+    int err = errno;
+    umask(mask);
+    if (rc == -1 || listen(u, 1) == -1) {
+        err = rc == -1 ? err : errno;
+        std::string errorMsg = "Ошибка bind (передача сокетов): " + std::string(strerror(err));
+        logError(p->logFile, errorMsg);
+        close(u);
+        throw std::system_error(err, std::generic_category());
+    }
+    if (chmod(addr.sun_path, S_IRUSR | S_IWUSR) == -1) {
+        err = errno;
+        std::string errorMsg = "Ошибка chmod (передача сокетов): " + std::string(strerror(err));
+        logError(p->logFile, errorMsg);
+        close(u);
+        unlink(addr.sun_path);
+        throw std::system_error(err, std::generic_category());
+    }
+    std::thread(serveHandoff, u, sockets, p).detach();
+}
+
+/**
+ * @brief Прекращение приёма соединений
+ * @details Безопасна для вызова из любого потока, в том числе до startHandoff
+ */
+void stopAccepting()
+{
+    if (!done.exchange(true)) {
+        wake(event.load());
+    }
+}
+
+/**
+ * @brief Признак прекращения приёма соединений
+ * @return true если сокеты переданы следующему серверу или получен сигнал остановки
+ */
+bool handoffDone()
+{
+    return done.load();
+}
+
+/**
+ * @brief Событие прекращения приёма
+ * @return Дескриптор eventfd или -1 до вызова startHandoff
+ */
+int handoffEvent()
+{
+    return event.load();
+}
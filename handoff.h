@@ -0,0 +1,72 @@
+/**
+ * @file handoff.h
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл передачи слушающих сокетов новому серверу
+ * @details Содержит перезапуск сервера без отказа в соединениях: новый
+ *          процесс получает слушающие сокеты работающего через Unix-сокет
+ *          (SCM_RIGHTS) вместо повторной привязки порта, а прежний
+ *          прекращает приём и завершается после окончания начатых сеансов.
+ *          Очередь входящих соединений принадлежит самому сокету, поэтому
+ *          соединения, пришедшие во время передачи, не теряются.
+ *
+ *          Тем же событием приём прекращается по сигналу остановки.
+ */
+
+#pragma once
+#include "interface.h"
+#include <vector>
+
+/// Наибольшее число сокетов, передаваемых одним сообщением
+#define HANDOFF_MAX_SOCKETS 64
+/// Тайм-аут accept, после которого проверяется передача сокетов, мс
+#define HANDOFF_POLL_MS 500
+/// Тайм-аут обмена по Unix-сокету передачи, мс
+#define HANDOFF_TIMEOUT_MS 5000
+
+/**
+ * @brief Получение слушающих сокетов работающего сервера
+ * @param[in] p Параметры сервера (путь p->Handoff)
+ * @param[out] sockets Полученные сокеты
+ * @return false если передача не настроена, работающего сервера нет
+ *         или сокеты получить не удалось (ошибка записывается в журнал)
+ * @details После получения работающий сервер прекращает приём
+ */
+bool receiveListeners(const Params* p, std::vector<int>& sockets);
+
+/**
+ * @brief Подготовка остановки приёма и ожидание следующего сервера
+ * @param[in] p Параметры сервера (путь p->Handoff; пустой — передача отключена)
+ * @param[in] sockets Слушающие сокеты, передаваемые следующему серверу
+ * @throw std::system_error при ошибке создания eventfd или Unix-сокета
+ * @details Вызывается до начала обслуживания клиентов. Слушающим сокетам
+ *          задаётся тайм-аут приёма HANDOFF_POLL_MS, чтобы блокирующий
+ *          accept периодически возвращал управление для проверки
+ *          handoffDone(). Ожидающий следующего сервера поток запускается
+ *          только при заданном пути передачи.
+ */
+void startHandoff(const Params* p, const std::vector<int>& sockets);
+
+/**
+ * @brief Прекращение приёма соединений
+ * @details Вызывается после передачи сокетов и по сигналу остановки.
+ *          Циклы приёма завершаются, дождавшись окончания начатых сеансов.
+ */
+void stopAccepting();
+
+/**
+ * @brief Признак прекращения приёма соединений
+ * @return true если приём соединений следует прекратить
+ */
+bool handoffDone();
+
+/**
+ * @brief Событие прекращения приёма
+ * @return Дескриптор eventfd, доступный для чтения после stopAccepting(),
+ *         или -1 до вызова startHandoff
+ * @details Позволяет прекратить приём без тайм-аута, когда accept
+ *          выполняется асинхронно (режим io_uring)
+ */
+int handoffEvent();
@@ -9,6 +9,8 @@
  */
 
 #include "interface.h"
+#include "handoff.h"
+#include <sys/un.h>
 
 /**
  * @brief Конструктор класса UserInterface
@@ -23,7 +25,33 @@ UserInterface::UserInterface() : desc("Allowed options")
     ("base,b", po::value<std::string>(&params.inFileName)->required(),"Set input data base name") ///< Обязательный параметр: файл базы пользователей
     ("journal,j", po::value<std::string>(&params.inFileJournal)->required(),"Set journal file name") ///< Обязательный параметр: файл журнала
     ("port,p", po::value<int>(&params.Port)->required(), "Set port") ///< Обязательный параметр: порт сервера
-    ("address,a", po::value<string>(&params.Address)->default_value("127.0.0.1"), "Set address"); ///< Адрес сервера (по умолчанию 127.0.0.1)
+    ("address,a", po::value<string>(&params.Address)->default_value("127.0.0.1"), "Set address") ///< Адрес сервера (по умолчанию 127.0.0.1)
+    ("threads,t", po::value<int>(&params.Threads)->default_value(0), "Set worker threads count (0 - number of cores)") ///< Размер пула рабочих потоков
+    ("mode,m", po::value<string>(&params.Mode)->default_value("threads"), "Set I/O mode: threads, epoll or uring") ///< Режим ввода-вывода (по умолчанию threads)
+    ("buffer", po::value<int>(&params.RecvBuffer)->default_value(262144), "Set receive buffer size in bytes") ///< Размер буфера приёма (по умолчанию 256 КиБ)
+    ("batch", po::value<int>(&params.ResultBatch)->default_value(64), "Set number of vector results sent in one packet (1 - send each result at once)") ///< Размер пакета результатов
+    ("log-queue", po::value<int>(&params.LogQueue)->default_value(8192), "Set log message queue capacity") ///< Ёмкость очереди журнала
+    ("log-flush", po::value<int>(&params.LogFlushMs)->default_value(100), "Set log flush interval in milliseconds") ///< Интервал записи журнала
+    ("log-overflow", po::value<string>(&params.LogOverflow)->default_value("drop"), "Set log queue overflow policy: drop or block") ///< Политика переполнения очереди журнала
+    ("stats-port", po::value<int>(&params.StatsPort)->default_value(0), "Set local port for Prometheus statistics (0 - disabled)") ///< Порт статистики
+    ("listeners", po::value<int>(&params.Listeners)->default_value(1), "Set number of SO_REUSEPORT listening sockets, each with its own threads") ///< Число слушающих сокетов
+    ("pin", po::bool_switch(&params.Pin), "Pin each listener and its threads to a CPU") ///< Привязка шардов к процессорам
+    ("backlog", po::value<int>(&params.Backlog)->default_value(128), "Set listen queue length") ///< Длина очереди listen
+    ("reduce-threads", po::value<int>(&params.ReduceThreads)->default_value(0), "Set threads for parallel reduction of large vectors (0 - number of cores)") ///< Потоки параллельной свёртки
+    ("parallel-threshold", po::value<int>(&params.ParallelThreshold)->default_value(1048576), "Set minimal vector size reduced in parallel (0 - disabled)") ///< Порог параллельной свёртки
+    ("login-timeout", po::value<int>(&params.LoginTimeout)->default_value(10000), "Set login timeout in milliseconds (0 - unlimited)") ///< Тайм-аут логина
+    ("hash-timeout", po::value<int>(&params.HashTimeout)->default_value(10000), "Set password hash timeout in milliseconds (0 - unlimited)") ///< Тайм-аут хеша
+    ("header-timeout", po::value<int>(&params.HeaderTimeout)->default_value(30000), "Set vector header timeout in milliseconds (0 - unlimited)") ///< Тайм-аут заголовка вектора
+    ("vector-timeout", po::value<int>(&params.VectorTimeout)->default_value(300000), "Set timeout for receiving elements of one vector in milliseconds (0 - unlimited)") ///< Тайм-аут элементов вектора
+    ("idle-timeout", po::value<int>(&params.IdleTimeout)->default_value(30000), "Set idle connection timeout in milliseconds (0 - unlimited)") ///< Тайм-аут простоя
+    ("ticket-ttl", po::value<int>(&params.TicketTtl)->default_value(300), "Set session resumption ticket lifetime in seconds (0 - tickets disabled)") ///< Срок действия билета возобновления
+    ("ticket-cache", po::value<int>(&params.TicketCache)->default_value(65536), "Set maximal number of valid resumption tickets") ///< Ёмкость кеша билетов
+    ("fail-rate", po::value<int>(&params.FailRate)->default_value(6), "Set failed logins per minute allowed from one address (0 - unlimited)") ///< Частота неудачных входов с адреса
+    ("fail-burst", po::value<int>(&params.FailBurst)->default_value(20), "Set failed logins in a row from one address before its connections are rejected") ///< Неудачные входы подряд
+    ("max-sessions", po::value<int>(&params.MaxSessions)->default_value(10000), "Set maximal number of concurrent sessions (0 - unlimited)") ///< Предел одновременных сеансов
+    ("max-vectors", po::value<int>(&params.MaxVectors)->default_value(0), "Set maximal number of vectors in one packet (0 - unlimited)") ///< Предел количества векторов
+    ("max-vector-size", po::value<int>(&params.MaxVectorSize)->default_value(0), "Set maximal vector size in elements (0 - unlimited)") ///< Предел размера вектора
+    ("handoff", po::value<string>(&params.Handoff)->default_value(""), "Set Unix socket path for handing listening sockets over to a restarted server (empty - disabled)"); ///< Путь передачи слушающих сокетов
 }
 
 /**
@@ -46,6 +74,55 @@ bool UserInterface::Parser(int argc, const char** argv)
     return false;
     // проверка обязательных параметров и присвоение значений
     po::notify(vm);
+    // проверка допустимых значений
+    if (params.Mode != "threads" && params.Mode != "epoll" && params.Mode != "uring")
+    throw po::validation_error(po::validation_error::invalid_option_value, "mode", params.Mode);
+    if (params.RecvBuffer < 1024)
+    throw po::validation_error(po::validation_error::invalid_option_value, "buffer", std::to_string(params.RecvBuffer));
+    if (params.ResultBatch < 1)
+    throw po::validation_error(po::validation_error::invalid_option_value, "batch", std::to_string(params.ResultBatch));
+    if (params.LogQueue < 2)
+    throw po::validation_error(po::validation_error::invalid_option_value, "log-queue", std::to_string(params.LogQueue));
+    if (params.LogOverflow != "drop" && params.LogOverflow != "block")
+    throw po::validation_error(po::validation_error::invalid_option_value, "log-overflow", params.LogOverflow);
+    if (params.StatsPort < 0 || params.StatsPort > 65535)
+    throw po::validation_error(po::validation_error::invalid_option_value, "stats-port", std::to_string(params.StatsPort));
+    if (params.Listeners < 1)
+    throw po::validation_error(po::validation_error::invalid_option_value, "listeners", std::to_string(params.Listeners));
+    if (params.Backlog < 1)
+    throw po::validation_error(po::validation_error::invalid_option_value, "backlog", std::to_string(params.Backlog));
+    if (params.ReduceThreads < 0)
+    throw po::validation_error(po::validation_error::invalid_option_value, "reduce-threads", std::to_string(params.ReduceThreads));
+    if (params.ParallelThreshold < 0)
+    throw po::validation_error(po::validation_error::invalid_option_value, "parallel-threshold", std::to_string(params.ParallelThreshold));
+    if (params.LoginTimeout < 0)
+    throw po::validation_error(po::validation_error::invalid_option_value, "login-timeout", std::to_string(params.LoginTimeout));
+    if (params.HashTimeout < 0)
+    throw po::validation_error(po::validation_error::invalid_option_value, "hash-timeout", std::to_string(params.HashTimeout));
+    if (params.HeaderTimeout < 0)
+    throw po::validation_error(po::validation_error::invalid_option_value, "header-timeout", std::to_string(params.HeaderTimeout));
+    if (params.VectorTimeout < 0)
+    throw po::validation_error(po::validation_error::invalid_option_value, "vector-timeout", std::to_string(params.VectorTimeout));
+    if (params.IdleTimeout < 0)
+    throw po::validation_error(po::validation_error::invalid_option_value, "idle-timeout", std::to_string(params.IdleTimeout));
+    if (params.TicketTtl < 0)
+    throw po::validation_error(po::validation_error::invalid_option_value, "ticket-ttl", std::to_string(params.TicketTtl));
+    if (params.TicketCache < 1)
+    throw po::validation_error(po::validation_error::invalid_option_value, "ticket-cache", std::to_string(params.TicketCache));
+    if (params.FailRate < 0)
+    throw po::validation_error(po::validation_error::invalid_option_value, "fail-rate", std::to_string(params.FailRate));
+    if (params.FailBurst < 1)
+    throw po::validation_error(po::validation_error::invalid_option_value, "fail-burst", std::to_string(params.FailBurst));
+    if (params.MaxSessions < 0)
+    throw po::validation_error(po::validation_error::invalid_option_value, "max-sessions", std::to_string(params.MaxSessions));
+    if (params.MaxVectors < 0)
+    throw po::validation_error(po::validation_error::invalid_option_value, "max-vectors", std::to_string(params.MaxVectors));
+    if (params.MaxVectorSize < 0)
+    throw po::validation_error(po::validation_error::invalid_option_value, "max-vector-size", std::to_string(params.MaxVectorSize));
+    if (params.Handoff.size() >= sizeof(sockaddr_un::sun_path))
+    throw po::validation_error(po::validation_error::invalid_option_value, "handoff", params.Handoff);
+    if (!params.Handoff.empty() && params.Listeners > HANDOFF_MAX_SOCKETS)
+    throw po::validation_error(po::validation_error::invalid_option_value, "listeners", std::to_string(params.Listeners));
     return true;
 }
 
@@ -27,6 +27,32 @@ struct Params {
     string logFile;         ///< Имя файла для логирования ошибок
     int Port;              ///< Порт сервера для прослушивания
     string Address;        ///< IP-адрес сервера
+    int Threads;           ///< Количество рабочих потоков (0 — по числу ядер)
+    string Mode;           ///< Режим ввода-вывода: threads, epoll или uring
+    int RecvBuffer;        ///< Размер буфера приёма данных клиента, байт
+    int ResultBatch;       ///< Число результатов, накапливаемых перед отправкой
+    int LogQueue;          ///< Ёмкость очереди сообщений журнала
+    int LogFlushMs;        ///< Максимальная задержка записи журнала, мс
+    string LogOverflow;    ///< Поведение при переполнении очереди журнала: drop или block
+    int StatsPort;         ///< Локальный порт статистики Prometheus (0 — отключена)
+    int Listeners;         ///< Число слушающих сокетов SO_REUSEPORT
+    bool Pin;              ///< Привязывать шарды слушающих сокетов к процессорам
+    int Backlog;           ///< Длина очереди входящих соединений listen
+    int ReduceThreads;     ///< Количество потоков параллельной свёртки (0 — по числу ядер)
+    int ParallelThreshold; ///< Минимальный размер вектора для параллельной свёртки (0 — отключена)
+    int LoginTimeout;      ///< Тайм-аут получения логина, мс (0 — не ограничен)
+    int HashTimeout;       ///< Тайм-аут получения хеша, мс (0 — не ограничен)
+    int HeaderTimeout;     ///< Тайм-аут получения заголовка вектора, мс (0 — не ограничен)
+    int VectorTimeout;     ///< Тайм-аут получения элементов вектора, мс (0 — не ограничен)
+    int IdleTimeout;       ///< Тайм-аут простоя соединения, мс (0 — не ограничен)
+    int TicketTtl;         ///< Срок действия билета возобновления сеанса, с (0 — билеты не выдаются)
+    int TicketCache;       ///< Наибольшее число действующих билетов возобновления
+    int FailRate;          ///< Восполнение неудачных входов с одного адреса в минуту (0 — не ограничено)
+    int FailBurst;         ///< Неудачные входы с одного адреса подряд до отклонения соединений
+    int MaxSessions;       ///< Наибольшее число одновременных сеансов (0 — без предела)
+    int MaxVectors;        ///< Наибольшее количество векторов в пакете (0 — без предела)
+    int MaxVectorSize;     ///< Наибольший размер вектора в элементах (0 — без предела)
+    string Handoff;        ///< Путь Unix-сокета передачи слушающих сокетов при перезапуске (пустой — отключена)
 };
 
 /**
@@ -5,10 +5,64 @@
  * @date 2025
  * @copyright ИБСТ ПГУ
  * @brief Реализация функций логирования
- * @details Реализует функции для записи логов с временными метками
+ * @details Реализует функции для записи логов с временными метками.
+ *          Сообщения передаются фоновому потоку через кольцевую очередь
+ *          без блокировок и записываются в файлы пакетами.
  */
 
 #include "log.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <ctime>
+#include <cstdlib>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+/**
+ * @struct TimeCache
+ * @brief Отформатированная часть временной метки до секунд
+ * @details У каждого потока своя копия, поэтому блокировки не нужны.
+ *          Дата и время переформатируются через localtime_r только при
+ *          смене секунды, миллисекунды дописываются в готовую строку.
+ */
+struct TimeCache {
+    time_t second = -1;   ///< Секунда, для которой построен префикс
+    char prefix[20];      ///< "ГГГГ-ММ-ДД ЧЧ:ММ:СС"
+};
+
+/**
+ * @brief Запись текущего времени в буфер вызывающей стороны
+ * @param[out] out Буфер не менее TIME_STAMP_SIZE символов
+ * @return Количество записанных символов
+ */
+size_t formatCurrentTime(char* out) {
+    thread_local TimeCache cache;
+    auto now = std::chrono::system_clock::now();
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+    time_t second = static_cast<time_t>(ms / 1000);
+    int millis = static_cast<int>(ms % 1000);
+
+    if (second != cache.second) {
+        std::tm local;
+        localtime_r(&second, &local);
+        char tmp[32];
+        strftime(tmp, sizeof(tmp), "%Y-%m-%d %H:%M:%S", &local);
+        memcpy(cache.prefix, tmp, sizeof(cache.prefix) - 1);
+        cache.second = second;
+    }
+    memcpy(out, cache.prefix, 19);
+    out[19] = '.';
+    out[20] = static_cast<char>('0' + millis / 100);
+    out[21] = static_cast<char>('0' + millis / 10 % 10);
+    out[22] = static_cast<char>('0' + millis % 10);
+    return TIME_STAMP_SIZE;
+}
 
 /**
  * @brief Получение текущего времени в формате строки
@@ -16,27 +70,269 @@
  * @details Форматирует текущее системное время с точностью до миллисекунд
  */
 std::string getCurrentTime() {
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch()) % 1000;
-    
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
-    ss << "." << std::setfill('0') << std::setw(3) << ms.count();
-    return ss.str();
+    char stamp[TIME_STAMP_SIZE];
+    return std::string(stamp, formatCurrentTime(stamp));
 }
 
 /**
- * @brief Запись ошибки в лог-файл
+ * @brief Запись ошибки в лог-файл напрямую
  * @param[in] logFile Имя файла для логирования
- * @param[in] errorMessage Сообщение об ошибке для записи
- * @details Добавляет запись в лог-файл с временной меткой и префиксом "ERROR"
+ * @param[in] line Готовая строка журнала
  */
-void logError(const std::string& logFile, const std::string& errorMessage) {
+static void writeDirect(const std::string& logFile, const std::string& line) {
     std::ofstream logStream(logFile, std::ios::app);
     if (logStream.is_open()) {
-        logStream << "[" << getCurrentTime() << "] ERROR: " << errorMessage << std::endl;
+        logStream << line << std::flush;
         logStream.close();
     }
-}
\ No newline at end of file
+}
+
+/// Размер накопленных строк файла, при котором они записываются досрочно
+#define LOG_WRITE_THRESHOLD 65536
+
+namespace {
+
+/**
+ * @struct LogSlot
+ * @brief Ячейка кольцевой очереди журнала
+ * @details Номер seq указывает, чья очередь работать с ячейкой: равен
+ *          позиции записи, когда ячейка свободна, и позиции + 1, когда
+ *          сообщение готово к чтению. Строки сохраняют выделенную память
+ *          между сообщениями.
+ */
+struct LogSlot {
+    std::atomic<size_t> seq;   ///< Номер поколения ячейки
+    std::string file;          ///< Имя файла журнала
+    std::string line;          ///< Готовая строка журнала
+};
+
+/**
+ * @struct Logger
+ * @brief Состояние фонового журнала
+ * @details Очередь со многими писателями и одним читателем (алгоритм
+ *          Вьюкова): писатели занимают позицию сравнением с обменом,
+ *          читатель — единственный поток записи в файлы
+ */
+struct Logger {
+    std::unique_ptr<LogSlot[]> ring;        ///< Кольцевой буфер
+    size_t mask = 0;                        ///< Ёмкость - 1
+    alignas(64) std::atomic<size_t> head{0};  ///< Следующая позиция записи
+    alignas(64) std::atomic<size_t> tail{0};  ///< Следующая позиция чтения
+    std::atomic<size_t> dropped{0};         ///< Отброшено сообщений
+    std::atomic<int> producers{0};          ///< Писатели внутри logError
+    std::atomic<bool> running{false};       ///< Приём сообщений в очередь
+    std::chrono::milliseconds interval{100};  ///< Интервал записи в файлы
+    LogOverflow policy = LOG_DROP;          ///< Политика переполнения
+    std::thread worker;                     ///< Поток записи
+    std::mutex mtx;                         ///< Мьютекс ожидания потока записи
+    std::condition_variable cv;             ///< Пробуждение потока записи
+
+    /**
+     * @brief Помещение строки в очередь
+     * @return false если очередь заполнена
+     */
+    bool push(const std::string& file, const std::string& line) {
+        size_t pos = head.load(std::memory_order_relaxed);
+        LogSlot* slot;
+        while (true) {
+            slot = &ring[pos & mask];
+            size_t seq = slot->seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+        slot->file = file;
+        slot->line = line;
+        slot->seq.store(pos + 1, std::memory_order_release);
+        // Поток записи будится досрочно, только когда очередь заполнена наполовину
+        if (pos - tail.load(std::memory_order_relaxed) >= (mask + 1) / 2) {
+            cv.notify_one();
+        }
+        return true;
+    }
+
+    /**
+     * @brief Извлечение строки из очереди (только поток записи)
+     * @param[out] batches Накопленные строки по файлам
+     * @return false если очередь пуста
+     */
+    bool pop(std::vector<std::pair<std::string, std::string>>& batches) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        LogSlot* slot = &ring[pos & mask];
+        if (slot->seq.load(std::memory_order_acquire) != pos + 1) {
+            return false;
+        }
+        auto it = batches.begin();
+        while (it != batches.end() && it->first != slot->file) {
+            ++it;
+        }
+        if (it == batches.end()) {
+            batches.emplace_back(slot->file, std::string());
+            it = batches.end() - 1;
+        }
+        it->second += slot->line;
+        slot->seq.store(pos + mask + 1, std::memory_order_release);
+        tail.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+};
+
+/// Фоновый журнал; не разрушается при выходе, чтобы поздние вызовы logError были безопасны
+Logger* logger = new Logger;
+
+/**
+ * @brief Запись накопленных строк в файлы
+ * @param[in,out] batches Строки по файлам (очищаются)
+ */
+void writeBatches(std::vector<std::pair<std::string, std::string>>& batches) {
+    size_t lost = batches.empty() ? 0 : logger->dropped.exchange(0);
+    if (lost > 0) {
+        batches.front().second += "[" + getCurrentTime() + "] ERROR: Журнал: пропущено сообщений: " + std::to_string(lost) + "\n";
+    }
+    for (auto& batch : batches) {
+        if (batch.second.empty()) {
+            continue;
+        }
+        int fd = open(batch.first.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+        if (fd != -1) {
+            size_t written = 0;
+            while (written < batch.second.size()) {
+                ssize_t n = write(fd, batch.second.data() + written, batch.second.size() - written);
+                if (n <= 0) {
+                    break;
+                }
+                written += n;
+            }
+            close(fd);
+        }
+        batch.second.clear();
+    }
+}
+
+/**
+ * @brief Цикл потока записи журнала
+ * @details Забирает все сообщения из очереди, записывает их в файлы
+ *          одним вызовом write на файл не реже раза в интервал, а при
+ *          остановке — до опустошения очереди
+ */
+void writerLoop() {
+    std::vector<std::pair<std::string, std::string>> batches;
+    auto lastWrite = std::chrono::steady_clock::now();
+    while (true) {
+        size_t pending = 0;
+        while (logger->pop(batches)) {
+            pending++;
+        }
+        bool stopping = !logger->running.load() && logger->producers.load() == 0;
+        size_t buffered = 0;
+        for (const auto& batch : batches) {
+            buffered += batch.second.size();
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (stopping || buffered >= LOG_WRITE_THRESHOLD || now - lastWrite >= logger->interval) {
+            if (stopping) {
+                // Сообщения, успевшие попасть в очередь до остановки писателей
+                while (logger->pop(batches)) {
+                }
+            }
+            writeBatches(batches);
+            lastWrite = now;
+            if (stopping) {
+                return;
+            }
+        }
+        if (pending == 0) {
+            std::unique_lock<std::mutex> lock(logger->mtx);
+            logger->cv.wait_for(lock, logger->interval);
+        }
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Запуск фонового потока записи журнала
+ * @param[in] capacity Ёмкость очереди сообщений
+ * @param[in] flushMs Максимальная задержка записи сообщения в файл, мс
+ * @param[in] policy Политика при переполнении очереди
+ */
+void startLogger(size_t capacity, int flushMs, LogOverflow policy) {
+    if (logger->running.load()) {
+        return;
+    }
+    size_t size = 2;
+    while (size < capacity) {
+        size *= 2;
+    }
+    logger->ring.reset(new LogSlot[size]);
+    for (size_t i = 0; i < size; i++) {
+        logger->ring[i].seq.store(i);
+    }
+    logger->mask = size - 1;
+    logger->head.store(0);
+    logger->tail.store(0);
+    logger->interval = std::chrono::milliseconds(flushMs > 0 ? flushMs : 1);
+    logger->policy = policy;
+    logger->running.store(true);
+    logger->worker = std::thread(writerLoop);
+
+    static bool registered = false;
+    if (!registered) {
+        std::atexit(stopLogger);
+        registered = true;
+    }
+}
+
+/**
+ * @brief Остановка фонового потока с записью всех сообщений очереди
+ */
+void stopLogger() {
+    if (!logger->running.exchange(false)) {
+        return;
+    }
+    logger->cv.notify_one();
+    if (logger->worker.joinable()) {
+        logger->worker.join();
+    }
+}
+
+/**
+ * @brief Запись ошибки в лог-файл
+ * @param[in] logFile Имя файла для логирования
+ * @param[in] errorMessage Сообщение об ошибке для записи
+ * @details Добавляет запись в лог-файл с временной меткой и префиксом "ERROR".
+ *          При работающем фоновом журнале строка с временем возникновения
+ *          помещается в очередь, иначе записывается в файл сразу.
+ */
+void logError(const std::string& logFile, const std::string& errorMessage) {
+    char stamp[TIME_STAMP_SIZE];
+    std::string line;
+    line.reserve(TIME_STAMP_SIZE + errorMessage.size() + 12);
+    line += '[';
+    line.append(stamp, formatCurrentTime(stamp));
+    line += "] ERROR: ";
+    line += errorMessage;
+    line += '\n';
+    logger->producers.fetch_add(1);
+    if (logger->running.load()) {
+        while (!logger->push(logFile, line)) {
+            if (logger->policy == LOG_DROP) {
+                logger->dropped.fetch_add(1);
+                break;
+            }
+            logger->cv.notify_one();
+            std::this_thread::yield();
+        }
+        logger->producers.fetch_sub(1);
+        return;
+    }
+    logger->producers.fetch_sub(1);
+    writeDirect(logFile, line);
+}
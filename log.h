@@ -8,6 +8,7 @@
  * @details Содержит объявления функций для работы с системой логирования
  */
 
+#pragma once
 #include "connection.h"
 #include "interface.h"
 #include <fstream>
@@ -15,15 +16,51 @@
 #include <chrono>
 #include <iomanip>
 
+/// Длина временной метки "ГГГГ-ММ-ДД ЧЧ:ММ:СС.ммм"
+#define TIME_STAMP_SIZE 23
+
 /**
  * @brief Получение текущего времени в формате строки
  * @return Строка с текущим временем в формате "ГГГГ-ММ-ДД ЧЧ:ММ:СС.ммм"
  */
 std::string getCurrentTime();
 
+/**
+ * @brief Запись текущего времени в буфер вызывающей стороны
+ * @param[out] out Буфер не менее TIME_STAMP_SIZE символов (без завершающего нуля)
+ * @return Количество записанных символов (TIME_STAMP_SIZE)
+ * @details Не выделяет память и безопасна для вызова из нескольких потоков
+ */
+size_t formatCurrentTime(char* out);
+
 /**
  * @brief Запись ошибки в лог-файл
  * @param[in] logFile Имя файла для логирования
  * @param[in] errorMessage Сообщение об ошибке для записи
  */
-void logError(const std::string& logFile, const std::string& errorMessage);
\ No newline at end of file
+void logError(const std::string& logFile, const std::string& errorMessage);
+
+/**
+ * @brief Политика при переполнении очереди журнала
+ */
+enum LogOverflow {
+    LOG_DROP,   ///< Сообщение отбрасывается, число потерь записывается в журнал
+    LOG_BLOCK   ///< Поток ждёт освобождения места в очереди
+};
+
+/**
+ * @brief Запуск фонового потока записи журнала
+ * @param[in] capacity Ёмкость очереди сообщений (округляется до степени двойки)
+ * @param[in] flushMs Максимальная задержка записи сообщения в файл, мс
+ * @param[in] policy Политика при переполнении очереди
+ * @details После запуска logError только помещает сообщение в очередь без
+ *          блокировок; фоновый поток записывает сообщения пакетами.
+ *          До запуска и после остановки logError пишет в файл сам.
+ */
+void startLogger(size_t capacity, int flushMs, LogOverflow policy);
+
+/**
+ * @brief Остановка фонового потока с записью всех сообщений очереди
+ * @details Вызывается автоматически при завершении процесса через exit()
+ */
+void stopLogger();
@@ -8,13 +8,18 @@
  */
 
 #include "connection.h"
+#include "handoff.h"
 #include "interface.h"
+#include "log.h"
+#include <csignal>
+#include <thread>
+#include <unistd.h>
 
 /**
  * @brief Главная функция серверного приложения
  * @param[in] argc Количество аргументов командной строки
  * @param[in] argv Массив аргументов командной строки
- * @return 0 при успешном выполнении, 1 при ошибке параметров
+ * @return 0 при успешном выполнении, 1 при ошибке параметров или запуска сервера
  */
 int main(int argc, const char** argv)
 {
@@ -26,9 +31,38 @@ int main(int argc, const char** argv)
         return 1;
     }
     
-    // Получение параметров и запуск сервера
+    // SIGINT и SIGTERM принимает отдельный поток. Первый сигнал прекращает приём:
+    // connection() возвращает управление после завершения начатых сеансов.
+    // Повторный сигнал завершает процесс сразу, дописав очередь журнала.
+    // Маска устанавливается до создания остальных потоков, они её наследуют
+    sigset_t stop;
+    sigemptyset(&stop);
+    sigaddset(&stop, SIGINT);
+    sigaddset(&stop, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop, nullptr);
+    std::thread([stop]() {
+        int sig;
+        sigwait(&stop, &sig);
+        stopAccepting();
+        sigwait(&stop, &sig);
+        stopLogger();
+        _exit(0);
+    }).detach();
+
+    // Получение параметров, запуск фонового журнала и сервера
     Params params = userinterface.getParams();
-    Connection::connection(&params);
-    
-    return 0;
-}
\ No newline at end of file
+    startLogger(params.LogQueue, params.LogFlushMs, params.LogOverflow == "block" ? LOG_BLOCK : LOG_DROP);
+    int status = 0;
+    try {
+        Connection::connection(&params);
+    } catch (const std::exception& e) {
+        // Ошибка записана в очередь журнала и попадёт в файл при остановке журнала
+        std::cerr << "Ошибка: " << e.what() << std::endl;
+        status = 1;
+    }
+
+    // Фоновые потоки (перезагрузка базы, статистика, свёртка) не останавливаются,
+    // поэтому статические объекты не разрушаются: журнал дописывается последним
+    stopLogger();
+    _exit(status);
+}
@@ -0,0 +1,252 @@
+/**
+ * @file metrics.cpp
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация счётчиков, гистограмм задержек и выдачи статистики
+ * @details Наборы счётчиков потоков не освобождаются: после завершения
+ *          потока его вклад остаётся в итоговых суммах.
+ */
+
+#include "metrics.h"
+#include "admission.h"
+#include "log.h"
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <netinet/in.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+thread_local MetricsShard* metricsShard = nullptr;
+double metricsNsPerTick = 1.0;
+
+namespace {
+
+std::mutex shardsMutex;                 ///< Защита списка наборов
+std::vector<MetricsShard*> shards;      ///< Наборы счётчиков всех потоков
+std::once_flag calibrated;              ///< Признак калибровки metricsClock
+
+/// Имена счётчиков аутентификации в порядке перечисления Metric
+const char* const authResults[] = {"ok", "fail", "user_not_found"};
+
+/// Имена гистограмм в порядке перечисления Histogram
+const char* const histogramNames[] = {"vecserver_auth_latency", "vecserver_vector_latency"};
+
+/**
+ * @brief Определение длительности такта metricsClock
+ * @details Сравнивает приращения metricsClock и steady_clock за 5 мс
+ */
+void calibrate()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    auto start = std::chrono::steady_clock::now();
+    uint64_t ticks = metricsClock();
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    ticks = metricsClock() - ticks;
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    if (ticks > 0) {
+        metricsNsPerTick = elapsed.count() / ticks;
+    }
+#endif
+}
+
+/**
+ * @brief Вывод гистограммы задержек
+ * @param[out] out Поток вывода
+ * @param[in] name Имя метрики без суффикса
+ * @param[in] buckets Суммарные интервалы гистограммы
+ * @param[in] sum Сумма задержек, нс
+ * @details Границы le — степени двойки от 256 нс до 17 с, квантили
+ *          вычисляются по полной точности интервалов и выводятся
+ *          отдельной метрикой
+ */
+void writeHistogram(std::ostringstream& out, const std::string& name, const std::vector<uint64_t>& buckets, uint64_t sum)
+{
+    uint64_t total = 0;
+    for (uint64_t b : buckets) {
+        total += b;
+    }
+
+    out << "# TYPE " << name << "_seconds histogram\n";
+    uint64_t cumulative = 0;
+    size_t bucket = 0;
+    for (unsigned order = 8; order <= 34; order++) {
+        size_t end = (order - 2) * LATENCY_SUB_BUCKETS;
+        for (; bucket < end; bucket++) {
+            cumulative += buckets[bucket];
+        }
+        out << name << "_seconds_bucket{le=\"" << static_cast<double>(1ull << order) / 1e9 << "\"} " << cumulative << "\n";
+    }
+    out << name << "_seconds_bucket{le=\"+Inf\"} " << total << "\n"
+        << name << "_seconds_sum " << sum / 1e9 << "\n"
+        << name << "_seconds_count " << total << "\n";
+
+    out << "# TYPE " << name << "_quantile_seconds gauge\n";
+    for (double q : {0.5, 0.99, 0.999}) {
+        uint64_t rank = static_cast<uint64_t>(q * total);
+        uint64_t seen = 0;
+        size_t i = 0;
+        while (i + 1 < buckets.size() && seen + buckets[i] <= rank) {
+            seen += buckets[i++];
+        }
+        double value = total ? latencyBucketLow(i + 1) / 1e9 : 0;
+        out << name << "_quantile_seconds{quantile=\"" << q << "\"} " << value << "\n";
+    }
+}
+
+/**
+ * @brief Цикл потока выдачи статистики
+ * @param[in] s Слушающий сокет
+ * @param[in] p Параметры сервера
+ * @details После ошибки accept поток ждёт AcceptBackoff: поток статистики
+ *          не должен мешать обслуживанию клиентов
+ */
+void serve(int s, const Params* p)
+{
+    AcceptBackoff backoff;
+    while (true) {
+        int client = accept(s, nullptr, nullptr);
+        if (client == -1) {
+            // Повторяющаяся ошибка не должна занимать ядро и заполнять журнал
+            if (errno != EINTR && errno != ECONNABORTED) {
+                backoff.pause(p, "Ошибка accept (статистика)", errno);
+            }
+            continue;
+        }
+        // Запрос не разбирается: на любой запрос отдаётся вся статистика
+        timeval timeout{1, 0};
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        char request[1024];
+        recv(client, request, sizeof(request), 0);
+
+        std::string body = metricsText();
+        std::string response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                               std::to_string(body.size()) + "\r\n\r\n" + body;
+        size_t sent = 0;
+        while (sent < response.size()) {
+            ssize_t n = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                break;
+            }
+            sent += n;
+        }
+        close(client);
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Создание и регистрация набора счётчиков текущего потока
+ * @return Набор счётчиков потока
+ */
+MetricsShard* registerMetricsShard()
+{
+    std::call_once(calibrated, calibrate);
+    MetricsShard* s = new MetricsShard;
+    std::lock_guard<std::mutex> lock(shardsMutex);
+    shards.push_back(s);
+    metricsShard = s;
+    return s;
+}
+
+/**
+ * @brief Статистика сервера в текстовом формате Prometheus
+ * @return Текст статистики
+ */
+std::string metricsText()
+{
+    uint64_t counters[MET_COUNT] = {};
+    std::vector<std::vector<uint64_t>> buckets(HIST_COUNT, std::vector<uint64_t>(LATENCY_BUCKETS));
+    uint64_t sums[HIST_COUNT] = {};
+    {
+        std::lock_guard<std::mutex> lock(shardsMutex);
+        for (const MetricsShard* s : shards) {
+            for (int m = 0; m < MET_COUNT; m++) {
+                counters[m] += s->counters[m].load(std::memory_order_relaxed);
+            }
+            for (int h = 0; h < HIST_COUNT; h++) {
+                for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+                    buckets[h][i] += s->buckets[h][i].load(std::memory_order_relaxed);
+                }
+                sums[h] += s->sums[h].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::ostringstream out;
+    out << "# TYPE vecserver_connections_accepted_total counter\n"
+        << "vecserver_connections_accepted_total " << counters[MET_ACCEPTED] << "\n"
+        << "# TYPE vecserver_auth_total counter\n";
+    for (int m = MET_AUTH_OK; m <= MET_USER_NOT_FOUND; m++) {
+        out << "vecserver_auth_total{result=\"" << authResults[m - MET_AUTH_OK] << "\"} " << counters[m] << "\n";
+    }
+    out << "# TYPE vecserver_vectors_total counter\n"
+        << "vecserver_vectors_total " << counters[MET_VECTORS] << "\n"
+        << "# TYPE vecserver_elements_total counter\n"
+        << "vecserver_elements_total " << counters[MET_ELEMENTS] << "\n"
+        << "# TYPE vecserver_received_bytes_total counter\n"
+        << "vecserver_received_bytes_total " << counters[MET_BYTES_IN] << "\n"
+        << "# TYPE vecserver_sent_bytes_total counter\n"
+        << "vecserver_sent_bytes_total " << counters[MET_BYTES_OUT] << "\n"
+        << "# TYPE vecserver_timeouts_total counter\n"
+        << "vecserver_timeouts_total " << counters[MET_TIMEOUTS] << "\n"
+        << "# TYPE vecserver_resumptions_total counter\n"
+        << "vecserver_resumptions_total{result=\"ok\"} " << counters[MET_RESUMED] << "\n"
+        << "vecserver_resumptions_total{result=\"rejected\"} " << counters[MET_RESUME_REJECTED] << "\n"
+        << "# TYPE vecserver_rejected_total counter\n"
+        << "vecserver_rejected_total{reason=\"sessions\"} " << counters[MET_REJECTED_BUSY] << "\n"
+        << "vecserver_rejected_total{reason=\"failed_logins\"} " << counters[MET_REJECTED_THROTTLED] << "\n"
+        << "vecserver_rejected_total{reason=\"vector_limits\"} " << counters[MET_REJECTED_LIMITS] << "\n"
+        << "# TYPE vecserver_sessions gauge\n"
+        << "vecserver_sessions " << activeSessions() << "\n";
+    for (int h = 0; h < HIST_COUNT; h++) {
+        writeHistogram(out, histogramNames[h], buckets[h], sums[h]);
+    }
+    return out.str();
+}
+
+/**
+ * @brief Запуск потока, отдающего статистику по HTTP
+ * @param[in] p Параметры сервера
+ * @throw std::system_error при ошибке создания слушающего сокета
+ */
+void startMetricsServer(const Params* p)
+{
+    if (p->StatsPort <= 0) {
+        return;
+    }
+    int s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s == -1) {
+        std::string errorMsg = "Ошибка создания сокета статистики: " + std::string(strerror(errno));
+        logError(p->logFile, errorMsg);
+        throw std::system_error(errno, std::generic_category());
+    }
+    int on = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    // При передаче сокетов новый сервер занимает порт, пока прежний завершает сеансы
+    if (!p->Handoff.empty()) {
+        setsockopt(s, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+    }
+
+    // Статистика доступна только локально
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(p->StatsPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(s, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == -1 || listen(s, 16) == -1) {
+        int err = errno;
+        std::string errorMsg = "Ошибка bind (статистика): " + std::string(strerror(err));
+        logError(p->logFile, errorMsg);
+        close(s);
+        throw std::system_error(err, std::generic_category());
+    }
+    std::thread(serve, s, p).detach();
+}
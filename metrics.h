@@ -0,0 +1,170 @@
+/**
+ * @file metrics.h
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл счётчиков и гистограмм задержек сервера
+ * @details Каждый поток пишет только в собственный набор счётчиков без
+ *          блокировок и атомарных read-modify-write операций. Наборы
+ *          потоков суммируются только при выдаче статистики, которая
+ *          отдаётся в текстовом формате Prometheus на отдельном порту.
+ */
+
+#pragma once
+#include "interface.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+/// Число поддиапазонов в каждом двоичном порядке гистограммы задержек
+#define LATENCY_SUB_BUCKETS 8
+/// Число интервалов гистограммы задержек (значения до 2^64 нс)
+#define LATENCY_BUCKETS 496
+
+/// Счётчики сервера
+enum Metric {
+    MET_ACCEPTED,           ///< Принятые соединения
+    MET_AUTH_OK,            ///< Успешные аутентификации
+    MET_AUTH_FAIL,          ///< Неверный хеш пароля
+    MET_USER_NOT_FOUND,     ///< Неизвестный логин
+    MET_VECTORS,            ///< Обработанные векторы
+    MET_ELEMENTS,           ///< Обработанные элементы векторов
+    MET_BYTES_IN,           ///< Принятые байты
+    MET_BYTES_OUT,          ///< Отправленные байты
+    MET_TIMEOUTS,           ///< Соединения, закрытые по тайм-ауту
+    MET_RESUMED,            ///< Сеансы, возобновлённые по билету
+    MET_RESUME_REJECTED,    ///< Отклонённые билеты возобновления
+    MET_REJECTED_BUSY,      ///< Соединения сверх предела одновременных сеансов
+    MET_REJECTED_THROTTLED, ///< Соединения с адресов, исчерпавших неудачные входы
+    MET_REJECTED_LIMITS,    ///< Пакеты сверх предела числа или размера векторов
+    MET_COUNT
+};
+
+/// Гистограммы задержек
+enum Histogram {
+    HIST_AUTH,              ///< Поиск пользователя и проверка хеша
+    HIST_VECTOR,            ///< Обработка вектора от размера до результата
+    HIST_COUNT
+};
+
+/**
+ * @struct MetricsShard
+ * @brief Счётчики одного потока
+ * @details Изменяются только потоком-владельцем, поэтому увеличение
+ *          выполняется обычными relaxed чтением и записью
+ */
+struct alignas(64) MetricsShard {
+    std::atomic<uint64_t> counters[MET_COUNT] = {};                     ///< Счётчики
+    std::atomic<uint64_t> buckets[HIST_COUNT][LATENCY_BUCKETS] = {};    ///< Интервалы гистограмм
+    std::atomic<uint64_t> sums[HIST_COUNT] = {};                        ///< Суммы задержек, нс
+};
+
+/// Набор счётчиков текущего потока (создаётся при первом обращении)
+extern thread_local MetricsShard* metricsShard;
+
+/// Наносекунд в одном такте metricsClock
+extern double metricsNsPerTick;
+
+/**
+ * @brief Создание и регистрация набора счётчиков текущего потока
+ * @return Набор счётчиков потока
+ */
+MetricsShard* registerMetricsShard();
+
+/**
+ * @brief Увеличение счётчика, принадлежащего текущему потоку
+ */
+inline void metricBump(std::atomic<uint64_t>& counter, uint64_t n)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Увеличение счётчика сервера
+ * @param[in] m Счётчик
+ * @param[in] n Приращение
+ */
+inline void metricAdd(Metric m, uint64_t n = 1)
+{
+    MetricsShard* s = metricsShard ? metricsShard : registerMetricsShard();
+    metricBump(s->counters[m], n);
+}
+
+/**
+ * @brief Дешёвая монотонная отметка времени для измерения задержек
+ * @return Такты TSC на x86, иначе наносекунды steady_clock
+ */
+inline uint64_t metricsClock()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/**
+ * @brief Номер интервала гистограммы для задержки
+ * @param[in] ns Задержка, нс
+ * @return Номер интервала; значения до 8 нс точны, далее каждый двоичный
+ *         порядок делится на LATENCY_SUB_BUCKETS равных частей
+ */
+inline size_t latencyBucket(uint64_t ns)
+{
+    if (ns < LATENCY_SUB_BUCKETS) {
+        return ns;
+    }
+    unsigned order = 63 - __builtin_clzll(ns);
+    return (order - 2) * LATENCY_SUB_BUCKETS + ((ns >> (order - 3)) & (LATENCY_SUB_BUCKETS - 1));
+}
+
+/**
+ * @brief Нижняя граница интервала гистограммы
+ * @param[in] bucket Номер интервала
+ * @return Наименьшая задержка интервала, нс
+ */
+inline uint64_t latencyBucketLow(size_t bucket)
+{
+    if (bucket < LATENCY_SUB_BUCKETS) {
+        return bucket;
+    }
+    unsigned order = bucket / LATENCY_SUB_BUCKETS + 2;
+    return static_cast<uint64_t>(LATENCY_SUB_BUCKETS + bucket % LATENCY_SUB_BUCKETS) << (order - 3);
+}
+
+/**
+ * @brief Запись задержки в гистограмму
+ * @param[in] h Гистограмма
+ * @param[in] ticks Длительность в тактах metricsClock
+ */
+inline void metricLatency(Histogram h, uint64_t ticks)
+{
+    MetricsShard* s = metricsShard ? metricsShard : registerMetricsShard();
+    uint64_t ns = static_cast<uint64_t>(ticks * metricsNsPerTick);
+    metricBump(s->buckets[h][latencyBucket(ns)], 1);
+    metricBump(s->sums[h], ns);
+}
+
+/**
+ * @brief Статистика сервера в текстовом формате Prometheus
+ * @return Сумма счётчиков всех потоков, гистограммы и квантили задержек
+ */
+std::string metricsText();
+
+/**
+ * @brief Запуск потока, отдающего статистику по HTTP
+ * @details Слушает 127.0.0.1:p->StatsPort и на каждое соединение
+ *          отвечает результатом metricsText(). Ничего не делает, если
+ *          порт не задан.
+ * @param[in] p Параметры сервера
+ * @throw std::system_error при ошибке создания слушающего сокета
+ */
+void startMetricsServer(const Params* p);
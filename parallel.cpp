@@ -0,0 +1,160 @@
+/**
+ * @file parallel.cpp
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация параллельной свёртки больших векторов
+ */
+
+#include "parallel.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <atomic>
+
+/// Пул вычислительных потоков; не разрушается, задачи могут выполняться до exit()
+static WorkStealingPool* pool = nullptr;
+
+/// Порог параллельной свёртки; записывается после создания пула
+static std::atomic<uint64_t> threshold{0};
+
+/// Мьютекс запуска пула
+static std::mutex startMtx;
+
+/**
+ * @brief Запуск пула параллельной свёртки
+ * @param[in] threads Количество вычислительных потоков (0 — по числу ядер)
+ * @param[in] min Минимальное число элементов вектора (0 — отключено)
+ */
+void startParallelReduce(size_t threads, uint64_t min)
+{
+    std::lock_guard<std::mutex> lock(startMtx);
+    if (pool == nullptr && min > 0) {
+        pool = new WorkStealingPool(threads);
+    }
+    threshold.store(pool != nullptr ? min : 0);
+}
+
+/**
+ * @brief Порог параллельной свёртки
+ * @return Минимальное число элементов или 0, если пул не запущен
+ */
+uint64_t parallelThreshold()
+{
+    return threshold.load();
+}
+
+/**
+ * @brief Конструктор свёртки вектора
+ * @param[in] op Операция
+ * @param[in] type Тип элементов
+ * @param[in] bytes Размер элементов вектора, байт
+ * @details Память не выделяется до прихода элементов: размер из заголовка
+ *          задаёт клиент, и его одного недостаточно, чтобы занять буферы
+ */
+ParallelReduction::ParallelReduction(Operation op, ElementType type, uint64_t bytes)
+    : op(op), type(type), kernel(reduceKernel(op, type)), remaining(bytes)
+{
+}
+
+/**
+ * @brief Деструктор
+ */
+ParallelReduction::~ParallelReduction()
+{
+    waitFor(0);
+}
+
+/**
+ * @brief Добавление принятых элементов
+ * @param[in] data Целые элементы (для OP_DOT — пары)
+ * @param[in] len Длина данных в байтах
+ * @details Размер части кратен размеру пары любого типа, поэтому граница
+ *          части не разделяет элементы
+ */
+void ParallelReduction::add(const char* data, size_t len)
+{
+    remaining -= std::min<uint64_t>(remaining, len);
+    while (len > 0) {
+        size_t part = std::min(len, PARALLEL_CHUNK - chunk.size());
+        chunk.append(data, part);
+        data += part;
+        len -= part;
+        if (chunk.size() == PARALLEL_CHUNK) {
+            submit();
+        }
+    }
+}
+
+/**
+ * @brief Отправка заполненной части в пул
+ * @details Буферы завершённых частей используются повторно, чтобы каждая
+ *          часть не выделяла и не заполняла страницы памяти заново. Место
+ *          под результат части добавляется при отправке, а новая часть
+ *          резервируется не больше ещё не принятого остатка вектора.
+ */
+void ParallelReduction::submit()
+{
+    // Не более двух ожидающих частей на поток: память ограничена при медленной свёртке
+    waitFor(2 * pool->size());
+    std::string data;
+    data.swap(chunk);
+    size_t idx;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        pending++;
+        idx = partials.size();
+        partials.push_back(reduceInit(op, type));
+        if (!spare.empty()) {
+            chunk.swap(spare.back());
+            spare.pop_back();
+        }
+    }
+    chunk.clear();
+    chunk.reserve(std::min<uint64_t>(PARALLEL_CHUNK, remaining));
+    pool->submit([this, idx, data = std::move(data)]() mutable {
+        Reduction r = reduceInit(op, type);
+        kernel(data.data(), data.size() / elementSize(type), r);
+        std::lock_guard<std::mutex> lock(mtx);
+        partials[idx] = r;
+        spare.push_back(std::move(data));
+        pending--;
+        done.notify_all();
+    });
+}
+
+/**
+ * @brief Ожидание задач, пока их не более limit
+ * @param[in] limit Допустимое число незавершённых задач
+ * @details Пока задачи не завершены, поток выполняет задачи пула сам и
+ *          засыпает, только когда все они уже выполняются другими потоками
+ */
+void ParallelReduction::waitFor(size_t limit)
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    while (pending > limit) {
+        lock.unlock();
+        bool ran = pool->runOne();
+        lock.lock();
+        if (!ran && pending > limit) {
+            done.wait(lock);
+        }
+    }
+}
+
+/**
+ * @brief Завершение свёртки вектора
+ * @return Результат свёртки всех элементов
+ */
+Reduction ParallelReduction::finish()
+{
+    if (!chunk.empty()) {
+        submit();
+    }
+    waitFor(0);
+    Reduction result = reduceInit(op, type);
+    for (const Reduction& part : partials) {
+        reduceCombine(op, type, result, part);
+    }
+    return result;
+}
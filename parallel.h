@@ -0,0 +1,105 @@
+/**
+ * @file parallel.h
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл параллельной свёртки больших векторов
+ * @details Содержит разбиение вектора на части по мере приёма и свёртку
+ *          частей в общем пуле вычислительных потоков с перехватом задач
+ */
+
+#pragma once
+#include "reduce.h"
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// Размер части вектора, сворачиваемой одной задачей, байт
+#define PARALLEL_CHUNK (1 << 20)
+
+/**
+ * @brief Запуск пула параллельной свёртки
+ * @param[in] threads Количество вычислительных потоков (0 — по числу ядер)
+ * @param[in] threshold Минимальное число элементов вектора для параллельной
+ *                      свёртки (0 — параллельная свёртка отключена)
+ * @details Повторный вызов меняет только порог
+ */
+void startParallelReduce(size_t threads, uint64_t threshold);
+
+/**
+ * @brief Порог параллельной свёртки
+ * @return Минимальное число элементов или 0, если пул не запущен
+ */
+uint64_t parallelThreshold();
+
+/**
+ * @class ParallelReduction
+ * @brief Параллельная свёртка одного вектора
+ * @details Принятые элементы копируются в части по PARALLEL_CHUNK байт;
+ *          заполненная часть сворачивается задачей пула, пока принимаются
+ *          следующие. Результаты частей объединяются по порядку, поэтому
+ *          итог не зависит от того, какими порциями пришли данные и в каком
+ *          порядке завершились задачи. Число ещё не свёрнутых частей
+ *          ограничено: при его превышении принимающий поток сам выполняет
+ *          задачи пула.
+ */
+class ParallelReduction
+{
+private:
+    Operation op;                    ///< Операция
+    ElementType type;                ///< Тип элементов
+    ReduceKernel kernel;             ///< Ядро свёртки
+    std::string chunk;               ///< Заполняемая часть
+    std::vector<Reduction> partials; ///< Результаты отправленных частей по порядку
+    std::vector<std::string> spare;  ///< Буферы свёрнутых частей для повторного использования
+    uint64_t remaining;              ///< Ещё не принятые байты вектора
+    size_t pending = 0;              ///< Число незавершённых задач
+    std::mutex mtx;                  ///< Мьютекс счётчика задач
+    std::condition_variable done;    ///< Уведомление о завершении задачи
+
+    /**
+     * @brief Отправка заполненной части в пул
+     */
+    void submit();
+
+    /**
+     * @brief Ожидание задач, пока их не более limit
+     * @param[in] limit Допустимое число незавершённых задач
+     */
+    void waitFor(size_t limit);
+
+public:
+    /**
+     * @brief Конструктор свёртки вектора
+     * @param[in] op Операция
+     * @param[in] type Тип элементов
+     * @param[in] bytes Размер элементов вектора, байт
+     */
+    ParallelReduction(Operation op, ElementType type, uint64_t bytes);
+
+    /**
+     * @brief Деструктор
+     * @details Дожидается задач, ссылающихся на объект, если вектор не был
+     *          принят полностью
+     */
+    ~ParallelReduction();
+
+    ParallelReduction(const ParallelReduction&) = delete;
+    ParallelReduction& operator=(const ParallelReduction&) = delete;
+
+    /**
+     * @brief Добавление принятых элементов
+     * @param[in] data Целые элементы (для OP_DOT — пары)
+     * @param[in] len Длина данных в байтах
+     */
+    void add(const char* data, size_t len);
+
+    /**
+     * @brief Завершение свёртки вектора
+     * @return Результат свёртки всех элементов
+     */
+    Reduction finish();
+};
@@ -0,0 +1,423 @@
+/**
+ * @file reactor.cpp
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация событийного режима сервера на epoll
+ * @details Главный поток принимает соединения и распределяет их по кругу
+ *          между потоками реактора. Поток реактора читает данные до EAGAIN
+ *          в общий для потока буфер, передаёт их сеансу и отправляет
+ *          накопленный ответ. Неполные 4-байтовые слова сохраняются в
+ *          сеансе между чтениями, поэтому память на соединение постоянна.
+ *
+ *          Сроки стадий обмена и простоя всех соединений потока отслеживаются
+ *          колесом таймеров: epoll_wait ждёт не дольше следующего деления,
+ *          после чего соединения с истёкшим сроком закрываются.
+ *
+ *          Хеши паролей, принятые за один вызов epoll_wait, проверяются
+ *          пакетом после обработки всех событий.
+ */
+
+#include "reactor.h"
+#include "admission.h"
+#include "handoff.h"
+#include "connection.h"
+#include "session.h"
+#include "log.h"
+#include "metrics.h"
+#include "timeout.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <fcntl.h>
+#include <memory>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/// Объём неотправленного ответа, при котором чтение от клиента приостанавливается
+#define REACTOR_OUT_LIMIT 65536
+/// Максимальное число событий за один вызов epoll_wait
+#define REACTOR_MAX_EVENTS 256
+
+namespace {
+
+/**
+ * @struct LoopState
+ * @brief Состояние потока реактора, видимое потоку приёма
+ */
+struct LoopState {
+    std::atomic<long> open{0};  ///< Открытые соединения потока
+    std::atomic<int> error{0};  ///< Ошибка epoll_wait, завершившая поток (errno)
+};
+
+/**
+ * @struct Client
+ * @brief Состояние соединения в реакторе
+ */
+struct Client : TimerNode {
+    int fd;                 ///< Сокет клиента
+    Session session;        ///< Автомат протокола
+    Deadline deadline;      ///< Сроки стадий обмена и простоя
+    std::string pending;    ///< Непотреблённый сеансом остаток данных
+    bool readable = true;   ///< В сокете могут быть непрочитанные данные
+    bool eof = false;       ///< Клиент закрыл соединение на запись
+    uint32_t flushed = 0;   ///< Число векторов, результаты которых переданы в send
+    std::atomic<long>* open;  ///< Счётчик открытых соединений потока реактора
+
+    Client(int fd, const Params* p, const UserRegistry* users, uint32_t peer, std::atomic<long>* open)
+        : fd(fd), session(p, users, true, peer), deadline(p, monotonicMs()), open(open) {
+        open->fetch_add(1);
+    }
+};
+
+/**
+ * @brief Закрытие соединения и освобождение состояния клиента
+ * @param[in] c Клиент
+ * @param[in] wheel Колесо таймеров потока или nullptr, если таймер не ставился
+ */
+void closeClient(Client* c, TimerWheel* wheel)
+{
+    if (wheel) {
+        wheel->cancel(c);
+    }
+    close(c->fd); // Закрытие сокета удаляет его из epoll
+    c->open->fetch_sub(1);
+    delete c;
+    releaseClient();
+}
+
+/**
+ * @brief Отправка накопленного ответа до заполнения буфера сокета
+ * @param[in] c Клиент
+ * @param[in] p Параметры сервера
+ * @param[in] now Текущее время, мс
+ * @return false при ошибке отправки
+ */
+bool flush(Client* c, const Params* p, uint64_t now)
+{
+    size_t sent = 0;
+    while (sent < c->session.out.size()) {
+        ssize_t n = send(c->fd, c->session.out.data() + sent, c->session.out.size() - sent, MSG_NOSIGNAL);
+        if (n == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            logError(p->logFile, "Ошибка send: " + std::string(strerror(errno)));
+            return false;
+        }
+        sent += n;
+    }
+    c->session.out.erase(0, sent);
+    c->flushed = c->session.vector();
+    metricAdd(MET_BYTES_OUT, sent);
+    if (sent > 0) {
+        c->deadline.touch(now);
+    }
+    return true;
+}
+
+/**
+ * @brief Передача принятых данных сеансу
+ * @param[in] session Сеанс клиента
+ * @param[in] data Данные
+ * @param[in] len Длина данных
+ * @return Количество потреблённых байт
+ */
+size_t feed(Session& session, const char* data, size_t len)
+{
+    size_t pos = 0;
+    while (pos < len && !session.finished()) {
+        size_t used = session.onData(data + pos, len - pos);
+        if (used == 0) {
+            break;
+        }
+        pos += used;
+    }
+    return pos;
+}
+
+/**
+ * @brief Обслуживание готового к вводу-выводу соединения
+ * @param[in] c Клиент
+ * @param[in] buffer Буфер чтения потока реактора размером p->RecvBuffer + FRAME_PENDING_MAX
+ * @param[in] p Параметры сервера
+ * @param[in] wheel Колесо таймеров потока
+ * @param[in] now Текущее время, мс
+ * @return false если соединение закрыто и клиент освобождён
+ * @details Ответ отправляется, когда в сокете не осталось данных или
+ *          накоплено p->ResultBatch результатов, поэтому результаты
+ *          многих мелких векторов уходят одним пакетом. Результаты
+ *          считаются по векторам, а не по байтам ответа, поэтому размер
+ *          пакета не зависит от разрядности результата и кадров протокола
+ *          версии 2, как и в режиме потоков. Пока хеш ожидает пакетной
+ *          проверки, чтение не выполняется.
+ */
+bool service(Client* c, char* buffer, const Params* p, TimerWheel& wheel, uint64_t now)
+{
+    uint32_t batch = static_cast<uint32_t>(p->ResultBatch);
+    while (true) {
+        bool dry = !c->readable || c->eof || c->session.finished();
+        bool full = c->session.vector() - c->flushed >= batch || c->session.out.size() >= REACTOR_OUT_LIMIT;
+        if ((dry || full) && !flush(c, p, now)) {
+            closeClient(c, &wheel);
+            return false;
+        }
+        if (c->session.finished() || c->eof) {
+            if (c->session.out.empty()) {
+                closeClient(c, &wheel);
+                return false;
+            }
+            return true; // Дождёмся EPOLLOUT
+        }
+        if (c->session.out.size() >= REACTOR_OUT_LIMIT) {
+            return true; // Клиент не успевает читать ответы
+        }
+        if (!c->readable || c->session.state() == Session::VERIFY) {
+            return true;
+        }
+
+        // Остаток прошлого чтения помещается в начало буфера
+        size_t carry = c->pending.size();
+        memcpy(buffer, c->pending.data(), carry);
+        ssize_t n = recv(c->fd, buffer + carry, p->RecvBuffer, 0);
+        if (n == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                c->readable = false;
+                continue;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            logError(p->logFile, "Ошибка recv: " + std::string(strerror(errno)));
+            closeClient(c, &wheel);
+            return false;
+        }
+        if (n == 0) {
+            c->session.onClose();
+            c->eof = true;
+            continue;
+        }
+
+        metricAdd(MET_BYTES_IN, n);
+        c->deadline.touch(now);
+        size_t total = carry + n;
+        size_t pos = feed(c->session, buffer, total);
+        c->pending.assign(buffer + pos, c->session.finished() ? 0 : total - pos);
+    }
+}
+
+/**
+ * @brief Закрытие соединений с истёкшим сроком
+ * @param[in] wheel Колесо таймеров потока
+ * @param[in] due Буфер сработавших таймеров
+ * @param[in] p Параметры сервера
+ * @param[in] now Текущее время, мс
+ * @details Таймер продлённого после постановки срока ставится заново
+ */
+void reap(TimerWheel& wheel, std::vector<TimerNode*>& due, const Params* p, uint64_t now)
+{
+    wheel.expire(now, due);
+    for (TimerNode* node : due) {
+        Client* c = static_cast<Client*>(node);
+        uint64_t at = c->deadline.at();
+        if (at == 0 || at > now) {
+            wheel.limit(c, at);
+            continue;
+        }
+        metricAdd(MET_TIMEOUTS);
+        logError(p->logFile, c->deadline.message(now, c->session.where()));
+        closeClient(c, &wheel);
+    }
+    due.clear();
+}
+
+/**
+ * @brief Пакетная проверка хешей и продолжение обслуживания клиентов
+ * @param[in] verifying Клиенты, сеансы которых ожидают проверки хеша
+ * @param[in] buffer Буфер чтения потока реактора
+ * @param[in] p Параметры сервера
+ * @param[in] wheel Колесо таймеров потока
+ * @param[in] now Текущее время, мс
+ * @details Данные, пришедшие вместе с хешем, передаются сеансу до
+ *          следующего чтения, поэтому остаток снова помещается в буфер
+ */
+void verify(std::vector<Client*>& verifying, char* buffer, const Params* p, TimerWheel& wheel, uint64_t now)
+{
+    thread_local std::vector<Session*> sessions;
+    sessions.clear();
+    for (Client* c : verifying) {
+        sessions.push_back(&c->session);
+    }
+    Session::verify(sessions);
+    for (Client* c : verifying) {
+        size_t used = feed(c->session, c->pending.data(), c->pending.size());
+        c->pending.erase(0, c->session.finished() ? c->pending.size() : used);
+        if (service(c, buffer, p, wheel, now)) {
+            c->deadline.progress(c->session.stage(), c->session.vector(), now);
+            wheel.limit(c, c->deadline.at());
+        }
+    }
+    verifying.clear();
+}
+
+/**
+ * @brief Цикл потока реактора
+ * @param[in] epfd Дескриптор epoll потока
+ * @param[in] p Параметры сервера
+ * @param[out] state Состояние потока
+ * @details Таймер соединения ставится потоком реактора при первом событии
+ *          (EPOLLOUT приходит сразу после регистрации сокета) и после
+ *          каждого обслуживания, когда стадия обмена могла смениться.
+ *          Событие с пустым указателем завершает цикл. Ошибка epoll_wait
+ *          прекращает приём сервера: соединения потока больше не
+ *          обслуживаются, и Reactor::run не ждёт их закрытия.
+ */
+void loop(int epfd, const Params* p, LoopState* state)
+{
+    // Остаток прошлого чтения не превышает неполного кадра протокола версии 2
+    std::vector<char> buffer(p->RecvBuffer + FRAME_PENDING_MAX);
+    epoll_event events[REACTOR_MAX_EVENTS];
+    TimerWheel wheel(monotonicMs());
+    std::vector<TimerNode*> due;
+    std::vector<Client*> verifying;
+    while (true) {
+        int n = epoll_wait(epfd, events, REACTOR_MAX_EVENTS, wheel.timeout(monotonicMs()));
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            int err = errno;
+            logError(p->logFile, "Ошибка epoll_wait: " + std::string(strerror(err)));
+            state->error.store(err);
+            stopAccepting();
+            return;
+        }
+        uint64_t now = monotonicMs();
+        for (int i = 0; i < n; i++) {
+            Client* c = static_cast<Client*>(events[i].data.ptr);
+            if (c == nullptr) {
+                return; // Сеансы завершены после прекращения приёма
+            }
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                c->readable = true;
+            }
+            if (!service(c, buffer.data(), p, wheel, now)) {
+                continue;
+            }
+            if (c->session.state() == Session::VERIFY) {
+                verifying.push_back(c);
+            } else {
+                c->deadline.progress(c->session.stage(), c->session.vector(), now);
+                wheel.limit(c, c->deadline.at());
+            }
+        }
+        if (!verifying.empty()) {
+            verify(verifying, buffer.data(), p, wheel, now);
+        }
+        reap(wheel, due, p, now);
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Запуск реактора на слушающем сокете
+ * @param[in] s Дескриптор слушающего сокета
+ * @param[in] p Параметры сервера
+ * @param[in] users Реестр базы пользователей
+ * @param[in] threads Число потоков реактора
+ * @return 0 после прекращения приёма и завершения сеансов
+ * @throw std::system_error при ошибках epoll или слушающего сокета
+ */
+int Reactor::run(int s, const Params* p, const UserRegistry* users, size_t threads)
+{
+    // Событие остановки потоков реактора после прекращения приёма
+    int stop = eventfd(0, EFD_CLOEXEC);
+    if (stop == -1) {
+        std::string errorMsg = "Ошибка eventfd: " + std::string(strerror(errno));
+        logError(p->logFile, errorMsg);
+        throw std::system_error(errno, std::generic_category());
+    }
+    std::vector<int> epolls;
+    std::vector<std::thread> workers;
+    std::unique_ptr<LoopState[]> states(new LoopState[threads]);
+    std::exception_ptr failure;
+    try {
+        for (size_t i = 0; i < threads; i++) {
+            int epfd = epoll_create1(EPOLL_CLOEXEC);
+            if (epfd == -1) {
+                std::string errorMsg = "Ошибка epoll_create: " + std::string(strerror(errno));
+                logError(p->logFile, errorMsg);
+                throw std::system_error(errno, std::generic_category());
+            }
+            epolls.push_back(epfd);
+            epoll_event ev = {};
+            ev.events = EPOLLIN;
+            ev.data.ptr = nullptr;
+            if (epoll_ctl(epfd, EPOLL_CTL_ADD, stop, &ev) == -1) {
+                std::string errorMsg = "Ошибка epoll_ctl: " + std::string(strerror(errno));
+                logError(p->logFile, errorMsg);
+                throw std::system_error(errno, std::generic_category());
+            }
+            workers.emplace_back(loop, epfd, p, &states[i]);
+        }
+
+        for (size_t next = 0; !handoffDone(); next = (next + 1) % threads) {
+            uint32_t peer;
+            int client_socket = Connection::acceptClient(s, p, peer);
+            if (client_socket == -1) {
+                continue;
+            }
+            fcntl(client_socket, F_SETFL, fcntl(client_socket, F_GETFL) | O_NONBLOCK);
+
+            Client* c = new Client(client_socket, p, users, peer, &states[next].open);
+            epoll_event ev;
+            ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+            ev.data.ptr = c;
+            if (epoll_ctl(epolls[next], EPOLL_CTL_ADD, client_socket, &ev) == -1) {
+                logError(p->logFile, "Ошибка epoll_ctl: " + std::string(strerror(errno)));
+                closeClient(c, nullptr);
+            }
+        }
+    } catch (const std::exception&) {
+        // Ошибка уже записана в журнал; начатые сеансы завершаются, как в пуле потоков
+        failure = std::current_exception();
+    }
+
+    // Приём прекращён: потоки останавливаются после завершения своих сеансов
+    for (size_t i = 0; i < workers.size(); i++) {
+        while (states[i].open.load() > 0 && states[i].error.load() == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    uint64_t one = 1;
+    if (write(stop, &one, sizeof(one)) != sizeof(one)) {
+        logError(p->logFile, "Ошибка write (остановка реактора): " + std::string(strerror(errno)));
+    }
+    for (auto& t : workers) {
+        t.join();
+    }
+    for (int epfd : epolls) {
+        close(epfd);
+    }
+    close(stop);
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+    for (size_t i = 0; i < workers.size(); i++) {
+        if (states[i].error.load() != 0) {
+            throw std::system_error(states[i].error.load(), std::generic_category());
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,37 @@
+/**
+ * @file reactor.h
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл событийного режима сервера на epoll
+ * @details Содержит объявление реактора, обслуживающего множество клиентов
+ *          небольшим числом потоков с неблокирующими сокетами
+ */
+
+#pragma once
+#include "interface.h"
+#include "userbase.h"
+
+/**
+ * @class Reactor
+ * @brief Событийный сервер на основе epoll в режиме edge-triggered
+ * @details Принятые соединения распределяются по потокам реактора,
+ *          у каждого из которых собственный экземпляр epoll. Каждое
+ *          соединение ведётся автоматом состояний Session, поэтому
+ *          медленные и простаивающие клиенты не занимают потоков.
+ */
+class Reactor
+{
+public:
+    /**
+     * @brief Запуск реактора на слушающем сокете
+     * @param[in] s Дескриптор слушающего сокета
+     * @param[in] p Параметры сервера
+     * @param[in] users Реестр базы пользователей
+     * @param[in] threads Число потоков реактора
+     * @return 0 после прекращения приёма и завершения сеансов
+     * @throw std::system_error при ошибках epoll или слушающего сокета
+     */
+    static int run(int s, const Params* p, const UserRegistry* users, size_t threads);
+};
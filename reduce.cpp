@@ -0,0 +1,507 @@
+/**
+ * @file reduce.cpp
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация ядер свёртки векторов
+ * @details Ядра записаны один раз шаблоном на векторных расширениях GCC и
+ *          специализируются при компиляции по операции, типу элементов и
+ *          ширине регистра. Шаблон встраивается (always_inline) в обёртки с
+ *          атрибутом target, поэтому каждая обёртка получает код своего
+ *          набора инструкций без флагов -mavx2/-mavx512f.
+ *
+ *          Целочисленные суммы над int32_t точны: слагаемое расширяется до
+ *          64 бит, а произведения делятся на младшие и старшие 32 бита, как в
+ *          точных ядрах суммы квадратов. Суммы над int64_t вычисляются по
+ *          модулю 2^64, над float и double — в double. Пары скалярного
+ *          произведения разделяются перестановкой __builtin_shuffle.
+ */
+
+#include "reduce.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+/**
+ * @brief Чтение значения из потока
+ * @param[out] v Значение или вектор
+ * @param[in] p Указатель на данные (выравнивание не требуется)
+ * @details Вектор возвращается через ссылку: возврат по значению из
+ *          функции без атрибута target менял бы ABI
+ */
+template <typename T>
+__attribute__((always_inline)) static inline void load(T& v, const char* p)
+{
+    memcpy(&v, p, sizeof(v));
+}
+
+/**
+ * @brief Векторный тип GCC
+ * @tparam E Тип элемента
+ * @tparam W Размер вектора в байтах
+ */
+template <typename E, size_t W>
+struct VectorOf {
+    typedef E type __attribute__((vector_size(W)));
+};
+
+/**
+ * @brief Учёт кандидата в минимум или максимум
+ * @param[in,out] r Промежуточный результат
+ * @param[in] v Значение элемента
+ */
+template <Operation OP, typename T>
+static inline void combine(Reduction& r, T v)
+{
+    if constexpr (std::is_floating_point_v<T>) {
+        r.real = OP == OP_MIN ? std::min<double>(r.real, v) : std::max<double>(r.real, v);
+    } else {
+        r.exact = OP == OP_MIN ? std::min<__int128>(r.exact, v) : std::max<__int128>(r.exact, v);
+    }
+}
+
+/**
+ * @brief Скалярное ядро свёртки
+ * @param[in] data Элементы
+ * @param[in] n Количество элементов
+ * @param[in,out] r Промежуточный результат
+ * @details Эталон для векторных вариантов и обработчик их хвостов
+ */
+template <Operation OP, typename T>
+static void reduceScalar(const char* data, size_t n, Reduction& r)
+{
+    const size_t step = OP == OP_DOT ? 2 : 1;
+    for (size_t i = 0; i + step <= n; i += step) {
+        T x, y;
+        load(x, data + i * sizeof(T));
+        load(y, data + (OP == OP_DOT ? i + 1 : i) * sizeof(T));
+        if constexpr (OP == OP_MIN || OP == OP_MAX) {
+            combine<OP, T>(r, x);
+        } else if constexpr (std::is_floating_point_v<T> || (OP == OP_L2 && std::is_same_v<T, int64_t>)) {
+            double a = static_cast<double>(x);
+            r.real += OP == OP_SUM ? a : OP == OP_L1 ? std::fabs(a) : a * static_cast<double>(y);
+        } else if constexpr (std::is_same_v<T, int64_t>) {
+            // Беззнаковая арифметика даёт переполнение по модулю 2^64
+            uint64_t a = static_cast<uint64_t>(x);
+            uint64_t t = OP == OP_SUM ? a : OP == OP_L1 ? (x < 0 ? 0 - a : a) : a * static_cast<uint64_t>(y);
+            r.exact = static_cast<uint64_t>(static_cast<uint64_t>(r.exact) + t);
+        } else {
+            int64_t a = x;
+            r.exact += OP == OP_SUM ? a : OP == OP_L1 ? (a < 0 ? -a : a) : a * y;
+        }
+    }
+}
+
+/**
+ * @brief Векторное ядро свёртки
+ * @tparam W Ширина регистра в байтах
+ * @param[in] data Элементы
+ * @param[in] n Количество элементов
+ * @param[in,out] r Промежуточный результат
+ */
+template <Operation OP, typename T, size_t W>
+__attribute__((always_inline)) static inline void reduceVector(const char* data, size_t n, Reduction& r)
+{
+    typedef typename VectorOf<T, W>::type V;
+    typedef std::conditional_t<sizeof(T) == sizeof(int32_t), int32_t, int64_t> I;
+    typedef typename VectorOf<I, W>::type M;
+    typedef typename VectorOf<uint64_t, W>::type U;
+    // Накопители расширенной точности с тем же числом элементов
+    typedef typename VectorOf<double, W / sizeof(T) * sizeof(double)>::type D;
+    typedef typename VectorOf<int64_t, W / sizeof(T) * sizeof(int64_t)>::type Q;
+    constexpr size_t lanes = W / sizeof(T);
+    constexpr size_t block = OP == OP_DOT ? 2 * lanes : lanes;
+
+    // Перестановки, собирающие из двух регистров первые и вторые элементы пар
+    M even, odd;
+    for (size_t k = 0; k < lanes; k++) {
+        even[k] = static_cast<I>(2 * k);
+        odd[k] = static_cast<I>(2 * k + 1);
+    }
+
+    size_t i = 0;
+    if constexpr (OP == OP_MIN || OP == OP_MAX) {
+        T start;
+        if constexpr (std::is_floating_point_v<T>) {
+            start = static_cast<T>(r.real);
+        } else {
+            start = static_cast<T>(r.exact);
+        }
+        V m = V{} + start;
+        for (; i + block <= n; i += block) {
+            V x;
+            load(x, data + i * sizeof(T));
+            m = OP == OP_MIN ? (x < m ? x : m) : (x > m ? x : m);
+        }
+        for (size_t k = 0; k < lanes; k++) {
+            combine<OP, T>(r, m[k]);
+        }
+    } else if constexpr (std::is_floating_point_v<T> || (OP == OP_L2 && std::is_same_v<T, int64_t>)) {
+        D acc = {};
+        for (; i + block <= n; i += block) {
+            D a, b;
+            if constexpr (OP == OP_DOT) {
+                V x, y;
+                load(x, data + i * sizeof(T));
+                load(y, data + i * sizeof(T) + W);
+                a = __builtin_convertvector(__builtin_shuffle(x, y, even), D);
+                b = __builtin_convertvector(__builtin_shuffle(x, y, odd), D);
+            } else {
+                V x;
+                load(x, data + i * sizeof(T));
+                if constexpr (OP == OP_L1 && !std::is_same_v<T, int64_t>) {
+                    // Модуль берётся до расширения, в регистрах исходной ширины
+                    x = x < V{} ? -x : x;
+                }
+                a = b = __builtin_convertvector(x, D);
+            }
+            if constexpr (OP == OP_SUM || OP == OP_L1) {
+                acc += a;
+            } else {
+                acc += a * b;
+            }
+        }
+        double sum = 0;
+        for (size_t k = 0; k < lanes; k++) {
+            sum += acc[k];
+        }
+        r.real += sum;
+    } else if constexpr (std::is_same_v<T, int64_t>) {
+        U acc = {};
+        for (; i + block <= n; i += block) {
+            V x, y;
+            if constexpr (OP == OP_DOT) {
+                V first, second;
+                load(first, data + i * sizeof(T));
+                load(second, data + i * sizeof(T) + W);
+                x = __builtin_shuffle(first, second, even);
+                y = __builtin_shuffle(first, second, odd);
+            } else {
+                load(x, data + i * sizeof(T));
+                y = x;
+            }
+            U a = reinterpret_cast<U>(x);
+            if constexpr (OP == OP_SUM) {
+                acc += a;
+            } else if constexpr (OP == OP_L1) {
+                acc += x < V{} ? U{} - a : a;
+            } else {
+                acc += a * reinterpret_cast<U>(y);
+            }
+        }
+        uint64_t sum = 0;
+        for (size_t k = 0; k < lanes; k++) {
+            sum += acc[k];
+        }
+        r.exact = static_cast<uint64_t>(static_cast<uint64_t>(r.exact) + sum);
+    } else {
+        Q lo = {};
+        Q hi = {};
+        for (; i + block <= n; i += block) {
+            Q a, b;
+            if constexpr (OP == OP_DOT) {
+                V x, y;
+                load(x, data + i * sizeof(T));
+                load(y, data + i * sizeof(T) + W);
+                a = __builtin_convertvector(__builtin_shuffle(x, y, even), Q);
+                b = __builtin_convertvector(__builtin_shuffle(x, y, odd), Q);
+            } else {
+                V x;
+                load(x, data + i * sizeof(T));
+                a = b = __builtin_convertvector(x, Q);
+            }
+            if constexpr (OP == OP_SUM) {
+                lo += a;
+            } else if constexpr (OP == OP_L1) {
+                lo += a < Q{} ? -a : a;
+            } else {
+                // Произведение до 2^62 по модулю: младшие 32 бита и знаковые старшие
+                Q t = a * b;
+                lo += t & 0xFFFFFFFF;
+                hi += t >> 32;
+            }
+        }
+        __int128 sum = 0;
+        for (size_t k = 0; k < lanes; k++) {
+            sum += static_cast<__int128>(hi[k]) * (static_cast<int64_t>(1) << 32) + lo[k];
+        }
+        r.exact += sum;
+    }
+    reduceScalar<OP, T>(data + i * sizeof(T), n - i, r);
+}
+
+/// Ядро свёртки на SSE2
+template <Operation OP, typename T>
+__attribute__((target("sse2")))
+static void reduceSse2(const char* data, size_t n, Reduction& r)
+{
+    reduceVector<OP, T, 16>(data, n, r);
+}
+
+/// Ядро свёртки на AVX2
+template <Operation OP, typename T>
+__attribute__((target("avx2")))
+static void reduceAvx2(const char* data, size_t n, Reduction& r)
+{
+    reduceVector<OP, T, 32>(data, n, r);
+}
+
+/// Ядро свёртки на AVX-512
+template <Operation OP, typename T>
+__attribute__((target("avx512f")))
+static void reduceAvx512(const char* data, size_t n, Reduction& r)
+{
+    reduceVector<OP, T, 64>(data, n, r);
+}
+
+/**
+ * @brief Сумма квадратов int32_t точными ядрами simd.cpp
+ * @details Невыровненные данные обрабатываются скалярным ядром
+ */
+template <SimdLevel L>
+static void squaresInt32(const char* data, size_t n, Reduction& r)
+{
+    if (reinterpret_cast<uintptr_t>(data) % alignof(int32_t) == 0) {
+        r.exact += sumSquaresWideAt(L, reinterpret_cast<const int32_t*>(data), n);
+    } else {
+        reduceScalar<OP_SUM_SQUARES, int32_t>(data, n, r);
+    }
+}
+
+/**
+ * @brief Выбор варианта ядра по набору инструкций
+ * @param[in] level Набор инструкций
+ * @return Указатель на ядро
+ */
+template <Operation OP, typename T>
+static ReduceKernel kernelAt(SimdLevel level)
+{
+    if constexpr ((OP == OP_SUM_SQUARES || OP == OP_L2) && std::is_same_v<T, int32_t>) {
+        switch (level) {
+        case SIMD_AVX512:
+            return squaresInt32<SIMD_AVX512>;
+        case SIMD_AVX2:
+            return squaresInt32<SIMD_AVX2>;
+        case SIMD_SSE2:
+            return squaresInt32<SIMD_SSE2>;
+        default:
+            return reduceScalar<OP_SUM_SQUARES, int32_t>;
+        }
+    }
+    switch (level) {
+    case SIMD_AVX512:
+        return reduceAvx512<OP, T>;
+    case SIMD_AVX2:
+        return reduceAvx2<OP, T>;
+    case SIMD_SSE2:
+        return reduceSse2<OP, T>;
+    default:
+        return reduceScalar<OP, T>;
+    }
+}
+
+/**
+ * @brief Выбор ядра по операции
+ * @param[in] level Набор инструкций
+ * @param[in] op Операция
+ * @return Указатель на ядро
+ */
+template <typename T>
+static ReduceKernel kernelAt(SimdLevel level, Operation op)
+{
+    switch (op) {
+    case OP_SUM:
+        return kernelAt<OP_SUM, T>(level);
+    case OP_MIN:
+        return kernelAt<OP_MIN, T>(level);
+    case OP_MAX:
+        return kernelAt<OP_MAX, T>(level);
+    case OP_DOT:
+        return kernelAt<OP_DOT, T>(level);
+    case OP_L1:
+        return kernelAt<OP_L1, T>(level);
+    case OP_L2:
+        return kernelAt<OP_L2, T>(level);
+    default:
+        return kernelAt<OP_SUM_SQUARES, T>(level);
+    }
+}
+
+/**
+ * @brief Размер элемента
+ * @param[in] type Тип элементов
+ * @return Размер в байтах
+ */
+size_t elementSize(ElementType type)
+{
+    return type == ELEM_INT64 || type == ELEM_DOUBLE ? 8 : 4;
+}
+
+/**
+ * @brief Начальное значение свёртки
+ * @param[in] op Операция
+ * @param[in] type Тип элементов
+ * @return Нейтральный элемент операции
+ */
+Reduction reduceInit(Operation op, ElementType type)
+{
+    Reduction r;
+    if (op == OP_MIN) {
+        r.exact = type == ELEM_INT64 ? INT64_MAX : INT32_MAX;
+        r.real = std::numeric_limits<double>::infinity();
+    } else if (op == OP_MAX) {
+        r.exact = type == ELEM_INT64 ? INT64_MIN : INT32_MIN;
+        r.real = -std::numeric_limits<double>::infinity();
+    }
+    return r;
+}
+
+/**
+ * @brief Объединение результатов свёртки соседних частей вектора
+ * @param[in] op Операция
+ * @param[in] type Тип элементов
+ * @param[in,out] into Результат предыдущих частей
+ * @param[in] part Результат следующей части
+ */
+void reduceCombine(Operation op, ElementType type, Reduction& into, const Reduction& part)
+{
+    if (op == OP_MIN) {
+        into.exact = std::min(into.exact, part.exact);
+        into.real = std::min(into.real, part.real);
+    } else if (op == OP_MAX) {
+        into.exact = std::max(into.exact, part.exact);
+        into.real = std::max(into.real, part.real);
+    } else if (type == ELEM_INT64 && op != OP_L2) {
+        into.exact = static_cast<uint64_t>(static_cast<uint64_t>(into.exact) + static_cast<uint64_t>(part.exact));
+    } else {
+        into.exact += part.exact;
+        into.real += part.real;
+    }
+}
+
+/**
+ * @brief Ядро свёртки для заданного набора инструкций
+ * @param[in] level Набор инструкций
+ * @param[in] op Операция
+ * @param[in] type Тип элементов
+ * @return Указатель на ядро
+ */
+ReduceKernel reduceKernelAt(SimdLevel level, Operation op, ElementType type)
+{
+    switch (type) {
+    case ELEM_INT64:
+        return kernelAt<int64_t>(level, op);
+    case ELEM_FLOAT:
+        return kernelAt<float>(level, op);
+    case ELEM_DOUBLE:
+        return kernelAt<double>(level, op);
+    default:
+        return kernelAt<int32_t>(level, op);
+    }
+}
+
+/**
+ * @brief Ядро свёртки с автоматическим выбором набора инструкций
+ * @param[in] op Операция
+ * @param[in] type Тип элементов
+ * @return Указатель на ядро
+ */
+ReduceKernel reduceKernel(Operation op, ElementType type)
+{
+    static const SimdLevel level = detectSimdLevel();
+    return reduceKernelAt(level, op, type);
+}
+
+/**
+ * @brief Размер результата свёртки
+ * @param[in] op Операция
+ * @param[in] type Тип элементов
+ * @param[in] acc Режим накопления
+ * @return 4 или 8 байт
+ */
+size_t reduceResultSize(Operation op, ElementType type, Accumulation acc)
+{
+    if (type != ELEM_INT32) {
+        return type == ELEM_FLOAT ? sizeof(float) : sizeof(int64_t);
+    }
+    return op == OP_L2 || acc == ACC_INT64 || acc == ACC_UINT64 ? sizeof(int64_t) : sizeof(int32_t);
+}
+
+/**
+ * @brief Дописывание значения в буфер ответа
+ * @param[out] out Буфер ответа
+ * @param[in] v Значение
+ */
+template <typename T>
+static void append(std::string& out, T v)
+{
+    out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+/**
+ * @brief Приведение точного значения с насыщением
+ * @param[in] v Точное значение
+ * @return Ближайшее значение, представимое типом T
+ */
+template <typename T>
+static T saturate(__int128 v)
+{
+    if (v < static_cast<__int128>(std::numeric_limits<T>::min())) {
+        return std::numeric_limits<T>::min();
+    }
+    if (v > static_cast<__int128>(std::numeric_limits<T>::max())) {
+        return std::numeric_limits<T>::max();
+    }
+    return static_cast<T>(v);
+}
+
+/**
+ * @brief Запись результата свёртки
+ * @param[in] op Операция
+ * @param[in] type Тип элементов
+ * @param[in] acc Режим накопления
+ * @param[in] r Результат свёртки всех элементов вектора
+ * @param[out] out Буфер ответа
+ */
+void reduceFinish(Operation op, ElementType type, Accumulation acc, const Reduction& r, std::string& out)
+{
+    switch (type) {
+    case ELEM_FLOAT:
+        append<float>(out, static_cast<float>(op == OP_L2 ? std::sqrt(r.real) : r.real));
+        return;
+    case ELEM_DOUBLE:
+        append<double>(out, op == OP_L2 ? std::sqrt(r.real) : r.real);
+        return;
+    case ELEM_INT64:
+        if (op == OP_L2) {
+            append<double>(out, std::sqrt(r.real));
+        } else {
+            append<int64_t>(out, static_cast<int64_t>(static_cast<uint64_t>(r.exact)));
+        }
+        return;
+    case ELEM_INT32:
+        break;
+    }
+    if (op == OP_L2) {
+        append<double>(out, std::sqrt(static_cast<double>(r.exact)));
+        return;
+    }
+    switch (acc) {
+    case ACC_WRAP32:
+        append<int32_t>(out, static_cast<int32_t>(static_cast<uint32_t>(r.exact)));
+        break;
+    case ACC_SAT32:
+        append<int32_t>(out, saturate<int32_t>(r.exact));
+        break;
+    case ACC_INT64:
+        append<int64_t>(out, saturate<int64_t>(r.exact));
+        break;
+    case ACC_UINT64:
+        append<uint64_t>(out, saturate<uint64_t>(r.exact));
+        break;
+    }
+}
@@ -0,0 +1,137 @@
+/**
+ * @file reduce.h
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл ядер свёртки векторов
+ * @details Содержит операции свёртки (сумма, сумма квадратов, минимум,
+ *          максимум, скалярное произведение, нормы L1 и L2) над элементами
+ *          int32_t, int64_t, float и double и выбор ядра для пары
+ *          операция/тип с учётом набора инструкций процессора
+ */
+
+#pragma once
+#include "simd.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Режим накопления результата, младший байт слова режима
+ * @details Применяется к целочисленным операциям над int32_t. Без
+ *          расширенного заголовка используется ACC_WRAP32. В режимах
+ *          ACC_INT64, ACC_UINT64 и ACC_SAT32 результат вычисляется точно и
+ *          при выходе за диапазон заменяется ближайшим представимым.
+ */
+enum Accumulation {
+    ACC_WRAP32 = 0,     ///< int32_t по модулю 2^32 (исходный протокол)
+    ACC_INT64 = 1,      ///< int64_t с насыщением
+    ACC_UINT64 = 2,     ///< uint64_t с насыщением
+    ACC_SAT32 = 3       ///< int32_t с насыщением
+};
+
+/**
+ * @brief Операция свёртки, второй байт слова режима
+ */
+enum Operation {
+    OP_SUM_SQUARES = 0, ///< Сумма квадратов (исходный протокол)
+    OP_SUM = 1,         ///< Сумма элементов
+    OP_MIN = 2,         ///< Минимум (для пустого вектора — максимум типа)
+    OP_MAX = 3,         ///< Максимум (для пустого вектора — минимум типа)
+    OP_DOT = 4,         ///< Скалярное произведение пар a0 b0 a1 b1 ...
+    OP_L1 = 5,          ///< Сумма модулей
+    OP_L2 = 6           ///< Евклидова норма
+};
+
+/**
+ * @brief Тип элементов вектора, третий байт слова режима
+ */
+enum ElementType {
+    ELEM_INT32 = 0,     ///< int32_t (исходный протокол)
+    ELEM_INT64 = 1,     ///< int64_t, результат по модулю 2^64
+    ELEM_FLOAT = 2,     ///< float, накопление в double
+    ELEM_DOUBLE = 3     ///< double
+};
+
+/**
+ * @struct Reduction
+ * @brief Промежуточный результат свёртки
+ * @details Ядро дополняет его очередной порцией элементов, поэтому вектор
+ *          может обрабатываться частями по мере приёма
+ */
+struct Reduction {
+    __int128 exact = 0;  ///< Целочисленная сумма, минимум или максимум
+    double real = 0;     ///< Вещественная сумма, минимум или максимум
+};
+
+/**
+ * @brief Ядро свёртки
+ * @param[in] data Элементы (выравнивание не требуется)
+ * @param[in] n Количество элементов; для OP_DOT чётное
+ * @param[in,out] r Промежуточный результат
+ */
+typedef void (*ReduceKernel)(const char* data, size_t n, Reduction& r);
+
+/**
+ * @brief Размер элемента
+ * @param[in] type Тип элементов
+ * @return Размер в байтах
+ */
+size_t elementSize(ElementType type);
+
+/**
+ * @brief Начальное значение свёртки
+ * @param[in] op Операция
+ * @param[in] type Тип элементов
+ * @return Нейтральный элемент операции
+ */
+Reduction reduceInit(Operation op, ElementType type);
+
+/**
+ * @brief Объединение результатов свёртки соседних частей вектора
+ * @param[in] op Операция
+ * @param[in] type Тип элементов
+ * @param[in,out] into Результат предыдущих частей
+ * @param[in] part Результат следующей части
+ */
+void reduceCombine(Operation op, ElementType type, Reduction& into, const Reduction& part);
+
+/**
+ * @brief Ядро свёртки для заданного набора инструкций
+ * @param[in] level Набор инструкций (должен поддерживаться процессором)
+ * @param[in] op Операция
+ * @param[in] type Тип элементов
+ * @return Указатель на ядро
+ */
+ReduceKernel reduceKernelAt(SimdLevel level, Operation op, ElementType type);
+
+/**
+ * @brief Ядро свёртки с автоматическим выбором набора инструкций
+ * @param[in] op Операция
+ * @param[in] type Тип элементов
+ * @return Указатель на ядро
+ */
+ReduceKernel reduceKernel(Operation op, ElementType type);
+
+/**
+ * @brief Размер результата свёртки
+ * @param[in] op Операция
+ * @param[in] type Тип элементов
+ * @param[in] acc Режим накопления
+ * @return 4 или 8 байт
+ */
+size_t reduceResultSize(Operation op, ElementType type, Accumulation acc);
+
+/**
+ * @brief Запись результата свёртки
+ * @param[in] op Операция
+ * @param[in] type Тип элементов
+ * @param[in] acc Режим накопления
+ * @param[in] r Результат свёртки всех элементов вектора
+ * @param[out] out Буфер ответа, в конец которого дописывается результат
+ * @details Для int32_t результат приводится к типу режима накопления,
+ *          для int64_t — int64_t, для float и double — тип элемента.
+ *          OP_L2 над целыми числами возвращает double.
+ */
+void reduceFinish(Operation op, ElementType type, Accumulation acc, const Reduction& r, std::string& out);
@@ -0,0 +1,122 @@
+/**
+ * @file reload.cpp
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация перезагрузки базы пользователей
+ * @details Наблюдение ведётся за каталогом файла базы, а не за самим файлом:
+ *          редакторы и системы развёртывания часто заменяют файл
+ *          переименованием, после чего наблюдение за старым inode теряется.
+ */
+
+#include "reload.h"
+#include "log.h"
+#include <csignal>
+#include <cstring>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/signalfd.h>
+#include <thread>
+#include <unistd.h>
+
+/**
+ * @brief Блокировка SIGHUP в вызывающем потоке
+ */
+void UserReloader::blockSignals()
+{
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+}
+
+/**
+ * @brief Загрузка базы из файла и публикация в реестре
+ * @param[in] registry Реестр базы пользователей
+ * @param[in] p Параметры сервера
+ * @return false если файл не удалось открыть
+ */
+bool UserReloader::reload(UserRegistry* registry, const Params* p)
+{
+    std::unique_ptr<UserBase> base(new UserBase);
+    if (!base->load(p->inFileName, p->Threads > 0 ? p->Threads : 0)) {
+        logError(p->logFile, "Ошибка открытия базы пользователей: " + p->inFileName);
+        return false;
+    }
+    registry->publish(std::move(base));
+    return true;
+}
+
+/**
+ * @brief Цикл потока перезагрузки
+ * @param[in] registry Реестр базы пользователей
+ * @param[in] p Параметры сервера
+ */
+static void watch(UserRegistry* registry, const Params* p)
+{
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGHUP);
+    int sfd = signalfd(-1, &mask, SFD_CLOEXEC);
+    if (sfd == -1) {
+        logError(p->logFile, "Ошибка signalfd: " + std::string(strerror(errno)));
+    }
+
+    // Каталог и имя файла базы
+    std::string dir = ".";
+    std::string name = p->inFileName;
+    size_t slash = p->inFileName.rfind('/');
+    if (slash != std::string::npos) {
+        dir = slash == 0 ? "/" : p->inFileName.substr(0, slash);
+        name = p->inFileName.substr(slash + 1);
+    }
+    int ifd = inotify_init1(IN_CLOEXEC);
+    if (ifd != -1 && inotify_add_watch(ifd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) == -1) {
+        logError(p->logFile, "Ошибка inotify_add_watch (" + dir + "): " + std::string(strerror(errno)));
+        close(ifd);
+        ifd = -1;
+    }
+
+    pollfd fds[2] = {{sfd, POLLIN, 0}, {ifd, POLLIN, 0}};
+    alignas(inotify_event) char events[4096];
+    while (true) {
+        if (poll(fds, 2, -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            logError(p->logFile, "Ошибка poll (перезагрузка базы): " + std::string(strerror(errno)));
+            return;
+        }
+        bool changed = false;
+        if (fds[0].revents & POLLIN) {
+            signalfd_siginfo info;
+            if (read(sfd, &info, sizeof(info)) == sizeof(info)) {
+                changed = true;
+            }
+        }
+        if (fds[1].revents & POLLIN) {
+            ssize_t len = read(ifd, events, sizeof(events));
+            for (ssize_t pos = 0; pos < len;) {
+                const inotify_event* ev = reinterpret_cast<const inotify_event*>(events + pos);
+                if (ev->len > 0 && name == ev->name) {
+                    changed = true;
+                }
+                pos += sizeof(inotify_event) + ev->len;
+            }
+        }
+        if (changed) {
+            UserReloader::reload(registry, p);
+        }
+    }
+}
+
+/**
+ * @brief Запуск фонового потока перезагрузки
+ * @param[in] registry Реестр базы пользователей
+ * @param[in] p Параметры сервера
+ */
+void UserReloader::start(UserRegistry* registry, const Params* p)
+{
+    std::thread(watch, registry, p).detach();
+}
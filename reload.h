@@ -0,0 +1,44 @@
+/**
+ * @file reload.h
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл перезагрузки базы пользователей
+ * @details Содержит фоновый поток, перестраивающий базу пользователей при
+ *          изменении файла базы (inotify) или по сигналу SIGHUP
+ */
+
+#pragma once
+#include "interface.h"
+#include "userbase.h"
+
+/**
+ * @class UserReloader
+ * @brief Перезагрузка базы пользователей без перезапуска сервера
+ */
+class UserReloader
+{
+public:
+    /**
+     * @brief Блокировка SIGHUP в вызывающем потоке
+     * @details Вызывается до создания остальных потоков, чтобы они
+     *          унаследовали маску и сигнал принимался только через signalfd
+     */
+    static void blockSignals();
+
+    /**
+     * @brief Загрузка базы из файла и публикация в реестре
+     * @param[in] registry Реестр базы пользователей
+     * @param[in] p Параметры сервера
+     * @return false если файл не удалось открыть (действующая база сохраняется)
+     */
+    static bool reload(UserRegistry* registry, const Params* p);
+
+    /**
+     * @brief Запуск фонового потока перезагрузки
+     * @param[in] registry Реестр базы пользователей
+     * @param[in] p Параметры сервера
+     */
+    static void start(UserRegistry* registry, const Params* p);
+};
@@ -0,0 +1,379 @@
+/**
+ * @file session.cpp
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация сеанса клиента
+ */
+
+#include "session.h"
+#include "admission.h"
+#include "connection.h"
+#include "log.h"
+#include "metrics.h"
+#include "ticket.h"
+#include <algorithm>
+#include <cstring>
+
+/**
+ * @brief Отправка сообщения клиенту
+ * @param[in] type Тип кадра протокола версии 2
+ * @param[in] text Сообщение; в исходном протоколе передаётся без кадра
+ */
+void Session::reply(FrameType type, const std::string& text)
+{
+    if (framed) {
+        appendFrame(out, type, text.data(), text.size());
+    } else {
+        out += text;
+    }
+}
+
+/**
+ * @brief Обработка логина
+ * @param[in] data Сообщение клиента
+ * @param[in] len Длина сообщения
+ */
+void Session::onLogin(const char* data, size_t len)
+{
+    login.assign(data, strnlen(data, len));
+    authTicks = metricsClock();
+    bool found = users->find(login, password);
+    authTicks = metricsClock() - authTicks;
+    if (!found) {
+        metricAdd(MET_USER_NOT_FOUND);
+        metricLatency(HIST_AUTH, authTicks);
+        logError(p->logFile, "Пользователь не найден: " + login);
+        loginFailed(p, peer);
+        reply(FRAME_ERR, "ERR_USER_NOT_FOUND");
+        phase = CLOSING;
+    } else {
+        reply(FRAME_SALT, SALT);
+        phase = HASH;
+    }
+}
+
+/**
+ * @brief Обработка хеша пароля
+ * @param[in] data Сообщение клиента
+ * @param[in] len Длина сообщения
+ * @details В пакетном режиме сеанс переходит в фазу VERIFY и не принимает
+ *          данных до вызова verify()
+ */
+void Session::onHash(const char* data, size_t len)
+{
+    clientHash.assign(data, strnlen(data, len));
+    hashAt = metricsClock();
+    if (batched) {
+        phase = VERIFY;
+        return;
+    }
+    AuthCheck check{SALT, password, clientHash};
+    verifyBatch(&check, 1);
+    onVerified(check.verified);
+}
+
+/**
+ * @brief Завершение аутентификации по результату проверки хеша
+ * @param[in] verified true если хеш совпал
+ */
+void Session::onVerified(bool verified)
+{
+    metricLatency(HIST_AUTH, authTicks + metricsClock() - hashAt);
+    if (verified) {
+        metricAdd(MET_AUTH_OK);
+        grantTicket();
+        reply(FRAME_OK, "OK");
+        phase = DATA;
+    } else {
+        metricAdd(MET_AUTH_FAIL);
+        logError(p->logFile, "Ошибка аутентификации: неверный хеш для пользователя " + login);
+        loginFailed(p, peer);
+        reply(FRAME_ERR, "ERR");
+        phase = CLOSING;
+    }
+}
+
+/**
+ * @brief Пакетная проверка хешей сеансов в фазе VERIFY
+ * @param[in] sessions Сеансы, ожидающие проверки
+ */
+void Session::verify(const std::vector<Session*>& sessions)
+{
+    thread_local std::vector<AuthCheck> checks;
+    checks.clear();
+    for (const Session* s : sessions) {
+        checks.push_back(AuthCheck{SALT, s->password, s->clientHash});
+    }
+    verifyBatch(checks.data(), checks.size());
+    for (size_t i = 0; i < sessions.size(); i++) {
+        sessions[i]->onVerified(checks[i].verified);
+    }
+}
+
+/**
+ * @brief Выдача билета возобновления аутентифицированному клиенту
+ * @details Билет выдаётся только клиенту протокола версии 2 и только если
+ *          выдача билетов включена
+ */
+void Session::grantTicket()
+{
+    TicketStore* tickets = ticketStore();
+    if (framed && tickets != nullptr) {
+        reply(FRAME_TICKET, tickets->issue(login, users->generation(), monotonicMs()));
+    }
+}
+
+/**
+ * @brief Обработка билета возобновления
+ * @param[in] data Билет
+ * @param[in] len Длина билета
+ * @details Погашенный билет заменяется новым, поэтому клиент может
+ *          возобновлять сеансы, пока подключается чаще срока действия.
+ *          Отклонённый билет не считается неудачным входом: билеты
+ *          прежнего процесса сервера после перезапуска недействительны.
+ */
+void Session::onResume(const char* data, size_t len)
+{
+    TicketStore* tickets = ticketStore();
+    if (tickets != nullptr && tickets->redeem(std::string_view(data, len), users->generation(), monotonicMs(), login)) {
+        metricAdd(MET_RESUMED);
+        grantTicket();
+        reply(FRAME_OK, "OK");
+        phase = DATA;
+    } else {
+        metricAdd(MET_RESUME_REJECTED);
+        logError(p->logFile, "Ошибка аутентификации: билет возобновления отклонён");
+        reply(FRAME_ERR, "ERR_TICKET");
+        phase = CLOSING;
+    }
+}
+
+/**
+ * @brief Передача потока векторов декодеру
+ * @param[in] data Данные
+ * @param[in] len Длина данных
+ * @param[out] dst Буфер результатов
+ * @return Количество потреблённых байт
+ */
+size_t Session::decode(const char* data, size_t len, std::string& dst)
+{
+    size_t pos = 0;
+    while (!decoder.done()) {
+        size_t used = decoder.feed(data + pos, len - pos, dst);
+        if (used == 0) {
+            break;
+        }
+        pos += used;
+    }
+    if (decoder.failed()) {
+        fail(decoder.error());
+    } else if (decoder.done()) {
+        phase = CLOSING;
+    }
+    return pos;
+}
+
+/**
+ * @brief Завершение сеанса из-за ошибки протокола
+ * @param[in] message Описание ошибки для журнала
+ * @details Клиент протокола версии 2 получает кадр FRAME_ERR, клиент
+ *          исходного протокола — закрытие соединения
+ */
+void Session::fail(const std::string& message)
+{
+    logError(p->logFile, "Ошибка протокола: " + message);
+    if (framed) {
+        reply(FRAME_ERR, "ERR_PROTOCOL");
+    }
+    phase = CLOSING;
+}
+
+/**
+ * @brief Обработка принятых данных
+ * @param[in] data Указатель на данные
+ * @param[in] len Длина данных в байтах
+ * @return Количество потреблённых байт
+ */
+size_t Session::onData(const char* data, size_t len)
+{
+    if (framed) {
+        return onFrames(data, len);
+    }
+    switch (phase) {
+    case LOGIN: {
+        // Логин исходного протокола не начинается с нулевого байта
+        if (len > 0 && data[0] == '\0') {
+            if (len < FRAME_MAGIC_SIZE) {
+                return 0;
+            }
+            if (memcmp(data, FRAME_MAGIC, FRAME_MAGIC_SIZE) != 0) {
+                fail("неизвестный признак протокола");
+                return len;
+            }
+            framed = true;
+            return FRAME_MAGIC_SIZE;
+        }
+        // Одно сообщение не длиннее буфера recv, до первого нулевого байта
+        size_t msg_len = len < BUFFER_SIZE - 1 ? len : BUFFER_SIZE - 1;
+        onLogin(data, msg_len);
+        return msg_len;
+    }
+    case HASH: {
+        size_t msg_len = len < BUFFER_SIZE - 1 ? len : BUFFER_SIZE - 1;
+        onHash(data, msg_len);
+        return msg_len;
+    }
+    case VERIFY:
+        return 0; // Данные векторов ждут результата проверки хеша
+    case DATA:
+        return decode(data, len, out);
+    case CLOSING:
+        break;
+    }
+    return len; // Данные после завершения сеанса игнорируются
+}
+
+/**
+ * @brief Обработка данных протокола версии 2
+ * @param[in] data Данные после признака протокола
+ * @param[in] len Длина данных
+ * @return Количество потреблённых байт
+ * @details Кадры логина и хеша обрабатываются целиком, данные векторов —
+ *          по мере поступления, не дожидаясь конца кадра
+ */
+size_t Session::onFrames(const char* data, size_t len)
+{
+    if (phase == CLOSING) {
+        return len;
+    }
+    if (phase == VERIFY) {
+        return 0;
+    }
+    if (frameLeft > 0) {
+        return onVectors(data, len);
+    }
+    if (len < sizeof(FrameHeader)) {
+        return 0;
+    }
+    FrameHeader h = readFrameHeader(data);
+    FrameType expected = phase == LOGIN ? FRAME_LOGIN : phase == HASH ? FRAME_HASH : FRAME_VECTORS;
+    // Билет прошлого сеанса заменяет логин и хеш
+    bool resume = phase == LOGIN && h.type == FRAME_RESUME;
+    if (h.type != expected && !resume) {
+        fail("неожиданный кадр " + std::to_string(h.type) + " (" + where() + ")");
+        return len;
+    }
+    if (phase == DATA) {
+        frameLeft = h.length;
+        return sizeof(FrameHeader);
+    }
+    if (h.length > FRAME_CONTROL_MAX) {
+        fail("длина кадра " + std::to_string(h.length) + " (" + where() + ")");
+        return len;
+    }
+    if (len - sizeof(FrameHeader) < h.length) {
+        return 0;
+    }
+    if (resume) {
+        onResume(data + sizeof(FrameHeader), h.length);
+    } else if (phase == LOGIN) {
+        onLogin(data + sizeof(FrameHeader), h.length);
+    } else {
+        onHash(data + sizeof(FrameHeader), h.length);
+    }
+    return sizeof(FrameHeader) + h.length;
+}
+
+/**
+ * @brief Обработка данных кадра FRAME_VECTORS
+ * @param[in] data Данные
+ * @param[in] len Длина данных
+ * @return Количество потреблённых байт
+ * @details Элемент, не поместившийся в кадр, копируется в carry и
+ *          дополняется данными следующего кадра. Результаты, полученные за
+ *          вызов, отправляются одним кадром FRAME_RESULTS.
+ */
+size_t Session::onVectors(const char* data, size_t len)
+{
+    size_t avail = len < frameLeft ? len : frameLeft;
+    size_t pos = 0;
+    if (!carry.empty()) {
+        // 16 байт вмещают наибольший элемент (пару double), поэтому декодер
+        // потребит весь сохранённый остаток, если данных достаточно
+        size_t old = carry.size();
+        size_t take = std::min(avail, 2 * sizeof(double) - old);
+        carry.append(data, take);
+        size_t used = decode(carry.data(), carry.size(), results);
+        if (used >= old) {
+            pos = used - old;
+            carry.clear();
+        } else {
+            carry.erase(0, used);
+            pos = take;
+        }
+    }
+    if (carry.empty() && phase == DATA) {
+        pos += decode(data + pos, avail - pos, results);
+        // Внутри кадра остаток дополнит следующая порция, на границе кадров — следующий кадр
+        if (avail == frameLeft && phase == DATA) {
+            carry.assign(data + pos, avail - pos);
+            pos = avail;
+        }
+    }
+    frameLeft -= pos;
+    if (!results.empty()) {
+        appendFrame(out, FRAME_RESULTS, results.data(), results.size());
+        results.clear();
+    }
+    return pos;
+}
+
+/**
+ * @brief Обработка закрытия соединения клиентом
+ */
+void Session::onClose()
+{
+    if (phase == DATA) {
+        logError(p->logFile, "Ошибка recv (" + decoder.where() + "): соединение закрыто клиентом");
+    }
+}
+
+/**
+ * @brief Ожидаемая от клиента часть обмена
+ * @return Стадия для отсчёта тайм-аутов
+ */
+Stage Session::stage() const
+{
+    switch (phase) {
+    case LOGIN:
+        return STAGE_LOGIN;
+    case HASH:
+    case VERIFY:
+        return STAGE_HASH;
+    case DATA:
+        return decoder.state() == VectorDecoder::ELEMENTS ? STAGE_ELEMENTS : STAGE_HEADER;
+    default:
+        return STAGE_DONE;
+    }
+}
+
+/**
+ * @brief Описание ожидаемых данных для сообщений об ошибках
+ * @return Строка вида "логин" или "элемент 5 вектора 3"
+ */
+std::string Session::where() const
+{
+    switch (phase) {
+    case LOGIN:
+        return "логин";
+    case HASH:
+    case VERIFY:
+        return "хеш";
+    case DATA:
+        return decoder.where();
+    default:
+        return "отправка ответа";
+    }
+}
@@ -0,0 +1,215 @@
+/**
+ * @file session.h
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл сеанса клиента
+ * @details Содержит автомат состояний протокола (логин → соль → хеш →
+ *          векторы → результаты), не выполняющий ввода-вывода сам.
+ *          Используется событийными режимами сервера и, для протокола
+ *          версии 2, режимом рабочих потоков.
+ */
+
+#pragma once
+#include "authbatch.h"
+#include "decoder.h"
+#include "frame.h"
+#include "interface.h"
+#include "timeout.h"
+#include "userbase.h"
+#include <string>
+#include <vector>
+
+/**
+ * @class Session
+ * @brief Сеанс обмена с одним клиентом
+ * @details Получает принятые из сокета данные через onData() и накапливает
+ *          ответ клиенту в буфере out. Вызывающая сторона отправляет out
+ *          и закрывает соединение, когда finished() и буфер опустошён.
+ *
+ *          Поток, начинающийся с FRAME_MAGIC, разбирается как протокол
+ *          версии 2: сообщения ожидаются целыми кадрами, а данные кадров
+ *          FRAME_VECTORS передаются декодеру как единый поток. Неполный
+ *          элемент на границе кадров сохраняется в сеансе. Клиент,
+ *          предъявивший вместо логина действующий билет возобновления,
+ *          сразу переходит к приёму векторов.
+ */
+class Session
+{
+public:
+    /// Фаза протокола
+    enum Phase {
+        LOGIN,      ///< Ожидается логин
+        HASH,       ///< Ожидается хеш пароля
+        VERIFY,     ///< Хеш принят и ожидает пакетной проверки
+        DATA,       ///< Приём векторов
+        CLOSING     ///< Сеанс завершён, осталось отправить ответ
+    };
+
+    std::string out;             ///< Данные для отправки клиенту
+
+private:
+    const Params* p;             ///< Параметры сервера
+    const UserRegistry* users;       ///< Реестр базы пользователей
+    Phase phase = LOGIN;         ///< Текущая фаза
+    std::string login;           ///< Логин клиента
+    std::string password;        ///< Пароль пользователя из базы
+    VectorDecoder decoder;       ///< Декодер потока векторов
+    uint64_t authTicks = 0;      ///< Длительность поиска пользователя, такты metricsClock
+    uint64_t hashAt = 0;         ///< Отметка metricsClock получения хеша
+    std::string clientHash;      ///< Хеш пароля, присланный клиентом
+    bool batched;                ///< Проверка хеша откладывается до verify()
+    uint32_t peer;               ///< Адрес клиента IPv4 для учёта неудачных входов
+    bool framed = false;         ///< Клиент использует протокол версии 2
+    uint32_t frameLeft = 0;      ///< Непринятая часть текущего кадра FRAME_VECTORS
+    std::string carry;           ///< Неполный элемент с конца прошлого кадра (не более 15 байт)
+    std::string results;         ///< Результаты векторов для кадра FRAME_RESULTS
+
+    /**
+     * @brief Отправка сообщения клиенту
+     * @param[in] type Тип кадра протокола версии 2
+     * @param[in] text Сообщение; в исходном протоколе передаётся без кадра
+     */
+    void reply(FrameType type, const std::string& text);
+
+    /**
+     * @brief Обработка логина
+     * @param[in] data Сообщение клиента
+     * @param[in] len Длина сообщения
+     */
+    void onLogin(const char* data, size_t len);
+
+    /**
+     * @brief Обработка хеша пароля
+     * @param[in] data Сообщение клиента
+     * @param[in] len Длина сообщения
+     */
+    void onHash(const char* data, size_t len);
+
+    /**
+     * @brief Завершение аутентификации по результату проверки хеша
+     * @param[in] verified true если хеш совпал
+     */
+    void onVerified(bool verified);
+
+    /**
+     * @brief Выдача билета возобновления аутентифицированному клиенту
+     */
+    void grantTicket();
+
+    /**
+     * @brief Обработка билета возобновления
+     * @param[in] data Билет
+     * @param[in] len Длина билета
+     */
+    void onResume(const char* data, size_t len);
+
+    /**
+     * @brief Передача потока векторов декодеру
+     * @param[in] data Данные
+     * @param[in] len Длина данных
+     * @param[out] dst Буфер результатов
+     * @return Количество потреблённых байт
+     */
+    size_t decode(const char* data, size_t len, std::string& dst);
+
+    /**
+     * @brief Обработка данных протокола версии 2
+     * @param[in] data Данные после признака протокола
+     * @param[in] len Длина данных
+     * @return Количество потреблённых байт
+     */
+    size_t onFrames(const char* data, size_t len);
+
+    /**
+     * @brief Обработка данных кадра FRAME_VECTORS
+     * @param[in] data Данные
+     * @param[in] len Длина данных
+     * @return Количество потреблённых байт
+     */
+    size_t onVectors(const char* data, size_t len);
+
+    /**
+     * @brief Завершение сеанса из-за ошибки протокола
+     * @param[in] message Описание ошибки для журнала
+     */
+    void fail(const std::string& message);
+
+public:
+    /**
+     * @brief Конструктор сеанса
+     * @param[in] p Параметры сервера
+     * @param[in] users Реестр базы пользователей
+     * @param[in] batched true если вызывающая сторона проверяет хеши
+     *                    пакетами через verify(); иначе хеш проверяется сразу
+     * @param[in] peer Адрес клиента IPv4 для учёта неудачных входов
+     */
+    Session(const Params* p, const UserRegistry* users, bool batched = false, uint32_t peer = 0)
+        : p(p), users(users), batched(batched), peer(peer) {}
+
+    /**
+     * @brief Пакетная проверка хешей сеансов в фазе VERIFY
+     * @param[in] sessions Сеансы, ожидающие проверки
+     * @details Хеши вычисляются одним вызовом verifyBatch(); каждый сеанс
+     *          получает ответ на аутентификацию в out и продолжает разбор
+     *          с очередного onData()
+     */
+    static void verify(const std::vector<Session*>& sessions);
+
+    /**
+     * @brief Обработка принятых данных
+     * @param[in] data Указатель на данные
+     * @param[in] len Длина данных в байтах
+     * @return Количество потреблённых байт; остаток передаётся повторно
+     *         вместе со следующей порцией
+     * @details В исходном протоколе порция данных в фазах LOGIN и HASH
+     *          считается одним сообщением клиента, как при чтении одним
+     *          вызовом recv. В протоколе версии 2 сообщение ожидается до
+     *          получения всего кадра (возвращается 0).
+     */
+    size_t onData(const char* data, size_t len);
+
+    /**
+     * @brief Обработка закрытия соединения клиентом
+     * @details Записывает в журнал ошибку, если клиент отключился
+     *          до завершения обмена
+     */
+    void onClose();
+
+    /**
+     * @brief Текущая фаза протокола
+     * @return Фаза
+     */
+    Phase state() const {
+        return phase;
+    }
+
+    /**
+     * @brief Ожидаемая от клиента часть обмена
+     * @return Стадия для отсчёта тайм-аутов
+     */
+    Stage stage() const;
+
+    /**
+     * @brief Номер текущего вектора
+     * @return Номер вектора, ожидаемого декодером
+     */
+    uint32_t vector() const {
+        return decoder.current();
+    }
+
+    /**
+     * @brief Описание ожидаемых данных для сообщений об ошибках
+     * @return Строка вида "логин" или "элемент 5 вектора 3"
+     */
+    std::string where() const;
+
+    /**
+     * @brief Признак завершения сеанса
+     * @return true если после отправки out соединение следует закрыть
+     */
+    bool finished() const {
+        return phase == CLOSING;
+    }
+};
@@ -0,0 +1,310 @@
+/**
+ * @file simd.cpp
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация векторизованных вычислительных ядер
+ * @details Варианты ядер компилируются с атрибутом target, поэтому сборка
+ *          не требует флагов -mavx2/-mavx512f, а выбор варианта выполняется
+ *          один раз при первом вызове. Все вычисления ведутся в беззнаковой
+ *          арифметике, что даёт переполнение по модулю 2^32, как у
+ *          исходного цикла с int32_t.
+ *
+ *          Точные ядра делят каждый 64-битный квадрат (не более 2^62) на
+ *          младшие и старшие 32 бита и суммируют их в отдельных 64-битных
+ *          накопителях: при размере вектора до 2^32 ни один из них не
+ *          переполняется, а итог собирается в 128-битное число один раз.
+ */
+
+#include "simd.h"
+#include <immintrin.h>
+
+/**
+ * @brief Определение лучшего набора инструкций, поддерживаемого процессором
+ * @return Максимальный доступный уровень SimdLevel
+ * @details __builtin_cpu_supports опрашивает CPUID и учитывает поддержку
+ *          расширенных регистров операционной системой
+ */
+SimdLevel detectSimdLevel()
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return SIMD_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return SIMD_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return SIMD_SSE2;
+    }
+    return SIMD_SCALAR;
+}
+
+/**
+ * @brief Скалярная сумма квадратов
+ * @param[in] data Массив элементов
+ * @param[in] n Количество элементов
+ * @return Сумма квадратов по модулю 2^32
+ */
+int32_t sumSquaresScalar(const int32_t* data, size_t n)
+{
+    uint32_t result = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t element = static_cast<uint32_t>(data[i]);
+        result += element * element;
+    }
+    return static_cast<int32_t>(result);
+}
+
+/**
+ * @brief Сумма квадратов на SSE2
+ * @details В SSE2 нет умножения 32-битных слов с младшей половиной
+ *          результата, поэтому чётные и нечётные элементы умножаются
+ *          _mm_mul_epu32. Младшие 32 бита произведения лежат в словах 0 и 2,
+ *          мусор в словах 1 и 3 отбрасывается при итоговом сложении.
+ */
+__attribute__((target("sse2")))
+static int32_t sumSquaresSse2(const int32_t* data, size_t n)
+{
+    __m128i acc0 = _mm_setzero_si128();
+    __m128i acc1 = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i odd = _mm_srli_epi64(x, 32);
+        acc0 = _mm_add_epi32(acc0, _mm_mul_epu32(x, x));
+        acc1 = _mm_add_epi32(acc1, _mm_mul_epu32(odd, odd));
+    }
+    __m128i acc = _mm_add_epi32(acc0, acc1);
+    uint32_t result = static_cast<uint32_t>(_mm_cvtsi128_si32(acc)) +
+                      static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(acc, 8)));
+    return static_cast<int32_t>(result + static_cast<uint32_t>(sumSquaresScalar(data + i, n - i)));
+}
+
+/**
+ * @brief Сумма квадратов на AVX2
+ * @details Два независимых аккумулятора скрывают задержку умножения
+ */
+__attribute__((target("avx2")))
+static int32_t sumSquaresAvx2(const int32_t* data, size_t n)
+{
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i x0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i x1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 8));
+        acc0 = _mm256_add_epi32(acc0, _mm256_mullo_epi32(x0, x0));
+        acc1 = _mm256_add_epi32(acc1, _mm256_mullo_epi32(x1, x1));
+    }
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        acc0 = _mm256_add_epi32(acc0, _mm256_mullo_epi32(x, x));
+    }
+    __m256i acc = _mm256_add_epi32(acc0, acc1);
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    uint32_t result = static_cast<uint32_t>(_mm_cvtsi128_si32(sum));
+    return static_cast<int32_t>(result + static_cast<uint32_t>(sumSquaresScalar(data + i, n - i)));
+}
+
+/**
+ * @brief Сумма квадратов на AVX-512
+ * @details Хвост массива обрабатывается маскированной загрузкой
+ */
+__attribute__((target("avx512f")))
+static int32_t sumSquaresAvx512(const int32_t* data, size_t n)
+{
+    __m512i acc0 = _mm512_setzero_si512();
+    __m512i acc1 = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m512i x0 = _mm512_loadu_si512(data + i);
+        __m512i x1 = _mm512_loadu_si512(data + i + 16);
+        acc0 = _mm512_add_epi32(acc0, _mm512_mullo_epi32(x0, x0));
+        acc1 = _mm512_add_epi32(acc1, _mm512_mullo_epi32(x1, x1));
+    }
+    for (; i < n; i += 16) {
+        size_t rest = n - i;
+        __mmask16 mask = rest >= 16 ? 0xFFFF : static_cast<__mmask16>((1u << rest) - 1);
+        __m512i x = _mm512_maskz_loadu_epi32(mask, data + i);
+        acc0 = _mm512_add_epi32(acc0, _mm512_mullo_epi32(x, x));
+    }
+    return _mm512_reduce_add_epi32(_mm512_add_epi32(acc0, acc1));
+}
+
+/**
+ * @brief Сумма квадратов с явно заданным набором инструкций
+ * @param[in] level Набор инструкций
+ * @param[in] data Массив элементов
+ * @param[in] n Количество элементов
+ * @return Сумма квадратов по модулю 2^32
+ */
+int32_t sumSquaresAt(SimdLevel level, const int32_t* data, size_t n)
+{
+    switch (level) {
+    case SIMD_AVX512:
+        return sumSquaresAvx512(data, n);
+    case SIMD_AVX2:
+        return sumSquaresAvx2(data, n);
+    case SIMD_SSE2:
+        return sumSquaresSse2(data, n);
+    default:
+        return sumSquaresScalar(data, n);
+    }
+}
+
+/**
+ * @brief Сумма квадратов с автоматическим выбором набора инструкций
+ * @param[in] data Массив элементов
+ * @param[in] n Количество элементов
+ * @return Сумма квадратов по модулю 2^32
+ */
+int32_t sumSquares(const int32_t* data, size_t n)
+{
+    static const SimdLevel level = detectSimdLevel();
+    return sumSquaresAt(level, data, n);
+}
+
+/**
+ * @brief Точная скалярная сумма квадратов
+ * @param[in] data Массив элементов
+ * @param[in] n Количество элементов
+ * @return Сумма квадратов без переполнения
+ */
+unsigned __int128 sumSquaresWideScalar(const int32_t* data, size_t n)
+{
+    unsigned __int128 result = 0;
+    for (size_t i = 0; i < n; i++) {
+        int64_t element = data[i];
+        result += static_cast<uint64_t>(element * element);
+    }
+    return result;
+}
+
+/**
+ * @brief Сборка результата из сумм младших и старших половин квадратов
+ * @param[in] lo Сумма младших 32 бит квадратов
+ * @param[in] hi Сумма старших 32 бит квадратов
+ * @return hi * 2^32 + lo
+ */
+static inline unsigned __int128 joinHalves(uint64_t lo, uint64_t hi)
+{
+    return (static_cast<unsigned __int128>(hi) << 32) + lo;
+}
+
+/**
+ * @brief Точная сумма квадратов на SSE2
+ * @details Модуль элемента вычисляется как (x ^ s) - s, где s — знак,
+ *          после чего _mm_mul_epu32 даёт точные 64-битные квадраты чётных
+ *          и нечётных элементов
+ */
+__attribute__((target("sse2")))
+static unsigned __int128 sumSquaresWideSse2(const int32_t* data, size_t n)
+{
+    const __m128i low = _mm_set1_epi64x(0xFFFFFFFF);
+    __m128i lo = _mm_setzero_si128();
+    __m128i hi = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i sign = _mm_srai_epi32(x, 31);
+        x = _mm_sub_epi32(_mm_xor_si128(x, sign), sign);
+        __m128i even = _mm_mul_epu32(x, x);
+        __m128i odd = _mm_srli_epi64(x, 32);
+        odd = _mm_mul_epu32(odd, odd);
+        lo = _mm_add_epi64(lo, _mm_add_epi64(_mm_and_si128(even, low), _mm_and_si128(odd, low)));
+        hi = _mm_add_epi64(hi, _mm_add_epi64(_mm_srli_epi64(even, 32), _mm_srli_epi64(odd, 32)));
+    }
+    alignas(16) uint64_t l[2], h[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(l), lo);
+    _mm_store_si128(reinterpret_cast<__m128i*>(h), hi);
+    return joinHalves(l[0], h[0]) + joinHalves(l[1], h[1]) + sumSquaresWideScalar(data + i, n - i);
+}
+
+/**
+ * @brief Точная сумма квадратов на AVX2
+ * @details _mm256_mul_epi32 умножает знаковые чётные слова, нечётные
+ *          сдвигаются на их место; квадрат неотрицателен и помещается в
+ *          64 бита
+ */
+__attribute__((target("avx2")))
+static unsigned __int128 sumSquaresWideAvx2(const int32_t* data, size_t n)
+{
+    const __m256i low = _mm256_set1_epi64x(0xFFFFFFFF);
+    __m256i lo = _mm256_setzero_si256();
+    __m256i hi = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i even = _mm256_mul_epi32(x, x);
+        __m256i odd = _mm256_srli_epi64(x, 32);
+        odd = _mm256_mul_epi32(odd, odd);
+        lo = _mm256_add_epi64(lo, _mm256_add_epi64(_mm256_and_si256(even, low), _mm256_and_si256(odd, low)));
+        hi = _mm256_add_epi64(hi, _mm256_add_epi64(_mm256_srli_epi64(even, 32), _mm256_srli_epi64(odd, 32)));
+    }
+    alignas(32) uint64_t l[4], h[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(l), lo);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(h), hi);
+    return joinHalves(l[0] + l[1] + l[2] + l[3], h[0] + h[1] + h[2] + h[3]) +
+           sumSquaresWideScalar(data + i, n - i);
+}
+
+/**
+ * @brief Точная сумма квадратов на AVX-512F
+ * @details Хвост загружается по маске с обнулением, как в ядре по
+ *          модулю 2^32
+ */
+__attribute__((target("avx512f")))
+static unsigned __int128 sumSquaresWideAvx512(const int32_t* data, size_t n)
+{
+    const __m512i low = _mm512_set1_epi64(0xFFFFFFFF);
+    __m512i lo = _mm512_setzero_si512();
+    __m512i hi = _mm512_setzero_si512();
+    for (size_t i = 0; i < n; i += 16) {
+        size_t rest = n - i;
+        __mmask16 mask = rest >= 16 ? 0xFFFF : static_cast<__mmask16>((1u << rest) - 1);
+        __m512i x = _mm512_maskz_loadu_epi32(mask, data + i);
+        __m512i even = _mm512_mul_epi32(x, x);
+        __m512i odd = _mm512_srli_epi64(x, 32);
+        odd = _mm512_mul_epi32(odd, odd);
+        lo = _mm512_add_epi64(lo, _mm512_add_epi64(_mm512_and_si512(even, low), _mm512_and_si512(odd, low)));
+        hi = _mm512_add_epi64(hi, _mm512_add_epi64(_mm512_srli_epi64(even, 32), _mm512_srli_epi64(odd, 32)));
+    }
+    return joinHalves(_mm512_reduce_add_epi64(lo), _mm512_reduce_add_epi64(hi));
+}
+
+/**
+ * @brief Точная сумма квадратов с явно заданным набором инструкций
+ * @param[in] level Набор инструкций
+ * @param[in] data Массив элементов
+ * @param[in] n Количество элементов
+ * @return Сумма квадратов без переполнения
+ */
+unsigned __int128 sumSquaresWideAt(SimdLevel level, const int32_t* data, size_t n)
+{
+    switch (level) {
+    case SIMD_AVX512:
+        return sumSquaresWideAvx512(data, n);
+    case SIMD_AVX2:
+        return sumSquaresWideAvx2(data, n);
+    case SIMD_SSE2:
+        return sumSquaresWideSse2(data, n);
+    default:
+        return sumSquaresWideScalar(data, n);
+    }
+}
+
+/**
+ * @brief Точная сумма квадратов с автоматическим выбором набора инструкций
+ * @param[in] data Массив элементов
+ * @param[in] n Количество элементов
+ * @return Сумма квадратов без переполнения
+ */
+unsigned __int128 sumSquaresWide(const int32_t* data, size_t n)
+{
+    static const SimdLevel level = detectSimdLevel();
+    return sumSquaresWideAt(level, data, n);
+}
@@ -0,0 +1,81 @@
+/**
+ * @file simd.h
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл векторизованных вычислительных ядер
+ * @details Содержит ядра суммы квадратов для массивов int32_t по модулю 2^32
+ *          и точной 128-битной с вариантами SSE2, AVX2, AVX-512 и скалярным,
+ *          выбираемыми во время выполнения по результатам CPUID
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Набор инструкций, используемый вычислительными ядрами
+ */
+enum SimdLevel {
+    SIMD_SCALAR = 0,    ///< Скалярный код без векторных инструкций
+    SIMD_SSE2 = 1,      ///< SSE2 (128 бит)
+    SIMD_AVX2 = 2,      ///< AVX2 (256 бит)
+    SIMD_AVX512 = 3     ///< AVX-512F (512 бит)
+};
+
+/**
+ * @brief Определение лучшего набора инструкций, поддерживаемого процессором
+ * @return Максимальный доступный уровень SimdLevel
+ */
+SimdLevel detectSimdLevel();
+
+/**
+ * @brief Скалярная сумма квадратов
+ * @param[in] data Массив элементов
+ * @param[in] n Количество элементов
+ * @return Сумма квадратов по модулю 2^32 (переполнение как у int32_t)
+ */
+int32_t sumSquaresScalar(const int32_t* data, size_t n);
+
+/**
+ * @brief Сумма квадратов с явно заданным набором инструкций
+ * @param[in] level Набор инструкций (должен поддерживаться процессором)
+ * @param[in] data Массив элементов
+ * @param[in] n Количество элементов
+ * @return Сумма квадратов по модулю 2^32
+ */
+int32_t sumSquaresAt(SimdLevel level, const int32_t* data, size_t n);
+
+/**
+ * @brief Сумма квадратов с автоматическим выбором набора инструкций
+ * @param[in] data Массив элементов (выравнивание по 4 байтам)
+ * @param[in] n Количество элементов
+ * @return Сумма квадратов по модулю 2^32, совпадающая со скалярным вариантом
+ */
+int32_t sumSquares(const int32_t* data, size_t n);
+
+/**
+ * @brief Точная скалярная сумма квадратов
+ * @param[in] data Массив элементов
+ * @param[in] n Количество элементов
+ * @return Сумма квадратов без переполнения (не превосходит 2^94)
+ */
+unsigned __int128 sumSquaresWideScalar(const int32_t* data, size_t n);
+
+/**
+ * @brief Точная сумма квадратов с явно заданным набором инструкций
+ * @param[in] level Набор инструкций (должен поддерживаться процессором)
+ * @param[in] data Массив элементов
+ * @param[in] n Количество элементов (не более 2^32)
+ * @return Сумма квадратов без переполнения
+ */
+unsigned __int128 sumSquaresWideAt(SimdLevel level, const int32_t* data, size_t n);
+
+/**
+ * @brief Точная сумма квадратов с автоматическим выбором набора инструкций
+ * @param[in] data Массив элементов (выравнивание по 4 байтам)
+ * @param[in] n Количество элементов (не более 2^32)
+ * @return Сумма квадратов без переполнения
+ */
+unsigned __int128 sumSquaresWide(const int32_t* data, size_t n);
@@ -0,0 +1,205 @@
+/**
+ * @file threadpool.cpp
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация пула рабочих потоков
+ */
+
+#include "threadpool.h"
+
+/**
+ * @brief Конструктор пула
+ * @param[in] threads Количество потоков (0 — по числу ядер процессора)
+ */
+ThreadPool::ThreadPool(size_t threads)
+{
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    if (threads == 0) {
+        threads = 1; // Число ядер не удалось определить
+    }
+    for (size_t i = 0; i < threads; i++) {
+        workers.emplace_back(&ThreadPool::worker, this);
+    }
+}
+
+/**
+ * @brief Деструктор пула
+ * @details Выставляет признак остановки и дожидается завершения потоков
+ */
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    cv.notify_all();
+    for (auto& t : workers) {
+        t.join();
+    }
+}
+
+/**
+ * @brief Постановка задачи в очередь
+ * @param[in] task Задача для выполнения
+ */
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        tasks.push(std::move(task));
+    }
+    cv.notify_one();
+}
+
+/**
+ * @brief Цикл рабочего потока
+ * @details Извлекает задачи из очереди до остановки пула и опустошения очереди
+ */
+void ThreadPool::worker()
+{
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+        task();
+    }
+}
+
+/// Пул и номер очереди текущего рабочего потока пула перехвата задач
+static thread_local const WorkStealingPool* currentPool = nullptr;
+static thread_local size_t currentQueue = 0;
+
+/**
+ * @brief Конструктор пула
+ * @param[in] threads Количество потоков (0 — по числу ядер процессора)
+ */
+WorkStealingPool::WorkStealingPool(size_t threads)
+{
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    if (threads == 0) {
+        threads = 1; // Число ядер не удалось определить
+    }
+    for (size_t i = 0; i < threads; i++) {
+        queues.emplace_back(new Queue);
+    }
+    for (size_t i = 0; i < threads; i++) {
+        workers.emplace_back(&WorkStealingPool::worker, this, i);
+    }
+}
+
+/**
+ * @brief Деструктор пула
+ * @details Выставляет признак остановки и дожидается завершения потоков
+ */
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(idleMtx);
+        stopping = true;
+    }
+    idle.notify_all();
+    for (auto& t : workers) {
+        t.join();
+    }
+}
+
+/**
+ * @brief Постановка задачи
+ * @param[in] task Задача для выполнения
+ */
+void WorkStealingPool::submit(std::function<void()> task)
+{
+    size_t target = currentPool == this ? currentQueue : next.fetch_add(1) % queues.size();
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->mtx);
+        queued.fetch_add(1);
+        queues[target]->tasks.push_back(std::move(task));
+    }
+    // Захват мьютекса исключает потерю уведомления между проверкой и ожиданием
+    {
+        std::lock_guard<std::mutex> lock(idleMtx);
+    }
+    idle.notify_one();
+}
+
+/**
+ * @brief Извлечение задачи: своя очередь с конца, чужие — с начала
+ * @param[in] self Номер очереди вызывающего потока
+ * @param[out] task Извлечённая задача
+ * @return false если все очереди пусты
+ */
+bool WorkStealingPool::take(size_t self, std::function<void()>& task)
+{
+    if (queued.load() == 0) {
+        return false;
+    }
+    for (size_t i = 0; i < queues.size(); i++) {
+        Queue& q = *queues[(self + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(q.mtx);
+        if (q.tasks.empty()) {
+            continue;
+        }
+        if (i == 0) {
+            task = std::move(q.tasks.back());
+            q.tasks.pop_back();
+        } else {
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+        }
+        queued.fetch_sub(1);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Выполнение одной задачи вызывающим потоком
+ * @return false если задач нет
+ */
+bool WorkStealingPool::runOne()
+{
+    std::function<void()> task;
+    if (!take(currentPool == this ? currentQueue : next.load() % queues.size(), task)) {
+        return false;
+    }
+    task();
+    return true;
+}
+
+/**
+ * @brief Цикл рабочего потока
+ * @param[in] self Номер очереди потока
+ * @details Выполняет задачи своей и чужих очередей, при их отсутствии
+ *          ждёт уведомления; завершается после остановки пула и
+ *          опустошения очередей
+ */
+void WorkStealingPool::worker(size_t self)
+{
+    currentPool = this;
+    currentQueue = self;
+    while (true) {
+        std::function<void()> task;
+        if (take(self, task)) {
+            task();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(idleMtx);
+        idle.wait(lock, [this] { return stopping || queued.load() > 0; });
+        if (stopping && queued.load() == 0) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,154 @@
+/**
+ * @file threadpool.h
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл пула рабочих потоков
+ * @details Содержит объявления пула потоков фиксированного размера,
+ *          выполняющего задачи из общей очереди, и пула с очередью у каждого
+ *          потока и перехватом задач (work stealing) для вычислений
+ */
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/**
+ * @class ThreadPool
+ * @brief Пул рабочих потоков фиксированного размера
+ * @details Задачи помещаются в общую очередь и выполняются первым
+ *          освободившимся потоком. При разрушении пул дожидается
+ *          завершения всех поставленных задач.
+ */
+class ThreadPool
+{
+private:
+    std::vector<std::thread> workers;          ///< Рабочие потоки
+    std::queue<std::function<void()>> tasks;   ///< Очередь задач
+    std::mutex mtx;                            ///< Мьютекс очереди задач
+    std::condition_variable cv;                ///< Уведомление о новых задачах
+    bool stopping = false;                     ///< Признак остановки пула
+
+    /**
+     * @brief Цикл рабочего потока
+     */
+    void worker();
+
+public:
+    /**
+     * @brief Конструктор пула
+     * @param[in] threads Количество потоков (0 — по числу ядер процессора)
+     */
+    explicit ThreadPool(size_t threads);
+
+    /**
+     * @brief Деструктор пула
+     * @details Выполняет оставшиеся задачи и завершает рабочие потоки
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Постановка задачи в очередь
+     * @param[in] task Задача для выполнения
+     */
+    void submit(std::function<void()> task);
+
+    /**
+     * @brief Количество рабочих потоков
+     * @return Размер пула
+     */
+    size_t size() const {
+        return workers.size();
+    }
+};
+
+/**
+ * @class WorkStealingPool
+ * @brief Пул вычислительных потоков с перехватом задач
+ * @details У каждого потока своя очередь: поток берёт задачи с её конца,
+ *          а освободившиеся потоки перехватывают задачи с начала чужих
+ *          очередей. Задачи извне распределяются по очередям по кругу.
+ *          Ожидающий результатов поток может выполнять задачи сам
+ *          (runOne), поэтому ожидание не простаивает и не приводит к
+ *          взаимной блокировке при занятых рабочих потоках.
+ */
+class WorkStealingPool
+{
+private:
+    /// Очередь задач одного потока
+    struct Queue {
+        std::mutex mtx;                             ///< Мьютекс очереди
+        std::deque<std::function<void()>> tasks;    ///< Задачи
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;    ///< Очереди потоков
+    std::vector<std::thread> workers;              ///< Рабочие потоки
+    std::atomic<size_t> queued{0};                 ///< Число задач во всех очередях
+    std::atomic<size_t> next{0};                   ///< Очередь для следующей внешней задачи
+    std::mutex idleMtx;                            ///< Мьютекс ожидания задач
+    std::condition_variable idle;                  ///< Уведомление о новых задачах
+    bool stopping = false;                         ///< Признак остановки пула
+
+    /**
+     * @brief Извлечение задачи: своя очередь с конца, чужие — с начала
+     * @param[in] self Номер очереди вызывающего потока
+     * @param[out] task Извлечённая задача
+     * @return false если все очереди пусты
+     */
+    bool take(size_t self, std::function<void()>& task);
+
+    /**
+     * @brief Цикл рабочего потока
+     * @param[in] self Номер очереди потока
+     */
+    void worker(size_t self);
+
+public:
+    /**
+     * @brief Конструктор пула
+     * @param[in] threads Количество потоков (0 — по числу ядер процессора)
+     */
+    explicit WorkStealingPool(size_t threads);
+
+    /**
+     * @brief Деструктор пула
+     * @details Выполняет оставшиеся задачи и завершает рабочие потоки
+     */
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /**
+     * @brief Постановка задачи
+     * @param[in] task Задача для выполнения
+     * @details Рабочий поток ставит задачу в свою очередь, остальные —
+     *          в очереди потоков по кругу
+     */
+    void submit(std::function<void()> task);
+
+    /**
+     * @brief Выполнение одной задачи вызывающим потоком
+     * @return false если задач нет
+     */
+    bool runOne();
+
+    /**
+     * @brief Количество рабочих потоков
+     * @return Размер пула
+     */
+    size_t size() const {
+        return workers.size();
+    }
+};
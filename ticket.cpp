@@ -0,0 +1,153 @@
+/**
+ * @file ticket.cpp
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация билетов возобновления сеанса
+ */
+
+#include "ticket.h"
+#include "crypto.h"
+#include <cryptopp/hmac.h>
+#include <cstring>
+
+/// Действующий кеш билетов; заменяется только до начала обслуживания клиентов
+static std::unique_ptr<TicketStore> store;
+
+/**
+ * @brief Конструктор кеша
+ * @param[in] ttl Срок действия билета, мс
+ * @param[in] capacity Наибольшее число действующих билетов
+ * @details Ключ и начальный номер выбираются случайно: билеты прошлого
+ *          запуска сервера не проходят проверку
+ */
+TicketStore::TicketStore(uint64_t ttl, size_t capacity)
+    : ttl(ttl), capacity(capacity / TICKET_SHARDS > 0 ? capacity / TICKET_SHARDS : 1)
+{
+    CPP::AutoSeededRandomPool rng;
+    rng.GenerateBlock(reinterpret_cast<CPP::byte*>(key), sizeof(key));
+    uint64_t first;
+    rng.GenerateBlock(reinterpret_cast<CPP::byte*>(&first), sizeof(first));
+    nextId.store(first);
+}
+
+/**
+ * @brief Вычисление кода подлинности
+ * @param[in] ticket Номер и срок действия (2 * sizeof(uint64_t) байт)
+ * @param[out] mac Буфер TICKET_MAC_SIZE байт
+ */
+void TicketStore::sign(const char* ticket, char* mac) const
+{
+    CPP::HMAC<CPP::SHA256> hmac(reinterpret_cast<const CPP::byte*>(key), sizeof(key));
+    hmac.CalculateDigest(reinterpret_cast<CPP::byte*>(mac), reinterpret_cast<const CPP::byte*>(ticket), 2 * sizeof(uint64_t));
+}
+
+/**
+ * @brief Удаление истёкших и вытесняемых билетов из начала очереди шарда
+ * @param[in,out] s Шард, мьютекс которого захвачен
+ * @param[in] now Текущее время, мс
+ * @param[in] limit Допустимое число билетов в шарде
+ * @details В очереди остаются и записи уже погашенных билетов; их число
+ *          ограничено удвоенной ёмкостью шарда
+ */
+void TicketStore::evict(Shard& s, uint64_t now, size_t limit)
+{
+    while (!s.order.empty() && (s.order.front().first <= now || s.entries.size() > limit || s.order.size() > 2 * capacity)) {
+        s.entries.erase(s.order.front().second);
+        s.order.pop_front();
+    }
+}
+
+/**
+ * @brief Выдача билета
+ * @param[in] login Логин аутентифицированного клиента
+ * @param[in] generation Номер загрузки базы пользователей
+ * @param[in] now Текущее время, мс
+ * @return Билет TICKET_SIZE байт
+ */
+std::string TicketStore::issue(const std::string& login, uint64_t generation, uint64_t now)
+{
+    uint64_t fields[2] = {nextId.fetch_add(1), now + ttl};
+    std::string ticket(TICKET_SIZE, '\0');
+    memcpy(&ticket[0], fields, sizeof(fields));
+    sign(ticket.data(), &ticket[sizeof(fields)]);
+
+    Shard& s = shards[fields[0] & (TICKET_SHARDS - 1)];
+    std::lock_guard<std::mutex> lock(s.mtx);
+    evict(s, now, capacity - 1);
+    s.entries[fields[0]] = Entry{login, fields[1], generation};
+    s.order.emplace_back(fields[1], fields[0]);
+    return ticket;
+}
+
+/**
+ * @brief Проверка и погашение билета
+ * @param[in] ticket Предъявленный билет
+ * @param[in] generation Номер действующей загрузки базы пользователей
+ * @param[in] now Текущее время, мс
+ * @param[out] login Логин, для которого выдан билет
+ * @return true если билет подлинный, не истёк и ещё не предъявлялся
+ * @details Код подлинности проверяется до захвата мьютекса шарда, поэтому
+ *          перебор билетов не создаёт конкуренции за кеш
+ */
+bool TicketStore::redeem(std::string_view ticket, uint64_t generation, uint64_t now, std::string& login)
+{
+    if (ticket.size() != TICKET_SIZE) {
+        return false;
+    }
+    uint64_t fields[2];
+    memcpy(fields, ticket.data(), sizeof(fields));
+    char mac[TICKET_MAC_SIZE];
+    sign(ticket.data(), mac);
+    if (!hashEquals(ticket.substr(sizeof(fields)), std::string_view(mac, TICKET_MAC_SIZE)) || fields[1] <= now) {
+        return false;
+    }
+
+    Shard& s = shards[fields[0] & (TICKET_SHARDS - 1)];
+    std::lock_guard<std::mutex> lock(s.mtx);
+    evict(s, now, capacity);
+    auto it = s.entries.find(fields[0]);
+    if (it == s.entries.end()) {
+        return false;
+    }
+    bool valid = it->second.generation == generation;
+    if (valid) {
+        login = std::move(it->second.login);
+    }
+    s.entries.erase(it);
+    return valid;
+}
+
+/**
+ * @brief Число билетов в кеше
+ * @return Количество записей, включая истёкшие, но ещё не удалённые
+ */
+size_t TicketStore::size()
+{
+    size_t n = 0;
+    for (Shard& s : shards) {
+        std::lock_guard<std::mutex> lock(s.mtx);
+        n += s.entries.size();
+    }
+    return n;
+}
+
+/**
+ * @brief Запуск выдачи билетов возобновления
+ * @param[in] ttl Срок действия билета, мс (0 — билеты не выдаются)
+ * @param[in] capacity Наибольшее число действующих билетов
+ */
+void startTickets(uint64_t ttl, size_t capacity)
+{
+    store.reset(ttl > 0 && capacity > 0 ? new TicketStore(ttl, capacity) : nullptr);
+}
+
+/**
+ * @brief Кеш билетов возобновления
+ * @return Кеш или nullptr, если билеты отключены
+ */
+TicketStore* ticketStore()
+{
+    return store.get();
+}
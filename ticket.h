@@ -0,0 +1,135 @@
+/**
+ * @file ticket.h
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл билетов возобновления сеанса
+ * @details Содержит выдачу и проверку билетов, которыми клиент протокола
+ *          версии 2 подтверждает прошлую аутентификацию при повторном
+ *          подключении вместо поиска пользователя и обмена солью и хешем
+ */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+/// Длина кода подлинности билета (HMAC-SHA256), байт
+#define TICKET_MAC_SIZE 32
+/// Длина билета: номер, срок действия и код подлинности, байт
+#define TICKET_SIZE (2 * sizeof(uint64_t) + TICKET_MAC_SIZE)
+/// Число шардов кеша билетов (степень двойки)
+#define TICKET_SHARDS 16
+
+/**
+ * @class TicketStore
+ * @brief Кеш выданных билетов возобновления
+ * @details Билет состоит из номера, срока действия и HMAC-SHA256 от них на
+ *          ключе, случайном для каждого запуска сервера, поэтому поддельный
+ *          или изменённый билет отклоняется без обращения к кешу. Логин
+ *          хранится только в кеше сервера. Билет одноразовый: предъявленный
+ *          билет удаляется, и клиент получает новый.
+ *
+ *          Кеш разделён на шарды со своими мьютексами по номеру билета.
+ *          Срок действия у всех билетов одинаковый, поэтому очередь выдачи
+ *          шарда упорядочена и по сроку: истёкшие билеты и, при заполнении
+ *          шарда, самые старые удаляются из её начала за O(1). Билеты,
+ *          выданные до перезагрузки базы пользователей, недействительны.
+ */
+class TicketStore
+{
+private:
+    /// Выданный билет
+    struct Entry {
+        std::string login;      ///< Логин клиента
+        uint64_t expires;       ///< Срок действия, мс monotonicMs
+        uint64_t generation;    ///< Номер загрузки базы пользователей
+    };
+
+    /// Шард кеша на отдельной линии кеша
+    struct alignas(64) Shard {
+        std::mutex mtx;                                     ///< Мьютекс шарда
+        std::unordered_map<uint64_t, Entry> entries;        ///< Действующие билеты по номеру
+        std::deque<std::pair<uint64_t, uint64_t>> order;    ///< Срок и номер в порядке выдачи
+    };
+
+    Shard shards[TICKET_SHARDS];    ///< Шарды кеша
+    unsigned char key[32];          ///< Ключ HMAC
+    std::atomic<uint64_t> nextId;   ///< Номер следующего билета
+    uint64_t ttl;                   ///< Срок действия билета, мс
+    size_t capacity;                ///< Наибольшее число билетов в шарде
+
+    /**
+     * @brief Вычисление кода подлинности
+     * @param[in] ticket Номер и срок действия (2 * sizeof(uint64_t) байт)
+     * @param[out] mac Буфер TICKET_MAC_SIZE байт
+     */
+    void sign(const char* ticket, char* mac) const;
+
+    /**
+     * @brief Удаление истёкших и вытесняемых билетов из начала очереди шарда
+     * @param[in,out] s Шард, мьютекс которого захвачен
+     * @param[in] now Текущее время, мс
+     * @param[in] limit Допустимое число билетов в шарде
+     */
+    void evict(Shard& s, uint64_t now, size_t limit);
+
+public:
+    /**
+     * @brief Конструктор кеша
+     * @param[in] ttl Срок действия билета, мс
+     * @param[in] capacity Наибольшее число действующих билетов
+     */
+    TicketStore(uint64_t ttl, size_t capacity);
+
+    TicketStore(const TicketStore&) = delete;
+    TicketStore& operator=(const TicketStore&) = delete;
+
+    /**
+     * @brief Выдача билета
+     * @param[in] login Логин аутентифицированного клиента
+     * @param[in] generation Номер загрузки базы пользователей
+     * @param[in] now Текущее время, мс
+     * @return Билет TICKET_SIZE байт
+     */
+    std::string issue(const std::string& login, uint64_t generation, uint64_t now);
+
+    /**
+     * @brief Проверка и погашение билета
+     * @param[in] ticket Предъявленный билет
+     * @param[in] generation Номер действующей загрузки базы пользователей
+     * @param[in] now Текущее время, мс
+     * @param[out] login Логин, для которого выдан билет
+     * @return true если билет подлинный, не истёк и ещё не предъявлялся
+     */
+    bool redeem(std::string_view ticket, uint64_t generation, uint64_t now, std::string& login);
+
+    /**
+     * @brief Число билетов в кеше
+     * @return Количество записей, включая истёкшие, но ещё не удалённые
+     */
+    size_t size();
+};
+
+/**
+ * @brief Запуск выдачи билетов возобновления
+ * @param[in] ttl Срок действия билета, мс (0 — билеты не выдаются)
+ * @param[in] capacity Наибольшее число действующих билетов
+ * @details Повторный вызов заменяет кеш; выданные ранее билеты перестают
+ *          действовать. Вызывается до начала обслуживания клиентов.
+ */
+void startTickets(uint64_t ttl, size_t capacity);
+
+/**
+ * @brief Кеш билетов возобновления
+ * @return Кеш или nullptr, если билеты отключены
+ */
+TicketStore* ticketStore();
@@ -0,0 +1,223 @@
+/**
+ * @file timeout.cpp
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация тайм-аутов соединений
+ */
+
+#include "timeout.h"
+#include <time.h>
+
+/**
+ * @brief Монотонное время
+ * @return Миллисекунды от произвольной точки отсчёта
+ * @details Грубые часы читаются без системного вызова; их точности в
+ *          несколько миллисекунд достаточно для делений колеса
+ */
+uint64_t monotonicMs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Тайм-аут текущей стадии
+ * @return Миллисекунды или 0, если не ограничен
+ */
+uint64_t Deadline::stageLimit() const
+{
+    switch (stage) {
+    case STAGE_LOGIN:
+        return p->LoginTimeout;
+    case STAGE_HASH:
+        return p->HashTimeout;
+    case STAGE_HEADER:
+        return p->HeaderTimeout;
+    case STAGE_ELEMENTS:
+        return p->VectorTimeout;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Отметка текущей стадии обмена
+ * @param[in] s Стадия
+ * @param[in] index Номер текущего вектора
+ * @param[in] now Текущее время, мс
+ */
+void Deadline::progress(Stage s, uint32_t index, uint64_t now)
+{
+    if (s != stage || index != vector) {
+        stage = s;
+        vector = index;
+        since = now;
+    }
+}
+
+/**
+ * @brief Ближайший срок
+ * @return Время закрытия соединения, мс, или 0, если сроков нет
+ */
+uint64_t Deadline::at() const
+{
+    uint64_t limit = stageLimit();
+    uint64_t result = limit > 0 ? since + limit : 0;
+    if (p->IdleTimeout > 0) {
+        uint64_t idle = active + p->IdleTimeout;
+        if (result == 0 || idle < result) {
+            result = idle;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Сообщение журнала об истечении срока
+ * @param[in] now Текущее время, мс
+ * @param[in] where Описание ожидаемых данных
+ * @return Строка для logError
+ */
+std::string Deadline::message(uint64_t now, const std::string& where) const
+{
+    if (p->IdleTimeout > 0 && now >= active + p->IdleTimeout) {
+        return "Тайм-аут простоя (" + where + "): нет обмена данными " + std::to_string(p->IdleTimeout) + " мс";
+    }
+    return "Тайм-аут (" + where + "): данные не получены за " + std::to_string(stageLimit()) + " мс";
+}
+
+/**
+ * @brief Период проверки сроков при блокирующем приёме
+ * @param[in] p Параметры сервера
+ * @return Наименьший ненулевой тайм-аут, мс, или 0
+ */
+uint64_t Deadline::period(const Params* p)
+{
+    uint64_t result = 0;
+    for (int limit : {p->LoginTimeout, p->HashTimeout, p->HeaderTimeout, p->VectorTimeout, p->IdleTimeout}) {
+        if (limit > 0 && (result == 0 || static_cast<uint64_t>(limit) < result)) {
+            result = limit;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Конструктор колеса
+ * @param[in] now Текущее время, мс
+ */
+TimerWheel::TimerWheel(uint64_t now) : slots(TIMER_SLOTS), current(now / TIMER_TICK_MS)
+{
+    for (TimerNode& head : slots) {
+        head.prev = head.next = &head;
+    }
+}
+
+/**
+ * @brief Удаление узла из списка деления
+ * @param[in] n Поставленный узел
+ */
+void TimerWheel::unlink(TimerNode* n)
+{
+    n->prev->next = n->next;
+    n->next->prev = n->prev;
+    n->prev = n->next = nullptr;
+    count--;
+}
+
+/**
+ * @brief Постановка или перестановка таймера
+ * @param[in] n Узел
+ * @param[in] when Время срабатывания, мс
+ * @details Просроченный таймер попадает в первое необработанное деление
+ */
+void TimerWheel::schedule(TimerNode* n, uint64_t when)
+{
+    if (n->armed()) {
+        unlink(n);
+    }
+    uint64_t tick = when / TIMER_TICK_MS;
+    if (tick < current) {
+        tick = current;
+    }
+    TimerNode* head = &slots[tick & (TIMER_SLOTS - 1)];
+    n->when = when;
+    n->prev = head->prev;
+    n->next = head;
+    head->prev->next = n;
+    head->prev = n;
+    count++;
+}
+
+/**
+ * @brief Постановка таймера не позже заданного времени
+ * @param[in] n Узел
+ * @param[in] when Время срабатывания, мс (0 — снять таймер)
+ */
+void TimerWheel::limit(TimerNode* n, uint64_t when)
+{
+    if (when == 0) {
+        cancel(n);
+    } else if (!n->armed() || when < n->when) {
+        schedule(n, when);
+    }
+}
+
+/**
+ * @brief Снятие таймера
+ * @param[in] n Узел (допускается не поставленный)
+ */
+void TimerWheel::cancel(TimerNode* n)
+{
+    if (n->armed()) {
+        unlink(n);
+    }
+}
+
+/**
+ * @brief Извлечение сработавших таймеров
+ * @param[in] now Текущее время, мс
+ * @param[out] due Сработавшие узлы, снятые с колеса
+ * @details Обрабатываются деления, завершившиеся к моменту now; после
+ *          долгого простоя потока колесо просматривается не более одного
+ *          оборота
+ */
+void TimerWheel::expire(uint64_t now, std::vector<TimerNode*>& due)
+{
+    uint64_t target = now / TIMER_TICK_MS;
+    if (target <= current) {
+        return;
+    }
+    uint64_t ticks = target - current < TIMER_SLOTS ? target - current : TIMER_SLOTS;
+    for (uint64_t i = 0; i < ticks && count > 0; i++) {
+        TimerNode* head = &slots[(current + i) & (TIMER_SLOTS - 1)];
+        TimerNode* n = head->next;
+        while (n != head) {
+            TimerNode* next = n->next;
+            // Узлы следующих оборотов остаются в делении
+            if (n->when / TIMER_TICK_MS < target) {
+                unlink(n);
+                due.push_back(n);
+            }
+            n = next;
+        }
+    }
+    current = target;
+}
+
+/**
+ * @brief Время до следующего прохода по колесу
+ * @param[in] now Текущее время, мс
+ * @return Миллисекунды для epoll_wait или -1, если таймеров нет
+ */
+int TimerWheel::timeout(uint64_t now) const
+{
+    if (count == 0) {
+        return -1;
+    }
+    uint64_t next = (current + 1) * TIMER_TICK_MS;
+    return next > now ? static_cast<int>(next - now) : 0;
+}
@@ -0,0 +1,215 @@
+/**
+ * @file timeout.h
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл тайм-аутов соединений
+ * @details Содержит сроки стадий обмена с клиентом (логин, хеш, заголовок
+ *          вектора, элементы вектора) и простоя, а также колесо таймеров,
+ *          которым событийные режимы сервера отслеживают эти сроки
+ *          для всех соединений потока
+ */
+
+#pragma once
+#include "interface.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// Длительность одного деления колеса таймеров, мс
+#define TIMER_TICK_MS 100
+/// Число делений колеса таймеров (степень двойки)
+#define TIMER_SLOTS 512
+
+/**
+ * @brief Монотонное время
+ * @return Миллисекунды от произвольной точки отсчёта
+ */
+uint64_t monotonicMs();
+
+/**
+ * @brief Ожидаемая от клиента часть обмена
+ */
+enum Stage {
+    STAGE_LOGIN,    ///< Логин
+    STAGE_HASH,     ///< Хеш пароля
+    STAGE_HEADER,   ///< Заголовок пакета или размер очередного вектора
+    STAGE_ELEMENTS, ///< Элементы вектора
+    STAGE_DONE      ///< Приём завершён, отправляется ответ
+};
+
+/**
+ * @class Deadline
+ * @brief Срок ожидания данных от клиента
+ * @details Каждая стадия обмена должна завершиться за свой тайм-аут с
+ *          момента её начала; стадии заголовка и элементов отсчитываются
+ *          заново для каждого вектора. Независимо от стадии соединение
+ *          закрывается, если в течение тайм-аута простоя не было ни приёма,
+ *          ни отправки данных. Нулевой тайм-аут отключает соответствующую
+ *          проверку. Медленный клиент, присылающий по байту, не продлевает
+ *          срок стадии.
+ */
+class Deadline
+{
+private:
+    const Params* p;             ///< Параметры сервера
+    Stage stage = STAGE_LOGIN;   ///< Текущая стадия
+    uint32_t vector = 0;         ///< Номер вектора стадии
+    uint64_t since;              ///< Начало стадии, мс
+    uint64_t active;             ///< Последний обмен данными, мс
+
+    /**
+     * @brief Тайм-аут текущей стадии
+     * @return Миллисекунды или 0, если не ограничен
+     */
+    uint64_t stageLimit() const;
+
+public:
+    /**
+     * @brief Конструктор срока нового соединения
+     * @param[in] p Параметры сервера
+     * @param[in] now Время приёма соединения, мс
+     */
+    Deadline(const Params* p, uint64_t now) : p(p), since(now), active(now) {}
+
+    /**
+     * @brief Отметка текущей стадии обмена
+     * @param[in] s Стадия
+     * @param[in] index Номер текущего вектора
+     * @param[in] now Текущее время, мс
+     * @details При смене стадии или вектора срок стадии отсчитывается заново
+     */
+    void progress(Stage s, uint32_t index, uint64_t now);
+
+    /**
+     * @brief Отметка обмена данными с клиентом
+     * @param[in] now Текущее время, мс
+     */
+    void touch(uint64_t now) {
+        active = now;
+    }
+
+    /**
+     * @brief Ближайший срок
+     * @return Время закрытия соединения, мс, или 0, если сроков нет
+     */
+    uint64_t at() const;
+
+    /**
+     * @brief Сообщение журнала об истечении срока
+     * @param[in] now Текущее время, мс
+     * @param[in] where Описание ожидаемых данных
+     * @return Строка для logError
+     */
+    std::string message(uint64_t now, const std::string& where) const;
+
+    /**
+     * @brief Период проверки сроков при блокирующем приёме
+     * @param[in] p Параметры сервера
+     * @return Наименьший ненулевой тайм-аут, мс, или 0
+     */
+    static uint64_t period(const Params* p);
+};
+
+/**
+ * @struct TimerNode
+ * @brief Узел колеса таймеров
+ * @details Встраивается в состояние соединения наследованием, поэтому
+ *          постановка и снятие таймера не выделяют память
+ */
+struct TimerNode {
+    TimerNode* prev = nullptr;   ///< Предыдущий узел деления
+    TimerNode* next = nullptr;   ///< Следующий узел деления
+    uint64_t when = 0;           ///< Время срабатывания, мс
+
+    /**
+     * @brief Признак поставленного таймера
+     * @return true если узел находится в колесе
+     */
+    bool armed() const {
+        return prev != nullptr;
+    }
+};
+
+/**
+ * @class TimerWheel
+ * @brief Колесо таймеров с делениями фиксированной длительности
+ * @details Узел помещается в деление, соответствующее времени срабатывания
+ *          по модулю длины колеса, поэтому постановка и снятие выполняются
+ *          за O(1) независимо от числа таймеров. Проход по колесу
+ *          просматривает только деления, время которых истекло; узлы
+ *          следующих оборотов остаются на месте. Таймер срабатывает не
+ *          раньше срока и не позже чем через одно деление после него.
+ *          Колесо принадлежит одному потоку и не синхронизируется.
+ */
+class TimerWheel
+{
+private:
+    std::vector<TimerNode> slots; ///< Заголовки кольцевых списков делений
+    uint64_t current;             ///< Номер первого необработанного деления
+    size_t count = 0;             ///< Число поставленных таймеров
+
+    /**
+     * @brief Удаление узла из списка деления
+     * @param[in] n Поставленный узел
+     */
+    void unlink(TimerNode* n);
+
+public:
+    /**
+     * @brief Конструктор колеса
+     * @param[in] now Текущее время, мс
+     */
+    explicit TimerWheel(uint64_t now);
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    /**
+     * @brief Постановка или перестановка таймера
+     * @param[in] n Узел
+     * @param[in] when Время срабатывания, мс
+     */
+    void schedule(TimerNode* n, uint64_t when);
+
+    /**
+     * @brief Постановка таймера не позже заданного времени
+     * @param[in] n Узел
+     * @param[in] when Время срабатывания, мс (0 — снять таймер)
+     * @details Уже поставленный более ранний таймер не переставляется:
+     *          при продлении срока обработчик срабатывания ставит узел
+     *          заново, поэтому частая активность клиента не перемещает
+     *          его по колесу
+     */
+    void limit(TimerNode* n, uint64_t when);
+
+    /**
+     * @brief Снятие таймера
+     * @param[in] n Узел (допускается не поставленный)
+     */
+    void cancel(TimerNode* n);
+
+    /**
+     * @brief Извлечение сработавших таймеров
+     * @param[in] now Текущее время, мс
+     * @param[out] due Сработавшие узлы, снятые с колеса
+     */
+    void expire(uint64_t now, std::vector<TimerNode*>& due);
+
+    /**
+     * @brief Время до следующего прохода по колесу
+     * @param[in] now Текущее время, мс
+     * @return Миллисекунды для epoll_wait или -1, если таймеров нет
+     */
+    int timeout(uint64_t now) const;
+
+    /**
+     * @brief Число поставленных таймеров
+     * @return Количество узлов в колесе
+     */
+    size_t size() const {
+        return count;
+    }
+};
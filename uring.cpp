@@ -0,0 +1,591 @@
+/**
+ * @file uring.cpp
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация режима сервера на io_uring
+ * @details На слушающем сокете и на каждом клиенте постоянно стоит
+ *          многократный запрос: accept выдаёт новые соединения, recv —
+ *          данные в буферы из общего кольца потока, которые возвращаются
+ *          в кольцо сразу после разбора. Данные передаются сеансу Session
+ *          с тем же декодером векторов, что и в datawrite. Ответы всех
+ *          клиентов, накопленные за один проход по очереди завершений,
+ *          отправляются одной передачей запросов в ядро.
+ *
+ *          Если клиент не успевает читать ответы, его запрос recv
+ *          отменяется и ставится снова, когда очередь ответа уменьшится.
+ *
+ *          Сроки стадий обмена и простоя отслеживаются колесом таймеров
+ *          потока; пока в нём есть таймеры, в кольце стоит запрос timeout
+ *          до следующего деления, который пробуждает поток для их проверки.
+ *
+ *          В кольце стоит ожидание события handoffEvent(): после передачи
+ *          сокета новому серверу или сигнала остановки accept отменяется,
+ *          и поток завершается с закрытием последнего своего соединения.
+ */
+
+#include "uring.h"
+#include "reactor.h"
+#include "log.h"
+
+#ifdef HAVE_LIBURING
+#include "admission.h"
+#include "handoff.h"
+#include "metrics.h"
+#include "session.h"
+#include "timeout.h"
+#include <cstring>
+#include <liburing.h>
+#include <memory>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/// Размер очереди запросов кольца
+#define URING_ENTRIES 1024
+/// Число буферов приёма в кольце потока (степень двойки)
+#define URING_BUFFERS 256
+/// Размер одного буфера приёма, байт
+#define URING_BUFFER_SIZE 32768
+/// Объём неотправленного ответа, при котором приём от клиента приостанавливается
+#define URING_OUT_LIMIT 65536
+/// Номер группы буферов приёма
+#define URING_GROUP 0
+
+namespace {
+
+/// Вид запроса в младших битах user_data
+enum Op : uint64_t {
+    OP_ACCEPT = 0,  ///< Приём соединений
+    OP_RECV = 1,    ///< Приём данных клиента
+    OP_SEND = 2,    ///< Отправка ответа клиенту
+    OP_CANCEL = 3,  ///< Отмена приёма
+    OP_TIMER = 4,   ///< Пробуждение для проверки сроков
+    OP_DRAIN = 5,   ///< Передача слушающего сокета новому серверу
+    OP_MASK = 7
+};
+
+/**
+ * @struct Client
+ * @brief Состояние соединения в кольце io_uring
+ * @details Клиент освобождается, только когда у него не осталось
+ *          запросов в ядре
+ */
+struct Client : TimerNode {
+    int fd;                     ///< Сокет клиента
+    Session session;            ///< Автомат протокола
+    Deadline deadline;          ///< Сроки стадий обмена и простоя
+    std::string pending;        ///< Непотреблённый сеансом остаток данных
+    std::string sending;        ///< Ответ, переданный запросу send
+    size_t sent = 0;            ///< Отправленная часть sending
+    bool recvArmed = false;     ///< Запрос recv стоит в ядре
+    bool sendInFlight = false;  ///< Запрос send стоит в ядре
+    bool cancelPosted = false;  ///< Отмена recv уже запрошена
+    bool eof = false;           ///< Клиент закрыл соединение на запись
+    bool closing = false;       ///< Соединение закрывается
+    bool shutDown = false;      ///< Выполнен shutdown для завершения recv
+    bool dirty = false;         ///< Клиент в списке на обработку после прохода
+
+    Client(int fd, const Params* p, const UserRegistry* users, uint32_t peer, uint64_t now)
+        : fd(fd), session(p, users, true, peer), deadline(p, now) {}
+};
+
+/**
+ * @class Worker
+ * @brief Поток сервера со своим кольцом io_uring и буферами приёма
+ */
+class Worker
+{
+    io_uring ring;                          ///< Кольцо запросов и завершений
+    io_uring_buf_ring* buffers = nullptr;   ///< Кольцо буферов приёма
+    std::vector<char> memory;               ///< Память буферов приёма
+    std::vector<Client*> dirty;             ///< Клиенты, изменившиеся за проход
+    std::vector<Client*> verifying;         ///< Клиенты, ожидающие проверки хеша
+    std::vector<Session*> sessions;         ///< Их сеансы для Session::verify
+    TimerWheel wheel;                       ///< Сроки соединений потока
+    std::vector<TimerNode*> due;            ///< Сработавшие таймеры прохода
+    __kernel_timespec timerSpec = {};       ///< Интервал запроса timeout
+    uint64_t now;                           ///< Время текущего прохода, мс
+    int s;                                  ///< Слушающий сокет
+    const Params* p;                        ///< Параметры сервера
+    const UserRegistry* users;              ///< Реестр базы пользователей
+    bool accepting = false;                 ///< Запрос accept стоит в ядре
+    int failure = 0;                        ///< Неустранимая ошибка слушающего сокета (errno)
+    bool timerArmed = false;                ///< Запрос timeout стоит в ядре
+    bool drainArmed = false;                ///< Ожидание прекращения приёма стоит в ядре
+    bool draining = false;                  ///< Приём прекращён
+    size_t clients = 0;                     ///< Открытые соединения потока
+
+public:
+    Worker(int s, const Params* p, const UserRegistry* users)
+        : wheel(monotonicMs()), now(monotonicMs()), s(s), p(p), users(users) {}
+
+    ~Worker() {
+        if (buffers) {
+            io_uring_free_buf_ring(&ring, buffers, URING_BUFFERS, URING_GROUP);
+            io_uring_queue_exit(&ring);
+        }
+    }
+
+    /**
+     * @brief Создание кольца и регистрация буферов приёма
+     * @param[out] error Описание ошибки
+     * @return false если ядро не поддерживает io_uring или кольца буферов
+     */
+    bool init(std::string& error) {
+        int rc = io_uring_queue_init(URING_ENTRIES, &ring, 0);
+        if (rc < 0) {
+            error = "io_uring_queue_init: " + std::string(strerror(-rc));
+            return false;
+        }
+        buffers = io_uring_setup_buf_ring(&ring, URING_BUFFERS, URING_GROUP, 0, &rc);
+        if (!buffers) {
+            error = "io_uring_setup_buf_ring: " + std::string(strerror(-rc));
+            io_uring_queue_exit(&ring);
+            return false;
+        }
+        memory.resize(static_cast<size_t>(URING_BUFFERS) * URING_BUFFER_SIZE);
+        for (unsigned short i = 0; i < URING_BUFFERS; i++) {
+            io_uring_buf_ring_add(buffers, memory.data() + static_cast<size_t>(i) * URING_BUFFER_SIZE,
+                                  URING_BUFFER_SIZE, i, io_uring_buf_ring_mask(URING_BUFFERS), i);
+        }
+        io_uring_buf_ring_advance(buffers, URING_BUFFERS);
+        return true;
+    }
+
+    /**
+     * @brief Цикл потока: ожидание завершений, разбор, отправка ответов
+     * @details После прекращения приёма (передача слушающего сокета новому
+     *          серверу или сигнал остановки) цикл завершается, когда закрыто
+     *          последнее соединение потока
+     */
+    void loop() {
+        while (true) {
+            if (!drainArmed && handoffEvent() != -1) {
+                armDrain();
+            }
+            if (!accepting && failure == 0 && !draining) {
+                armAccept();
+            }
+            if (!timerArmed && wheel.size() > 0) {
+                armTimer();
+            }
+            int rc = io_uring_submit_and_wait(&ring, 1);
+            if (rc < 0 && rc != -EINTR) {
+                logError(p->logFile, "Ошибка io_uring_enter: " + std::string(strerror(-rc)));
+                return;
+            }
+            now = monotonicMs();
+
+            unsigned head;
+            unsigned count = 0;
+            io_uring_cqe* cqe;
+            io_uring_for_each_cqe(&ring, head, cqe) {
+                uint64_t data = io_uring_cqe_get_data64(cqe);
+                Client* c = reinterpret_cast<Client*>(data & ~static_cast<uint64_t>(OP_MASK));
+                switch (data & OP_MASK) {
+                case OP_ACCEPT:
+                    onAccept(cqe);
+                    break;
+                case OP_RECV:
+                    onRecv(c, cqe);
+                    break;
+                case OP_SEND:
+                    onSend(c, cqe);
+                    break;
+                case OP_TIMER:
+                    timerArmed = false;
+                    break;
+                case OP_DRAIN:
+                    onDrain();
+                    break;
+                default:
+                    break;
+                }
+                count++;
+            }
+            io_uring_cq_advance(&ring, count);
+            verify();
+            reap();
+
+            // Запросы всех изменившихся клиентов уходят в ядро одним вызовом
+            for (Client* c : dirty) {
+                settle(c);
+            }
+            dirty.clear();
+            if ((draining || failure != 0) && !accepting && clients == 0) {
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief Неустранимая ошибка слушающего сокета
+     * @return errno ошибки accept, после которой приём прекращён, или 0
+     */
+    int error() const {
+        return failure;
+    }
+
+private:
+    /**
+     * @brief Свободный элемент очереди запросов
+     * @details При заполненной очереди накопленные запросы передаются ядру
+     */
+    io_uring_sqe* sqe() {
+        io_uring_sqe* e = io_uring_get_sqe(&ring);
+        while (!e) {
+            io_uring_submit(&ring);
+            e = io_uring_get_sqe(&ring);
+        }
+        return e;
+    }
+
+    /// Постановка многократного accept на слушающий сокет
+    void armAccept() {
+        io_uring_sqe* e = sqe();
+        io_uring_prep_multishot_accept(e, s, nullptr, nullptr, 0);
+        io_uring_sqe_set_data64(e, OP_ACCEPT);
+        accepting = true;
+    }
+
+    /// Ожидание события прекращения приёма
+    void armDrain() {
+        io_uring_sqe* e = sqe();
+        io_uring_prep_poll_add(e, handoffEvent(), POLLIN);
+        io_uring_sqe_set_data64(e, OP_DRAIN);
+        drainArmed = true;
+    }
+
+    /// Прекращение приёма: отмена accept, начатые сеансы завершаются
+    void onDrain() {
+        drainArmed = false;
+        if (!handoffDone() || draining) {
+            return;
+        }
+        draining = true;
+        if (accepting) {
+            io_uring_sqe* e = sqe();
+            io_uring_prep_cancel64(e, OP_ACCEPT, 0);
+            io_uring_sqe_set_data64(e, OP_CANCEL);
+        }
+    }
+
+    /// Постановка многократного recv с выбором буфера из кольца
+    void armRecv(Client* c) {
+        io_uring_sqe* e = sqe();
+        io_uring_prep_recv_multishot(e, c->fd, nullptr, 0, 0);
+        e->flags |= IOSQE_BUFFER_SELECT;
+        e->buf_group = URING_GROUP;
+        io_uring_sqe_set_data64(e, reinterpret_cast<uint64_t>(c) | OP_RECV);
+        c->recvArmed = true;
+        c->cancelPosted = false;
+    }
+
+    /// Отправка неотправленной части ответа
+    void submitSend(Client* c) {
+        io_uring_sqe* e = sqe();
+        io_uring_prep_send(e, c->fd, c->sending.data() + c->sent, c->sending.size() - c->sent, MSG_NOSIGNAL);
+        io_uring_sqe_set_data64(e, reinterpret_cast<uint64_t>(c) | OP_SEND);
+        c->sendInFlight = true;
+    }
+
+    /// Постановка пробуждения к следующему делению колеса таймеров
+    void armTimer() {
+        int ms = wheel.timeout(monotonicMs());
+        timerSpec.tv_sec = ms / 1000;
+        timerSpec.tv_nsec = static_cast<long long>(ms % 1000) * 1000000;
+        io_uring_sqe* e = sqe();
+        io_uring_prep_timeout(e, &timerSpec, 0, 0);
+        io_uring_sqe_set_data64(e, OP_TIMER);
+        timerArmed = true;
+    }
+
+    /// Отмена recv клиента, не успевающего читать ответы
+    void cancelRecv(Client* c) {
+        io_uring_sqe* e = sqe();
+        io_uring_prep_cancel64(e, reinterpret_cast<uint64_t>(c) | OP_RECV, 0);
+        io_uring_sqe_set_data64(e, OP_CANCEL);
+        c->cancelPosted = true;
+    }
+
+    /// Добавление клиента в список на обработку после прохода
+    void mark(Client* c) {
+        if (!c->dirty) {
+            c->dirty = true;
+            dirty.push_back(c);
+        }
+    }
+
+    /**
+     * @brief Завершение accept
+     * @details Ошибки отдельного соединения не останавливают приём,
+     *          как в Connection::acceptClient. После неустранимой ошибки
+     *          слушающего сокета приём прекращается, а Uring::run
+     *          завершается исключением, когда закрыты соединения потока.
+     */
+    void onAccept(const io_uring_cqe* cqe) {
+        if (!(cqe->flags & IORING_CQE_F_MORE)) {
+            accepting = false;
+        }
+        if (cqe->res < 0) {
+            int err = -cqe->res;
+            if (err == ECANCELED && draining) {
+                return;
+            }
+            logError(p->logFile, "Ошибка accept: " + std::string(strerror(err)));
+            if (err != EINTR && err != ECONNABORTED && err != EPROTO && err != EPERM &&
+                err != EMFILE && err != ENFILE && err != ENOBUFS && err != ENOMEM) {
+                failure = err;
+            }
+            return;
+        }
+        metricAdd(MET_ACCEPTED);
+        // Многократный accept не возвращает адрес клиента
+        sockaddr_in addr = {};
+        socklen_t len = sizeof(addr);
+        if (getpeername(cqe->res, reinterpret_cast<sockaddr*>(&addr), &len) == -1) {
+            // Клиент успел сбросить соединение; адрес 0.0.0.0 не должен учитываться при допуске
+            logError(p->logFile, "Ошибка getpeername: " + std::string(strerror(errno)));
+            close(cqe->res);
+            return;
+        }
+        if (!admitClient(cqe->res, addr.sin_addr.s_addr)) {
+            return;
+        }
+        clients++;
+        mark(new Client(cqe->res, p, users, addr.sin_addr.s_addr, now));
+    }
+
+    /// Завершение recv: разбор данных и возврат буфера в кольцо
+    void onRecv(Client* c, const io_uring_cqe* cqe) {
+        if (!(cqe->flags & IORING_CQE_F_MORE)) {
+            c->recvArmed = false;
+        }
+        if (cqe->flags & IORING_CQE_F_BUFFER) {
+            unsigned short bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+            char* data = memory.data() + static_cast<size_t>(bid) * URING_BUFFER_SIZE;
+            if (cqe->res > 0) {
+                metricAdd(MET_BYTES_IN, cqe->res);
+                c->deadline.touch(now);
+                consume(c, data, cqe->res);
+            }
+            io_uring_buf_ring_add(buffers, data, URING_BUFFER_SIZE, bid, io_uring_buf_ring_mask(URING_BUFFERS), 0);
+            io_uring_buf_ring_advance(buffers, 1);
+        }
+        if (cqe->res == 0 && !c->closing) {
+            c->session.onClose();
+            c->eof = true;
+        } else if (cqe->res < 0 && cqe->res != -ENOBUFS && cqe->res != -ECANCELED && !c->closing) {
+            logError(p->logFile, "Ошибка recv: " + std::string(strerror(-cqe->res)));
+            c->closing = true;
+        }
+        mark(c);
+    }
+
+    /// Завершение send: досылка остатка или освобождение буфера ответа
+    void onSend(Client* c, const io_uring_cqe* cqe) {
+        c->sendInFlight = false;
+        if (cqe->res < 0) {
+            if (!c->closing) {
+                logError(p->logFile, "Ошибка send: " + std::string(strerror(-cqe->res)));
+            }
+            c->closing = true;
+        } else {
+            metricAdd(MET_BYTES_OUT, cqe->res);
+            c->deadline.touch(now);
+            c->sent += cqe->res;
+            if (c->sent < c->sending.size()) {
+                submitSend(c);
+            } else {
+                c->sending.clear();
+                c->sent = 0;
+            }
+        }
+        mark(c);
+    }
+
+    /**
+     * @brief Передача принятых данных сеансу
+     * @details Неполное слово сохраняется в pending и дополняется
+     *          следующей порцией, как в реакторе epoll
+     */
+    void consume(Client* c, const char* data, size_t len) {
+        if (c->session.finished()) {
+            return; // Данные после завершения сеанса игнорируются
+        }
+        const char* buf = data;
+        size_t total = len;
+        if (!c->pending.empty()) {
+            c->pending.append(data, len);
+            buf = c->pending.data();
+            total = c->pending.size();
+        }
+        size_t pos = 0;
+        while (pos < total && !c->session.finished()) {
+            size_t used = c->session.onData(buf + pos, total - pos);
+            if (used == 0) {
+                break;
+            }
+            pos += used;
+        }
+        if (c->session.finished()) {
+            c->pending.clear();
+        } else if (buf == data) {
+            c->pending.assign(data + pos, total - pos);
+        } else {
+            c->pending.erase(0, pos);
+        }
+    }
+
+    /**
+     * @brief Пакетная проверка хешей, принятых за проход
+     * @details Данные, пришедшие вместе с хешем, передаются сеансу сразу
+     *          после проверки
+     */
+    void verify() {
+        verifying.clear();
+        sessions.clear();
+        for (Client* c : dirty) {
+            if (!c->closing && c->session.state() == Session::VERIFY) {
+                verifying.push_back(c);
+                sessions.push_back(&c->session);
+            }
+        }
+        if (sessions.empty()) {
+            return;
+        }
+        Session::verify(sessions);
+        for (Client* c : verifying) {
+            std::string rest;
+            rest.swap(c->pending);
+            consume(c, rest.data(), rest.size());
+        }
+    }
+
+    /**
+     * @brief Закрытие соединений с истёкшим сроком
+     * @details Таймер продлённого после постановки срока ставится заново;
+     *          просроченный клиент закрывается в settle
+     */
+    void reap() {
+        wheel.expire(now, due);
+        for (TimerNode* node : due) {
+            Client* c = static_cast<Client*>(node);
+            uint64_t at = c->deadline.at();
+            if (at == 0 || at > now) {
+                wheel.limit(c, at);
+                continue;
+            }
+            metricAdd(MET_TIMEOUTS);
+            logError(p->logFile, c->deadline.message(now, c->session.where()));
+            c->closing = true;
+            mark(c);
+        }
+        due.clear();
+    }
+
+    /**
+     * @brief Постановка запросов клиента после прохода по завершениям
+     * @details Отправляет накопленный ответ, приостанавливает или
+     *          возобновляет приём и закрывает соединение, когда у клиента
+     *          не осталось запросов в ядре
+     */
+    void settle(Client* c) {
+        c->dirty = false;
+        if (!c->closing && !c->sendInFlight) {
+            if (!c->session.out.empty()) {
+                c->sending.swap(c->session.out);
+                c->session.out.clear();
+                submitSend(c);
+            } else if (c->session.finished() || c->eof) {
+                c->closing = true;
+            }
+        }
+
+        if (c->closing) {
+            wheel.cancel(c);
+            if (c->sendInFlight) {
+                return;
+            }
+            if (c->recvArmed) {
+                // shutdown завершает стоящий recv, после чего клиент освобождается
+                if (!c->shutDown) {
+                    shutdown(c->fd, SHUT_RDWR);
+                    c->shutDown = true;
+                }
+                return;
+            }
+            close(c->fd);
+            delete c;
+            clients--;
+            releaseClient();
+            return;
+        }
+
+        size_t queued = c->session.out.size() + c->sending.size() - c->sent;
+        if (c->recvArmed) {
+            if (queued >= URING_OUT_LIMIT && !c->cancelPosted) {
+                cancelRecv(c);
+            }
+        } else if (queued < URING_OUT_LIMIT && !c->eof && !c->session.finished()) {
+            armRecv(c);
+        }
+        c->deadline.progress(c->session.stage(), c->session.vector(), now);
+        wheel.limit(c, c->deadline.at());
+    }
+};
+
+} // namespace
+#endif
+
+/**
+ * @brief Запуск сервера io_uring на слушающем сокете
+ * @param[in] s Дескриптор слушающего сокета
+ * @param[in] p Параметры сервера
+ * @param[in] users Реестр базы пользователей
+ * @param[in] threads Число потоков
+ * @return 0 после прекращения приёма и завершения сеансов
+ * @throw std::system_error при неустранимой ошибке слушающего сокета
+ *        или ошибках реактора epoll в резервном режиме
+ */
+int Uring::run(int s, const Params* p, const UserRegistry* users, size_t threads)
+{
+#ifdef HAVE_LIBURING
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (size_t i = 0; i < threads; i++) {
+        std::unique_ptr<Worker> w(new Worker(s, p, users));
+        std::string error;
+        if (!w->init(error)) {
+            logError(p->logFile, "io_uring недоступен (" + error + "), используется режим epoll");
+            if (workers.empty()) {
+                return Reactor::run(s, p, users, threads);
+            }
+            break;
+        }
+        workers.push_back(std::move(w));
+    }
+
+    std::vector<std::thread> loops;
+    for (auto& w : workers) {
+        loops.emplace_back(&Worker::loop, w.get());
+    }
+    for (auto& t : loops) {
+        t.join();
+    }
+    for (auto& w : workers) {
+        if (w->error() != 0) {
+            throw std::system_error(w->error(), std::generic_category());
+        }
+    }
+    return 0;
+#else
+    logError(p->logFile, "Сервер собран без liburing, используется режим epoll");
+    return Reactor::run(s, p, users, threads);
+#endif
+}
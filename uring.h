@@ -0,0 +1,41 @@
+/**
+ * @file uring.h
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл режима сервера на io_uring
+ * @details Содержит объявление сервера, принимающего соединения и данные
+ *          клиентов многократными (multishot) запросами io_uring с общим
+ *          кольцом буферов, без отдельного системного вызова на каждое
+ *          чтение и отправку
+ */
+
+#pragma once
+#include "interface.h"
+#include "userbase.h"
+
+/**
+ * @class Uring
+ * @brief Сервер на io_uring
+ * @details Каждый поток владеет собственным кольцом io_uring, сам принимает
+ *          соединения с общего слушающего сокета и ведёт клиентов автоматом
+ *          Session, как реактор epoll. Доступен при сборке с liburing
+ *          (make URING=1); иначе, а также если ядро не поддерживает нужные
+ *          возможности, сервер работает в режиме epoll.
+ */
+class Uring
+{
+public:
+    /**
+     * @brief Запуск сервера io_uring на слушающем сокете
+     * @param[in] s Дескриптор слушающего сокета
+     * @param[in] p Параметры сервера
+     * @param[in] users Реестр базы пользователей
+     * @param[in] threads Число потоков
+     * @return 0 после прекращения приёма и завершения сеансов
+     * @throw std::system_error при неустранимой ошибке слушающего сокета
+     *        или ошибках реактора epoll в резервном режиме
+     */
+    static int run(int s, const Params* p, const UserRegistry* users, size_t threads);
+};
@@ -0,0 +1,421 @@
+/**
+ * @file userbase.cpp
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация базы пользователей в памяти
+ */
+
+#include "userbase.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/// Минимальный размер блока арены строк
+#define ARENA_BLOCK_SIZE 65536
+/// Минимальный размер части файла для параллельного разбора
+#define LOAD_CHUNK_MIN (4 << 20)
+
+/**
+ * @brief Удаление пробелов и табуляций по краям строки
+ * @param[in] s Строка
+ * @return Подстрока без пробельных символов по краям
+ */
+static std::string_view trim(std::string_view s)
+{
+    size_t first = s.find_first_not_of(" \t");
+    if (first == std::string_view::npos) {
+        return std::string_view();
+    }
+    size_t last = s.find_last_not_of(" \t");
+    return s.substr(first, last - first + 1);
+}
+
+/**
+ * @brief Разбор строки файла базы пользователей
+ * @param[in] line Строка файла без символа перевода строки
+ * @param[out] user Логин
+ * @param[out] pass Пароль
+ * @return false для пустых строк, комментариев и строк без ':'
+ */
+bool parseUserLine(std::string_view line, std::string_view& user, std::string_view& pass)
+{
+    // Пропускаем пустые строки и комментарии
+    if (line.empty() || line[0] == '#' || line[0] == ';') {
+        return false;
+    }
+    size_t pos = line.find(':');
+    if (pos == std::string_view::npos) {
+        return false;
+    }
+    user = trim(line.substr(0, pos));
+    pass = trim(line.substr(pos + 1));
+    return true;
+}
+
+/**
+ * @brief Хеш логина
+ * @param[in] s Логин
+ * @return 64-битный хеш
+ */
+static inline uint64_t hashOf(std::string_view s)
+{
+    return std::hash<std::string_view>()(s);
+}
+
+/**
+ * @brief Копирование строки в арену
+ * @param[in] s Строка
+ * @return Указатель на копию
+ */
+const char* UserBase::intern(std::string_view s)
+{
+    if (blocks.empty() || blockSize - blockUsed < s.size()) {
+        blockSize = s.size() > ARENA_BLOCK_SIZE ? s.size() : ARENA_BLOCK_SIZE;
+        blocks.emplace_back(new char[blockSize]);
+        blockUsed = 0;
+    }
+    char* dst = blocks.back().get() + blockUsed;
+    memcpy(dst, s.data(), s.size());
+    blockUsed += s.size();
+    return dst;
+}
+
+/**
+ * @brief Увеличение таблицы с перераспределением записей
+ * @param[in] capacity Новый размер таблицы (степень двойки)
+ */
+void UserBase::rehash(size_t capacity)
+{
+    std::vector<Slot> old;
+    old.swap(table);
+    table.resize(capacity);
+    size_t mask = table.size() - 1;
+    for (const Slot& slot : old) {
+        if (slot.user == nullptr) {
+            continue;
+        }
+        size_t i = slot.hash & mask;
+        while (table[i].user != nullptr) {
+            i = (i + 1) & mask;
+        }
+        table[i] = slot;
+    }
+}
+
+/**
+ * @brief Резервирование места под заданное число пользователей
+ * @param[in] n Ожидаемое количество записей
+ */
+void UserBase::reserve(size_t n)
+{
+    size_t capacity = table.empty() ? 1024 : table.size();
+    while (capacity < n * 2) {
+        capacity *= 2;
+    }
+    if (capacity != table.size()) {
+        rehash(capacity);
+    }
+}
+
+/**
+ * @brief Удаление всех записей
+ */
+void UserBase::clear()
+{
+    table.clear();
+    blocks.clear();
+    count = 0;
+    blockUsed = blockSize = 0;
+}
+
+/**
+ * @brief Добавление пользователя
+ * @param[in] user Логин
+ * @param[in] pass Пароль
+ * @return false если логин уже есть в базе
+ */
+bool UserBase::insert(std::string_view user, std::string_view pass)
+{
+    return insert(user, pass, hashOf(user));
+}
+
+/**
+ * @brief Добавление пользователя с заранее вычисленным хешем
+ * @param[in] user Логин
+ * @param[in] pass Пароль
+ * @param[in] hash Хеш логина
+ * @return false если логин уже есть в базе
+ */
+bool UserBase::insert(std::string_view user, std::string_view pass, uint64_t hash)
+{
+    if ((count + 1) * 2 > table.size()) {
+        rehash(table.empty() ? 1024 : table.size() * 2);
+    }
+    size_t mask = table.size() - 1;
+    size_t i = hash & mask;
+    while (table[i].user != nullptr) {
+        if (table[i].hash == hash && std::string_view(table[i].user, table[i].userLen) == user) {
+            return false; // Действует первая запись файла
+        }
+        i = (i + 1) & mask;
+    }
+    Slot& slot = table[i];
+    slot.hash = hash;
+    // Пустой логин тоже должен занимать ячейку, поэтому указатель не может быть nullptr
+    slot.user = user.empty() ? "" : intern(user);
+    slot.userLen = static_cast<uint32_t>(user.size());
+    slot.pass = intern(pass);
+    slot.passLen = static_cast<uint32_t>(pass.size());
+    count++;
+    return true;
+}
+
+/**
+ * @brief Поиск пароля пользователя
+ * @param[in] username Логин
+ * @param[out] password Пароль найденного пользователя
+ * @return true если пользователь найден
+ */
+bool UserBase::find(std::string_view username, std::string& password) const
+{
+    if (table.empty()) {
+        return false;
+    }
+    uint64_t hash = hashOf(username);
+    size_t mask = table.size() - 1;
+    for (size_t i = hash & mask; table[i].user != nullptr; i = (i + 1) & mask) {
+        if (table[i].hash == hash && std::string_view(table[i].user, table[i].userLen) == username) {
+            password.assign(table[i].pass, table[i].passLen);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Загрузка базы из файла построчным чтением std::getline
+ * @param[in] filename Путь к файлу базы
+ * @return false если файл не удалось открыть
+ */
+bool UserBase::loadStream(const std::string& filename)
+{
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        return false;
+    }
+    clear();
+
+    std::string line;
+    std::string_view user, pass;
+    while (std::getline(file, line)) {
+        if (parseUserLine(line, user, pass)) {
+            insert(user, pass);
+        }
+    }
+    return true;
+}
+
+/**
+ * @struct ParsedUser
+ * @brief Запись, найденная при разборе части файла
+ */
+struct ParsedUser {
+    std::string_view user;  ///< Логин внутри буфера файла
+    std::string_view pass;  ///< Пароль внутри буфера файла
+    uint64_t hash;          ///< Хеш логина
+};
+
+/**
+ * @brief Разбор части прочитанного файла
+ * @param[in] text Часть файла, начинающаяся с начала строки
+ * @param[out] out Найденные записи в порядке следования
+ */
+static void parseChunk(std::string_view text, std::vector<ParsedUser>& out)
+{
+    std::string_view user, pass;
+    while (!text.empty()) {
+        size_t eol = text.find('\n');
+        std::string_view line = text.substr(0, eol);
+        text.remove_prefix(eol == std::string_view::npos ? text.size() : eol + 1);
+        if (parseUserLine(line, user, pass)) {
+            out.push_back({user, pass, hashOf(user)});
+        }
+    }
+}
+
+/**
+ * @brief Загрузка базы из файла, прочитанного в память целиком
+ * @param[in] filename Путь к файлу базы
+ * @param[in] threads Число потоков разбора (0 — по числу ядер)
+ * @return false если файл не удалось открыть или прочитать
+ * @details Файл может быть переписан на месте во время перезагрузки.
+ *          Страницы отображения за новым концом файла вызвали бы SIGBUS
+ *          и завершили сервер, поэтому файл читается pread в буфер:
+ *          укороченный файл разбирается до прочитанного конца. Буфер
+ *          освобождается после загрузки, строки копируются в арену.
+ */
+bool UserBase::load(const std::string& filename, size_t threads)
+{
+    int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    std::unique_ptr<char[]> data(new char[size > 0 ? size : 1]);
+    size_t got = 0;
+    while (got < size) {
+        ssize_t n = pread(fd, data.get() + got, size - got, got);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n == -1) {
+            close(fd);
+            return false;
+        }
+        if (n == 0) {
+            break; // Файл укорочен во время чтения
+        }
+        got += n;
+    }
+    close(fd);
+    clear();
+    size = got;
+    if (size == 0) {
+        return true;
+    }
+    std::string_view text(data.get(), size);
+
+    // Части не меньше LOAD_CHUNK_MIN, границы сдвигаются к началу следующей строки
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    size_t parts = size / LOAD_CHUNK_MIN;
+    if (parts > threads) {
+        parts = threads;
+    }
+    if (parts == 0) {
+        parts = 1;
+    }
+    std::vector<std::string_view> chunks;
+    size_t begin = 0;
+    for (size_t i = 1; i <= parts; i++) {
+        size_t end = size;
+        if (i < parts) {
+            size_t eol = text.find('\n', std::max(begin, size / parts * i));
+            end = eol == std::string_view::npos ? size : eol + 1;
+        }
+        if (end > begin) {
+            chunks.push_back(text.substr(begin, end - begin));
+        }
+        begin = end;
+    }
+
+    std::vector<std::vector<ParsedUser>> parsed(chunks.size());
+    if (chunks.size() == 1) {
+        parseChunk(chunks[0], parsed[0]);
+    } else {
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < chunks.size(); i++) {
+            workers.emplace_back(parseChunk, chunks[i], std::ref(parsed[i]));
+        }
+        for (auto& t : workers) {
+            t.join();
+        }
+    }
+
+    size_t total = 0;
+    for (const auto& part : parsed) {
+        total += part.size();
+    }
+    reserve(total);
+    for (const auto& part : parsed) {
+        for (const ParsedUser& u : part) {
+            insert(u.user, u.pass, u.hash);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Деструктор, освобождающий действующую базу
+ */
+UserRegistry::~UserRegistry()
+{
+    delete current.load();
+}
+
+/**
+ * @brief Регистрация читателя в текущей эпохе
+ * @return Эпоха, в которой зарегистрирован читатель
+ * @details Регистрация повторяется, если эпоха сменилась между чтением
+ *          её номера и увеличением счётчика
+ */
+uint64_t UserRegistry::enter() const
+{
+    while (true) {
+        uint64_t e = epoch.load();
+        readers[e & 1].count.fetch_add(1);
+        if (epoch.load() == e) {
+            return e;
+        }
+        readers[e & 1].count.fetch_sub(1);
+    }
+}
+
+/**
+ * @brief Поиск пароля пользователя в действующей базе
+ * @param[in] username Логин
+ * @param[out] password Пароль найденного пользователя
+ * @return true если пользователь найден
+ */
+bool UserRegistry::find(std::string_view username, std::string& password) const
+{
+    uint64_t e = enter();
+    const UserBase* base = current.load();
+    bool found = base != nullptr && base->find(username, password);
+    leave(e);
+    return found;
+}
+
+/**
+ * @brief Замена действующей базы
+ * @param[in] base Полностью построенная новая база
+ */
+void UserRegistry::publish(std::unique_ptr<UserBase> base)
+{
+    std::lock_guard<std::mutex> lock(writer);
+    UserBase* old = current.exchange(base.release());
+    // Новые читатели регистрируются в следующей эпохе и видят только новую базу
+    uint64_t e = epoch.fetch_add(1);
+    while (readers[e & 1].count.load() != 0) {
+        std::this_thread::yield();
+    }
+    delete old;
+}
+
+/**
+ * @brief Количество пользователей в действующей базе
+ * @return Число записей
+ */
+size_t UserRegistry::size() const
+{
+    uint64_t e = enter();
+    const UserBase* base = current.load();
+    size_t n = base != nullptr ? base->size() : 0;
+    leave(e);
+    return n;
+}
@@ -0,0 +1,221 @@
+/**
+ * @file userbase.h
+ * @author Веселов А.Н.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл базы пользователей в памяти
+ * @details Содержит индекс пользователей, загружаемый из файла базы один раз
+ *          при запуске сервера, с поиском пароля по логину за O(1)
+ */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Разбор строки файла базы пользователей
+ * @param[in] line Строка файла без символа перевода строки
+ * @param[out] user Логин (без пробелов и табуляций по краям)
+ * @param[out] pass Пароль (без пробелов и табуляций по краям)
+ * @return false для пустых строк, комментариев (# или ;) и строк без ':'
+ * @details Правила совпадают с findUserInFile; результаты указывают
+ *          внутрь line
+ */
+bool parseUserLine(std::string_view line, std::string_view& user, std::string_view& pass);
+
+/**
+ * @class UserBase
+ * @brief Хеш-индекс пользователей с открытой адресацией
+ * @details Логины и пароли копируются в арену крупными блоками, таблица
+ *          хранит только указатели на них. Линейное пробирование, таблица
+ *          заполняется не более чем наполовину. При повторе логина в файле
+ *          действует первая запись, как и при последовательном поиске.
+ *          После загрузки объект только читается и может использоваться
+ *          из нескольких потоков без синхронизации.
+ */
+class UserBase
+{
+private:
+    /// Ячейка хеш-таблицы
+    struct Slot {
+        uint64_t hash = 0;             ///< Хеш логина
+        const char* user = nullptr;    ///< Логин в арене (nullptr — ячейка свободна)
+        const char* pass = nullptr;    ///< Пароль в арене
+        uint32_t userLen = 0;          ///< Длина логина
+        uint32_t passLen = 0;          ///< Длина пароля
+    };
+
+    std::vector<Slot> table;                        ///< Таблица (размер — степень двойки)
+    size_t count = 0;                               ///< Количество пользователей
+    std::vector<std::unique_ptr<char[]>> blocks;    ///< Блоки арены строк
+    size_t blockUsed = 0;                           ///< Занято в последнем блоке
+    size_t blockSize = 0;                           ///< Размер последнего блока
+
+    /**
+     * @brief Копирование строки в арену
+     * @param[in] s Строка
+     * @return Указатель на копию
+     */
+    const char* intern(std::string_view s);
+
+    /**
+     * @brief Увеличение таблицы с перераспределением записей
+     * @param[in] capacity Новый размер таблицы (степень двойки)
+     */
+    void rehash(size_t capacity);
+
+    /**
+     * @brief Удаление всех записей
+     */
+    void clear();
+
+    /**
+     * @brief Добавление пользователя с заранее вычисленным хешем
+     * @param[in] user Логин
+     * @param[in] pass Пароль
+     * @param[in] hash Хеш логина
+     * @return false если логин уже есть в базе
+     */
+    bool insert(std::string_view user, std::string_view pass, uint64_t hash);
+
+public:
+    /**
+     * @brief Загрузка базы из файла, прочитанного в память целиком
+     * @param[in] filename Путь к файлу базы
+     * @param[in] threads Число потоков разбора (0 — по числу ядер)
+     * @return false если файл не удалось открыть или прочитать
+     * @details Файл читается одним буфером, строки разбираются на месте
+     *          внутри него, без копирования каждой строки в std::string.
+     *          Отображение файла не используется: файл, укороченный во
+     *          время перезагрузки, вызвал бы SIGBUS. Крупный файл
+     *          делится на части по границам строк, которые разбираются
+     *          параллельно; записи добавляются в порядке файла.
+     *          Предыдущее содержимое индекса удаляется.
+     */
+    bool load(const std::string& filename, size_t threads = 1);
+
+    /**
+     * @brief Загрузка базы из файла построчным чтением std::getline
+     * @param[in] filename Путь к файлу базы
+     * @return false если файл не удалось открыть
+     * @details Прежний способ загрузки; оставлен для сравнения
+     *          в тесте производительности
+     */
+    bool loadStream(const std::string& filename);
+
+    /**
+     * @brief Резервирование места под заданное число пользователей
+     * @param[in] n Ожидаемое количество записей
+     */
+    void reserve(size_t n);
+
+    /**
+     * @brief Добавление пользователя
+     * @param[in] user Логин
+     * @param[in] pass Пароль
+     * @return false если логин уже есть в базе (запись не изменяется)
+     */
+    bool insert(std::string_view user, std::string_view pass);
+
+    /**
+     * @brief Поиск пароля пользователя
+     * @param[in] username Логин
+     * @param[out] password Пароль найденного пользователя
+     * @return true если пользователь найден
+     */
+    bool find(std::string_view username, std::string& password) const;
+
+    /**
+     * @brief Количество пользователей в базе
+     * @return Число записей
+     */
+    size_t size() const {
+        return count;
+    }
+};
+
+
+/**
+ * @class UserRegistry
+ * @brief Текущая база пользователей с атомарной заменой
+ * @details Читатели не берут блокировок: поиск регистрируется в счётчике
+ *          текущей эпохи и читает указатель на базу. Замена публикует новую
+ *          базу атомарной записью указателя, переключает эпоху и удаляет
+ *          старую базу, когда счётчик прошлой эпохи обнулится (схема RCU).
+ *          Поэтому входящие логины никогда не видят частично построенную
+ *          таблицу и не ждут перезагрузки.
+ */
+class UserRegistry
+{
+private:
+    /// Счётчик читателей эпохи на отдельной линии кеша
+    struct alignas(64) Readers {
+        std::atomic<long> count{0};
+    };
+
+    std::atomic<UserBase*> current{nullptr};   ///< Действующая база
+    std::atomic<uint64_t> epoch{0};            ///< Номер эпохи
+    mutable Readers readers[2];                ///< Читатели чётной и нечётной эпох
+    std::mutex writer;                         ///< Последовательность замен
+
+    /**
+     * @brief Регистрация читателя в текущей эпохе
+     * @return Эпоха, в которой зарегистрирован читатель
+     */
+    uint64_t enter() const;
+
+    /**
+     * @brief Снятие регистрации читателя
+     * @param[in] e Эпоха, полученная от enter()
+     */
+    void leave(uint64_t e) const {
+        readers[e & 1].count.fetch_sub(1);
+    }
+
+public:
+    UserRegistry() = default;
+    UserRegistry(const UserRegistry&) = delete;
+    UserRegistry& operator=(const UserRegistry&) = delete;
+
+    /**
+     * @brief Деструктор, освобождающий действующую базу
+     */
+    ~UserRegistry();
+
+    /**
+     * @brief Поиск пароля пользователя в действующей базе
+     * @param[in] username Логин
+     * @param[out] password Пароль найденного пользователя
+     * @return true если пользователь найден
+     */
+    bool find(std::string_view username, std::string& password) const;
+
+    /**
+     * @brief Замена действующей базы
+     * @param[in] base Полностью построенная новая база
+     * @details Возвращает управление после освобождения старой базы,
+     *          то есть после завершения всех начатых с ней поисков
+     */
+    void publish(std::unique_ptr<UserBase> base);
+
+    /**
+     * @brief Количество пользователей в действующей базе
+     * @return Число записей
+     */
+    size_t size() const;
+
+    /**
+     * @brief Номер загрузки действующей базы
+     * @return Число выполненных замен базы
+     */
+    uint64_t generation() const {
+        return epoch.load();
+    }
+};